@@ -8,15 +8,21 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <sstream>
+#include <iomanip>
 #include <iostream>
+#include <tiny_gltf.h>
 #include <utils/init_glfw_glad.h>
 #include <utils/camera.h>
 #include <scene/scene.h>
+#include <render/program_cache.h>
+#include <utils/vfs.h>
+#include <utils/job_system.h>
 
 static void key_callback(GLFWwindow *window, int key, int scancode, int action, int mode);
 static void mouse_callback(GLFWwindow *window, int button, int action, int mods);
 static void cursor_position_callback(GLFWwindow *window, double xpos, double ypos);
 static void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
+static void pickBuilding(double xpos, double ypos);
 
 static bool isMousePressed = false;
 static double lastMouseX, lastMouseY;
@@ -70,14 +76,23 @@ int main(void)
 	glEnable(GL_DEPTH_TEST);
 	glEnable(GL_CULL_FACE);
 
-	// Scene setup
-	cityScene.setupLighting();
-	cityScene.initializeAxis();
-	cityScene.initializeTerrain(4000, 4000, 30.0f);
-	cityScene.initializeCitiesOnHills(100);
-	cityScene.initializeForest(cityScene.terrain, 3000);
-	cityScene.initializeCars(200);
-	cityScene.initializeBirds(400);
+	// Assets come from the packed world when it has been built, loose files otherwise
+	vfs.mount("world.fepak");
+
+	// Shaders, with linked binaries kept next to the executable between runs
+	programCache.initialize("shader_cache");
+	cityScene.precompileShaders();
+
+	// Worker threads for scene setup and the simulation
+	jobSystem.start();
+
+	// Scene setup. Terrain and sky are ready before the first frame, the
+	// rest is loaded in the background and appears as it finishes.
+	SceneSettings settings;
+	cityScene.initialize(settings);
+
+	// Cars and birds move on the simulation thread from here on
+	cityScene.startSimulation();
 
 	// Animations
 	double lastTime = glfwGetTime();
@@ -86,19 +101,23 @@ int main(void)
 	int frames = 0;
 	double fTime = 0.0;
 
-	// Skybox
-	glm::vec3 skyboxPosition(0.0f, 0.0f, 0.0f);
-	glm::vec3 skyboxScale(3000.0f, 3000.0f, 3000.0f);
-	cityScene.initializeSkybox(skyboxPosition, skyboxScale);
+	// GL-side share of asset loading per frame (seconds)
+	const double loadBudget = 0.004;
+	bool firstFrame = true;
 
 	do {
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		cityScene.loader.pump(loadBudget);
 
-		glm::mat4 viewMatrix = activeCamera->getViewMatrix();
-		glm::mat4 projectionMatrix = activeCamera->getProjectionMatrix();
-		glm::mat4 vp = projectionMatrix * viewMatrix;
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		glm::vec3 cameraPosition = activeCamera->getPosition();
+		// The simulation picks this up for the packet after the one it is on
+		FrameInput input;
+		input.view = activeCamera->getViewMatrix();
+		input.projection = activeCamera->getProjectionMatrix();
+		input.vp = input.projection * input.view;
+		input.cameraPosition = activeCamera->getPosition();
+		input.lightPosition = cityScene.lightPosition;
+		cityScene.pipeline.setInput(input);
 
 		// Delta time
 		double currentTime = glfwGetTime();
@@ -113,20 +132,37 @@ int main(void)
 			frames = 0;
 			fTime = 0.0;
 
+			JobStats jobs = jobSystem.collectStats();
+			const RenderStats& renderStats = cityScene.renderQueue.getStats();
+
 			std::stringstream stream;
-			stream << std::fixed << std::setprecision(2) << "Futuristic Emerald Isle | FPS: " << fps;
+			stream << std::fixed << std::setprecision(2) << "Futuristic Emerald Isle | FPS: " << fps
+				   << std::setprecision(0) << " | Workers: " << jobs.utilization() * 100.0 << "% of " << jobs.busy.size()
+				   << " busy, " << jobs.jobs / jobs.seconds << " jobs/s"
+				   << " | Binds: " << renderStats.binds() << " (" << renderStats.skips() << " saved) for " << renderStats.items << " draws";
 			glfwSetWindowTitle(window, stream.str().c_str());
 		}
 
-		cityScene.render(vp, cameraPosition, deltaTime);
+		// Draw the newest packet, simulated while the last frame was submitted
+		const FramePacket* packet = cityScene.pipeline.acquire();
+		if (packet) {
+			cityScene.render(*packet);
+		}
 
 		glfwSwapBuffers(window);
 		glfwPollEvents();
 
+		if (firstFrame) {
+			std::cout << "First frame after " << std::fixed << std::setprecision(1) << glfwGetTime() * 1000.0 << " ms" << std::endl;
+			firstFrame = false;
+		}
+
 	} while (!glfwWindowShouldClose(window));
 
 	// Clean up
 	cityScene.cleanup();
+	jobSystem.stop();
+	vfs.unmount();
 
 	// Close OpenGL window and terminate GLFW
 	glfwTerminate();
@@ -143,6 +179,32 @@ void mouse_callback(GLFWwindow* window, int button, int action, int mods)
 		} else if (action == GLFW_RELEASE) {
 			isMousePressed = false;
 		}
+	} else if (button == GLFW_MOUSE_BUTTON_RIGHT && action == GLFW_PRESS) {
+		double xpos, ypos;
+		glfwGetCursorPos(window, &xpos, &ypos);
+		pickBuilding(xpos, ypos);
+	}
+}
+
+// Reports the building under the cursor, found through the buildings' BVH
+void pickBuilding(double xpos, double ypos) {
+	float x = static_cast<float>(2.0 * xpos / windowWidth - 1.0);
+	float y = static_cast<float>(1.0 - 2.0 * ypos / windowHeight);
+	glm::mat4 inverseVP = glm::inverse(activeCamera->getProjectionMatrix() * activeCamera->getViewMatrix());
+	glm::vec4 nearPoint = inverseVP * glm::vec4(x, y, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseVP * glm::vec4(x, y, 1.0f, 1.0f);
+
+	Ray ray;
+	ray.origin = glm::vec3(nearPoint) / nearPoint.w;
+	ray.direction = glm::vec3(farPoint) / farPoint.w - ray.origin;
+	ray.maxDistance = 1.0f;
+
+	Aabb hit;
+	if (cityScene.buildingBatch.pick(ray, hit)) {
+		glm::vec3 center = (hit.min + hit.max) * 0.5f;
+		std::cout << "Building at " << center.x << ", " << center.y << ", " << center.z << std::endl;
+	} else {
+		std::cout << "No building under the cursor" << std::endl;
 	}
 }
 
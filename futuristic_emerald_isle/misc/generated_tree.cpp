@@ -83,5 +83,4 @@ void GeneratedTree::cleanup() {
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
     glDeleteVertexArrays(1, &vao);
-    glDeleteProgram(programID);
 }
\ No newline at end of file
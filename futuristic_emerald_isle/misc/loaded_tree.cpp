@@ -97,6 +97,5 @@ void LoadedTree::cleanup() {
     glDeleteBuffers(1, &vbo);
     glDeleteBuffers(1, &ebo);
     glDeleteVertexArrays(1, &vao);
-    glDeleteProgram(programID);
     glDeleteTextures(1, &textureID);
 }
\ No newline at end of file
@@ -0,0 +1,171 @@
+#include "animation.h"
+#include <utils/cooked_mesh_format.h>
+#include <glm/gtc/quaternion.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Same keyframe lookup the birds used to do every frame, kept so the baked
+// tables reproduce the original motion exactly at the sample points
+void findKeys(const Mesh::AnimationChannel& channel, float time, int& prevIdx, int& nextIdx, float& t) {
+    const float* times = channel.times.data();
+    prevIdx = 0;
+    nextIdx = 0;
+    for (size_t i = 0; i + 1 < channel.times.size(); ++i) {
+        if (time >= times[i] && time < times[i + 1]) {
+            prevIdx = static_cast<int>(i);
+            nextIdx = static_cast<int>(i + 1);
+            break;
+        }
+    }
+
+    float span = times[nextIdx] - times[prevIdx];
+    t = span > 0.0f ? (time - times[prevIdx]) / span : 0.0f;
+}
+
+glm::vec3 sampleVec3(const Mesh::AnimationChannel& channel, float time) {
+    int prevIdx, nextIdx;
+    float t;
+    findKeys(channel, time, prevIdx, nextIdx, t);
+    const float* values = channel.values.data();
+    glm::vec3 prev(values[prevIdx * 3 + 0], values[prevIdx * 3 + 1], values[prevIdx * 3 + 2]);
+    glm::vec3 next(values[nextIdx * 3 + 0], values[nextIdx * 3 + 1], values[nextIdx * 3 + 2]);
+    return glm::mix(prev, next, t);
+}
+
+glm::vec3 sampleEuler(const Mesh::AnimationChannel& channel, float time) {
+    int prevIdx, nextIdx;
+    float t;
+    findKeys(channel, time, prevIdx, nextIdx, t);
+    const float* values = channel.values.data();
+    glm::quat prev(values[prevIdx * 4 + 3], values[prevIdx * 4 + 0], values[prevIdx * 4 + 1], values[prevIdx * 4 + 2]);
+    glm::quat next(values[nextIdx * 4 + 3], values[nextIdx * 4 + 0], values[nextIdx * 4 + 1], values[nextIdx * 4 + 2]);
+    return glm::degrees(glm::eulerAngles(glm::slerp(prev, next, t)));
+}
+
+// Moves angle by whole turns so it is within 180 degrees of previous, which
+// makes a straight lerp between neighbouring samples take the short way round
+float unwrapDegrees(float angle, float previous) {
+    return angle - 360.0f * std::round((angle - previous) / 360.0f);
+}
+
+}
+
+BakedAnimation::BakedAnimation() : duration(0.0f), framesPerSecond(0.0f), frameCount(0), tracks(0) {}
+
+bool BakedAnimation::bake(const Mesh::Animation& animation, float sampleRate) {
+    clear();
+    if (animation.duration <= 0.0f || sampleRate <= 0.0f) {
+        return false;
+    }
+
+    for (const auto& channel : animation.channels) {
+        if (channel.times.empty()) {
+            continue;
+        }
+        size_t keys = channel.times.size();
+        if (channel.path == COOKED_PATH_TRANSLATION && channel.values.size() >= keys * 3) {
+            tracks |= TRACK_TRANSLATION;
+        } else if (channel.path == COOKED_PATH_ROTATION && channel.values.size() >= keys * 4) {
+            tracks |= TRACK_ROTATION;
+        } else if (channel.path == COOKED_PATH_SCALE && channel.values.size() >= keys * 3) {
+            tracks |= TRACK_SCALE;
+        }
+    }
+    if (tracks == 0) {
+        return false;
+    }
+
+    // Whole number of frames, so the last sample lands exactly on duration
+    frameCount = std::max(1, static_cast<int>(std::ceil(animation.duration * sampleRate)));
+    duration = animation.duration;
+    framesPerSecond = frameCount / duration;
+
+    size_t samples = frameCount + 1;
+    if (tracks & TRACK_TRANSLATION) {
+        translationX.resize(samples); translationY.resize(samples); translationZ.resize(samples);
+    }
+    if (tracks & TRACK_ROTATION) {
+        rotationX.resize(samples); rotationY.resize(samples); rotationZ.resize(samples);
+    }
+    if (tracks & TRACK_SCALE) {
+        scaleX.resize(samples); scaleY.resize(samples); scaleZ.resize(samples);
+    }
+
+    for (size_t frame = 0; frame < samples; ++frame) {
+        float time = frame / framesPerSecond;
+
+        // Later channels on the same path win, as they did when applied in order
+        for (const auto& channel : animation.channels) {
+            if (channel.times.empty()) {
+                continue;
+            }
+            size_t keys = channel.times.size();
+            if (channel.path == COOKED_PATH_TRANSLATION && channel.values.size() >= keys * 3) {
+                glm::vec3 v = sampleVec3(channel, time);
+                translationX[frame] = v.x; translationY[frame] = v.y; translationZ[frame] = v.z;
+            } else if (channel.path == COOKED_PATH_ROTATION && channel.values.size() >= keys * 4) {
+                glm::vec3 v = sampleEuler(channel, time);
+                if (frame > 0) {
+                    v.x = unwrapDegrees(v.x, rotationX[frame - 1]);
+                    v.y = unwrapDegrees(v.y, rotationY[frame - 1]);
+                    v.z = unwrapDegrees(v.z, rotationZ[frame - 1]);
+                }
+                rotationX[frame] = v.x; rotationY[frame] = v.y; rotationZ[frame] = v.z;
+            } else if (channel.path == COOKED_PATH_SCALE && channel.values.size() >= keys * 3) {
+                glm::vec3 v = sampleVec3(channel, time);
+                scaleX[frame] = v.x; scaleY[frame] = v.y; scaleZ[frame] = v.z;
+            }
+        }
+    }
+    return true;
+}
+
+void BakedAnimation::clear() {
+    duration = 0.0f;
+    framesPerSecond = 0.0f;
+    frameCount = 0;
+    tracks = 0;
+    translationX.clear(); translationY.clear(); translationZ.clear();
+    rotationX.clear(); rotationY.clear(); rotationZ.clear();
+    scaleX.clear(); scaleY.clear(); scaleZ.clear();
+}
+
+void BakedAnimation::sample(float time, Pose& pose) const {
+    float f = glm::clamp(time * framesPerSecond, 0.0f, static_cast<float>(frameCount));
+    int i = std::min(static_cast<int>(f), frameCount - 1);
+    float t = f - i;
+
+    if (tracks & TRACK_TRANSLATION) {
+        pose.translation.x = translationX[i] + (translationX[i + 1] - translationX[i]) * t;
+        pose.translation.y = translationY[i] + (translationY[i + 1] - translationY[i]) * t;
+        pose.translation.z = translationZ[i] + (translationZ[i + 1] - translationZ[i]) * t;
+    }
+    if (tracks & TRACK_ROTATION) {
+        pose.rotation.x = rotationX[i] + (rotationX[i + 1] - rotationX[i]) * t;
+        pose.rotation.y = rotationY[i] + (rotationY[i + 1] - rotationY[i]) * t;
+        pose.rotation.z = rotationZ[i] + (rotationZ[i + 1] - rotationZ[i]) * t;
+    }
+    if (tracks & TRACK_SCALE) {
+        pose.scale.x = scaleX[i] + (scaleX[i + 1] - scaleX[i]) * t;
+        pose.scale.y = scaleY[i] + (scaleY[i + 1] - scaleY[i]) * t;
+        pose.scale.z = scaleZ[i] + (scaleZ[i + 1] - scaleZ[i]) * t;
+    }
+}
+
+void BakedAnimation::getTexels(std::vector<glm::vec4>& texels) const {
+    size_t samples = frameCount + 1;
+    texels.assign(samples * 3, glm::vec4(0.0f));
+    for (size_t i = 0; i < samples; ++i) {
+        if (tracks & TRACK_TRANSLATION) {
+            texels[i] = glm::vec4(translationX[i], translationY[i], translationZ[i], 0.0f);
+        }
+        if (tracks & TRACK_ROTATION) {
+            texels[samples + i] = glm::vec4(rotationX[i], rotationY[i], rotationZ[i], 0.0f);
+        }
+        if (tracks & TRACK_SCALE) {
+            texels[samples * 2 + i] = glm::vec4(scaleX[i], scaleY[i], scaleZ[i], 0.0f);
+        }
+    }
+}
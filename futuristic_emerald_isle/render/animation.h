@@ -0,0 +1,57 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "mesh.h"
+
+// A Mesh::Animation resampled at a fixed rate into one table per component,
+// so evaluating it is an index computation and a lerp instead of a keyframe
+// search and a slerp. Rotation is stored as unwrapped Euler angles in
+// degrees, the form the bird shader consumes, so no conversion happens per frame.
+class BakedAnimation {
+public:
+    enum Track {
+        TRACK_TRANSLATION = 1 << 0,
+        TRACK_ROTATION = 1 << 1,
+        TRACK_SCALE = 1 << 2
+    };
+
+    struct Pose {
+        glm::vec3 translation;
+        glm::vec3 rotation;
+        glm::vec3 scale;
+    };
+
+    BakedAnimation();
+
+    bool bake(const Mesh::Animation& animation, float sampleRate = 60.0f);
+    void clear();
+
+    bool valid() const { return frameCount > 0; }
+    float getDuration() const { return duration; }
+    int getTracks() const { return tracks; }
+    int getFrameCount() const { return frameCount; }
+    float getFramesPerSecond() const { return framesPerSecond; }
+
+    // frameCount + 1 texels per row: translation, rotation, scale. Rows for
+    // missing tracks are zero. Used to build the GPU keyframe texture.
+    void getTexels(std::vector<glm::vec4>& texels) const;
+
+    // Only the components listed in getTracks() are written. time must be
+    // in [0, duration]; values outside are clamped.
+    void sample(float time, Pose& pose) const;
+
+private:
+    float duration;
+    float framesPerSecond;
+    int frameCount;
+    int tracks;
+
+    // Structure of arrays, frameCount + 1 samples each
+    std::vector<float> translationX, translationY, translationZ;
+    std::vector<float> rotationX, rotationY, rotationZ;
+    std::vector<float> scaleX, scaleY, scaleZ;
+};
+
+#endif // ANIMATION_H
@@ -56,5 +56,4 @@ void AxisXYZ::cleanup() {
     glDeleteBuffers(1, &vertexBufferID);
     glDeleteBuffers(1, &colorBufferID);
     glDeleteVertexArrays(1, &vertexArrayID);
-    glDeleteProgram(programID);
 }
\ No newline at end of file
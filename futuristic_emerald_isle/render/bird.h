@@ -2,46 +2,15 @@
 #define BIRD_H
 
 #include <glm/glm.hpp>
-#include <vector>
-#include <string>
-#include "glad/gl.h"
-#include "utils/utils.h"
-#include <glm/gtc/quaternion.hpp>
-
-class Bird {
-public:
-    Bird();
-    ~Bird();
-
-    void setPosition(const glm::vec3& position);
-    void setRotation(const glm::vec3& rotation);
-    void setScale(const glm::vec3& scale);
-    void setCircularPath(const glm::vec3& center, float radius, float speed);
-    void setRotationTowards(const glm::vec3& targetPosition);
-    void updateModelMatrix();
-
-    void update(double deltaTime);
-    void applyAnimation(const tinygltf::Animation& animation, double time);
-    void render(const glm::mat4& vp);
-
-    void cleanup();
 
+// Per-instance data of one bird, laid out as the bird.vert instance
+// attributes. Birds refreshes these from the flock simulation every frame;
+// heading and wing animation are derived in the vertex shader.
+struct Bird {
     glm::vec3 position;
-    glm::vec3 rotation;
-    glm::vec3 scale;
-    glm::mat4 modelMatrix;
-
-    glm::vec3 circularPathCenter;
-    float circularPathRadius = 0.0f;
-    float circularPathSpeed = 0.0f;
-    float circularPathAngle = 0.0f;
-
-    double currentAnimationTime;
-
-    static GLuint programID;
-    static tinygltf::Model model;
-    static std::vector<GLuint> bufferIDs;
-    static std::vector<GLuint> textureIDs;
+    float scale;
+    glm::vec3 velocity;
+    float animationPhase;       // Seconds into the flap cycle, with the frame's clock added for drawing
 };
 
 #endif
@@ -1,151 +1,202 @@
 #include "birds.h"
 #include "shader.h"
 #include <iostream>
-#include <bits/random.h>
+#include <random>
+#include <cstddef>
+#include <cstring>
 #include "terrain.h"
-
-
-Birds::Birds() {}
+#include <utils/job_system.h>
+
+// Attribute locations after the three mesh attributes, see bird.vert
+static const GLuint BIRD_POSITION_ATTRIBUTE = 3;
+static const GLuint BIRD_VELOCITY_ATTRIBUTE = 4;
+
+static const size_t BLEND_GRAIN = 1024;
+
+// Reach of a bird from its position, wings and flapping included
+static const float BIRD_CULL_RADIUS = 3.0f;
+
+Birds::Birds() :
+    ready(false),
+    programID(0),
+    keyframeTextureID(0),
+    keyframeSamplerID(0),
+    animationDurationID(0),
+    animationFramesPerSecondID(0),
+    animationFrameCountID(0),
+    animationTracksID(0),
+    time(0.0),
+    lastStep(0.0) {}
 Birds::~Birds() {}
 
-bool Birds::initialize(const std::string& modelPath) {
-    Bird::programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/bird.vert", "../futuristic_emerald_isle/shaders/bird.frag");
-    if (Bird::programID == 0) {
+bool Birds::initialize(const std::string& modelPath, const Terrain& terrain, AsyncLoader& loader) {
+    flock.initialize(&terrain);
+
+    programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/bird.vert", "../futuristic_emerald_isle/shaders/bird.frag");
+    if (programID == 0) {
         std::cerr << "Failed to load bird shaders!" << std::endl;
         return false;
     }
+    keyframeSamplerID = glGetUniformLocation(programID, "keyframeSampler");
+    animationDurationID = glGetUniformLocation(programID, "animationDuration");
+    animationFramesPerSecondID = glGetUniformLocation(programID, "animationFramesPerSecond");
+    animationFrameCountID = glGetUniformLocation(programID, "animationFrameCount");
+    animationTracksID = glGetUniformLocation(programID, "animationTracks");
+
+    ready = false;
+    loader.loadMesh(mesh, modelPath, [this](bool ok) {
+        if (ok && !mesh.animations.empty()) {
+            animation.bake(mesh.animations[0]);
+        }
+        createKeyframeTexture();
+        setAnimationUniforms();
+        ready = ok;
+    });
 
-    tinygltf::TinyGLTF loader;
-    std::string err, warn;
-
-    bool res = loader.LoadASCIIFromFile(&Bird::model, &err, &warn, modelPath);
-    if (!warn.empty()) {
-        std::cout << "WARN: " << warn << std::endl;
-    }
-
-    if (!err.empty()) {
-        std::cout << "ERR: " << err << std::endl;
-    }
-
-    if (!res) {
-        std::cout << "Failed to load glTF: " << modelPath << std::endl;
-        return false;
-    }
+    return true;
+}
 
-    std::cout << "Loaded glTF: " << modelPath << std::endl;
-
-    for (const auto& bufferView : Bird::model.bufferViews) {
-        GLuint bufferID;
-        glGenBuffers(1, &bufferID);
-        glBindBuffer(bufferView.target, bufferID);
-        glBufferData(bufferView.target,
-                     bufferView.byteLength,
-                     &Bird::model.buffers[bufferView.buffer].data[bufferView.byteOffset],
-                     GL_STATIC_DRAW);
-        Bird::bufferIDs.push_back(bufferID);
+void Birds::createKeyframeTexture() {
+    if (keyframeTextureID == 0) {
+        glGenTextures(1, &keyframeTextureID);
     }
 
-    for (const auto& texture : Bird::model.textures) {
-        const auto& image = Bird::model.images[texture.source];
-
-        GLuint textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.image.data());
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        Bird::textureIDs.push_back(textureID);
+    // A model without animation still gets one identity frame to sample
+    std::vector<glm::vec4> texels;
+    int width = 1;
+    if (animation.valid()) {
+        animation.getTexels(texels);
+        width = animation.getFrameCount() + 1;
+    } else {
+        texels.assign(3, glm::vec4(0.0f));
     }
 
-    for (const auto& material : Bird::model.materials) {
-        if (material.normalTexture.index >= 0) {
-            const auto& textureInfo = material.normalTexture;
-            GLuint normalTextureID = Bird::textureIDs[textureInfo.index];
-
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, normalTextureID);
-
-            // Log for debugging
-            std::cout << "Normal Map Loaded for Material: " << material.name
-                      << " Texture ID: " << normalTextureID << std::endl;
-        }
-    }
+    glBindTexture(GL_TEXTURE_2D, keyframeTextureID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, 3, 0, GL_RGBA, GL_FLOAT, texels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
 
-    return true;
+void Birds::setAnimationUniforms() {
+    // The clip never changes once baked, only the clock moves and that
+    // comes in with each instance
+    glUseProgram(programID);
+    glUniform1i(keyframeSamplerID, 2);
+    glUniform1f(animationDurationID, animation.getDuration());
+    glUniform1f(animationFramesPerSecondID, animation.getFramesPerSecond());
+    glUniform1i(animationFrameCountID, animation.getFrameCount());
+    glUniform1i(animationTracksID, animation.getTracks());
 }
 
 void Birds::generateBirds(Terrain& terrain, int nBirds, float altitudeThreshold) {
+    generateBirds(terrain.getHighestPoints(nBirds));
+}
+
+void Birds::generateBirds(const std::vector<glm::vec3>& hilltops) {
     std::random_device rd;
     std::mt19937 gen(rd());
     std::uniform_real_distribution<float> radiusDist(40.0f, 70.0f);
-    std::uniform_real_distribution<float> speedDist(50.0f, 150.0f);
+    std::uniform_real_distribution<float> angleDist(0.0f, glm::radians(360.0f));
+    std::uniform_real_distribution<float> speedDist(flock.settings.minSpeed, flock.settings.maxSpeed);
+    std::uniform_real_distribution<float> flapDist(0.0f, 60.0f);
     std::uniform_int_distribution<int> flockSizeDist(1, 5);
 
-    std::vector<glm::vec3> hilltops = terrain.getHighestPoints(nBirds);
-
     for (const auto& hilltop : hilltops) {
         int flockSize = flockSizeDist(gen);
         float radius = radiusDist(gen);
+        glm::vec3 home = hilltop + glm::vec3(0.0f, flock.settings.terrainClearance, 0.0f);
 
         for (int i = 0; i < flockSize; ++i) {
-            Bird bird;
-            bird.setPosition(hilltop);
-            bird.setScale(glm::vec3(0.3f));
-
-            float speed = speedDist(gen);
             radius = radius + i;
 
-            glm::vec3 center = hilltop;
-            //center.y -= 10.0f;
-            bird.setCircularPath(center, radius, speed);
+            // Start circling the hill, the flock takes over from there
+            float angle = angleDist(gen);
+            glm::vec3 position = home + radius * glm::vec3(cos(angle), 0.0f, sin(angle));
+            glm::vec3 velocity = speedDist(gen) * glm::vec3(-sin(angle), 0.0f, cos(angle));
+            flock.addBird(position, velocity, home);
 
+            Bird bird;
+            bird.position = position;
+            bird.scale = 0.3f;
+            bird.velocity = velocity;
+            bird.animationPhase = flapDist(gen);
             birds.push_back(bird);
         }
     }
 }
 
-void Birds::render(const glm::mat4& vp, const glm::vec3& cameraPosition, float renderRadius, glm::vec3 lightPosition,
-        glm::vec3 lightIntensity, double deltaTime)  {
-    for (auto& bird : birds) {
-        bird.update(deltaTime);
-        float distanceToCamera = glm::distance(bird.position, cameraPosition);
-
-        if (distanceToCamera <= renderRadius) {
-            glUseProgram(Bird::programID);
-            glUniform3fv(glGetUniformLocation(Bird::programID, "lightPosition"), 1, &lightPosition[0]);
-            glUniform3fv(glGetUniformLocation(Bird::programID, "lightIntensity"), 1, &lightIntensity[0]);
-            bird.render(vp);
+void Birds::update(double deltaTime) {
+    time += deltaTime;
+    lastStep = deltaTime;
+    flock.step(static_cast<float>(deltaTime));
+}
+
+void Birds::prepare(const CullView& view, float alpha, std::vector<Bird>& instances) {
+    blendedX.resize(birds.size());
+    blendedY.resize(birds.size());
+    blendedZ.resize(birds.size());
+    jobSystem.parallelFor(birds.size(), BLEND_GRAIN, [this, alpha](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            glm::vec3 previous(flock.previousPositionX[i], flock.previousPositionY[i], flock.previousPositionZ[i]);
+            glm::vec3 current(flock.positionX[i], flock.positionY[i], flock.positionZ[i]);
+            birds[i].position = glm::mix(previous, current, alpha);
+            birds[i].velocity = glm::vec3(flock.velocityX[i], flock.velocityY[i], flock.velocityZ[i]);
+            blendedX[i] = birds[i].position.x;
+            blendedY[i] = birds[i].position.y;
+            blendedZ[i] = birds[i].position.z;
         }
+    });
+
+    SphereArrays spheres = {blendedX.data(), blendedY.data(), blendedZ.data(), nullptr, BIRD_CULL_RADIUS};
+    CullSpheresParallel(view, spheres, birds.size(), visible);
+    double animationTime = time - (1.0 - alpha) * lastStep;
+    instances.resize(visible.size());
+    for (size_t k = 0; k < visible.size(); ++k) {
+        instances[k] = birds[visible[k]];
+        instances[k].animationPhase = static_cast<float>(birds[visible[k]].animationPhase + animationTime);
     }
 }
 
+void Birds::submit(RenderQueue& queue, const std::vector<Bird>& instances) {
+    if (!ready || instances.empty()) return;
+
+    StreamBuffer& stream = queue.getStream();
+    StreamBuffer::Allocation allocation = stream.allocate(instances.size() * sizeof(Bird));
+    if (!allocation.data) return;
+    memcpy(allocation.data, instances.data(), instances.size() * sizeof(Bird));
+
+    // Unit 2 is past the ones the queue manages
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_2D, keyframeTextureID);
+
+    glBindVertexArray(mesh.vertexArrayID);
+    glBindBuffer(GL_ARRAY_BUFFER, stream.getBuffer());
+    glVertexAttribPointer(BIRD_POSITION_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Bird), reinterpret_cast<void*>(allocation.offset + offsetof(Bird, position)));
+    glVertexAttribPointer(BIRD_VELOCITY_ATTRIBUTE, 4, GL_FLOAT, GL_FALSE, sizeof(Bird), reinterpret_cast<void*>(allocation.offset + offsetof(Bird, velocity)));
+    glVertexAttribDivisor(BIRD_POSITION_ATTRIBUTE, 1);
+    glVertexAttribDivisor(BIRD_VELOCITY_ATTRIBUTE, 1);
+    glEnableVertexAttribArray(BIRD_POSITION_ATTRIBUTE);
+    glEnableVertexAttribArray(BIRD_VELOCITY_ATTRIBUTE);
+    glBindVertexArray(0);
+
+    mesh.submit(queue, programID, static_cast<GLsizei>(instances.size()));
+}
+
 void Birds::cleanup() {
-    for (auto& bird : birds) {
-        bird.cleanup();
-    }
     birds.clear();
+    flock.cleanup();
 
-    for (auto& bufferID : Bird::bufferIDs) {
-        glDeleteBuffers(1, &bufferID);
-    }
-    Bird::bufferIDs.clear();
+    mesh.cleanup();
+    animation.clear();
+    ready = false;
 
-    for (auto& textureID : Bird::textureIDs) {
-        glDeleteTextures(1, &textureID);
-    }
-    Bird::textureIDs.clear();
+    if (keyframeTextureID != 0) glDeleteTextures(1, &keyframeTextureID);
+    keyframeTextureID = 0;
 
-    if (Bird::programID != 0) {
-        glDeleteProgram(Bird::programID);
-        Bird::programID = 0;
-    }
+    // The program itself belongs to programCache
+    programID = 0;
 
     std::cout << "Birds resources cleaned up." << std::endl;
-}
\ No newline at end of file
+}
@@ -2,22 +2,60 @@
 #define BIRDS_H
 
 #include "bird.h"
+#include "mesh.h"
+#include "animation.h"
+#include <utils/async_loader.h>
+#include <scene/flock.h>
+#include <scene/frustum_culling.h>
 #include <vector>
 
 class Terrain;
 
+// Seagulls flocking around the hilltops. Movement comes from the Flock
+// simulation; the whole flock is one instanced draw, with heading and the
+// baked seagull animation evaluated in bird.vert from a keyframe texture.
 class Birds {
 public:
     Birds();
     ~Birds();
 
-    bool initialize(const std::string& modelPath);
+    // Compiles the shaders now and streams the model in through loader.
+    // terrain must outlive the birds, the flock steers clear of it.
+    bool initialize(const std::string& modelPath, const Terrain& terrain, AsyncLoader& loader);
     void generateBirds(Terrain& terrain, int nBirds, float altitudeThreshold);
-    void render(const glm::mat4& vp, const glm::vec3& cameraPosition, float renderRadius, glm::vec3 lightPosition, glm::vec3 lightIntensity, double deltaTime);
+    void generateBirds(const std::vector<glm::vec3>& hilltops);
+    // Simulation thread: one fixed step, and the instances in view blended
+    // alpha of the way from the previous step, their flap phases moved on
+    // by the matching animation clock
+    void update(double deltaTime);
+    void prepare(const CullView& view, float alpha, std::vector<Bird>& instances);
+
+    // GL thread: queues the instances from prepare()
+    void submit(RenderQueue& queue, const std::vector<Bird>& instances);
     void cleanup();
 
+    bool ready;
+    Flock flock;
+
 private:
+    void createKeyframeTexture();
+    void setAnimationUniforms();
+
     std::vector<Bird> birds;
+    std::vector<float> blendedX, blendedY, blendedZ;    // Positions from prepare(), for culling
+    std::vector<uint32_t> visible;
+
+    Mesh mesh;
+    BakedAnimation animation;
+    GLuint programID;
+    GLuint keyframeTextureID;
+    GLuint keyframeSamplerID;
+    GLuint animationDurationID;
+    GLuint animationFramesPerSecondID;
+    GLuint animationFrameCountID;
+    GLuint animationTracksID;
+    double time;
+    double lastStep;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,174 +1,16 @@
 #ifndef BUILDING_H
 #define BUILDING_H
 
-#include <string>
 #include <glm/glm.hpp>
 #include <glad/gl.h>
 
-class Building {
-public:
-
-	glm::vec3 position;
-	glm::vec3 scale;
-	int vFactor;
-	GLuint facadeID;
-
-	Building();
-	~Building();
-
-	void initialize(const glm::vec3& position, const glm::vec3& scale, int vFactor, GLuint facadeID);
-	void render(const glm::mat4& vp, GLuint programID, GLuint textureID, GLuint mvpMatrixID, GLuint modelMatrixID,
-		GLuint lightPositionID, GLuint lightIntensityID, glm::vec3 lightPosition, glm::vec3 lightIntensity);
-	void cleanup();
-
-private:
-	GLuint vertexArrayID;
-	GLuint vertexBufferID;
-	GLuint colorBufferID;
-	GLuint uvBufferID;
-	GLuint normalBufferID;
-	GLuint indexBufferID;
-
-	std::string populateNormals();
-	glm::vec3 calcNormal(const GLfloat* faceVertices);
-	void addFaceNormal(GLfloat* normalBuffer, int offset, const GLfloat* vertexBuffer, int vertexOffset);
-
-
-	/**** BUFFER DATA ****/
-
-	GLfloat vertex_buffer_data[72] = {	// Vertex definition for a canonical box
-		// Front face
-		-1.0f, -1.0f, 1.0f,
-		1.0f, -1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-
-		// Back face
-		1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, 1.0f, -1.0f,
-		1.0f, 1.0f, -1.0f,
-
-		// Left face
-		-1.0f, -1.0f, -1.0f,
-		-1.0f, -1.0f, 1.0f,
-		-1.0f, 1.0f, 1.0f,
-		-1.0f, 1.0f, -1.0f,
-
-		// Right face
-		1.0f, -1.0f, 1.0f,
-		1.0f, -1.0f, -1.0f,
-		1.0f, 1.0f, -1.0f,
-		1.0f, 1.0f, 1.0f,
-
-		// Top face
-		-1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, 1.0f,
-		1.0f, 1.0f, -1.0f,
-		-1.0f, 1.0f, -1.0f,
-
-		// Bottom face
-		-1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, -1.0f,
-		1.0f, -1.0f, 1.0f,
-		-1.0f, -1.0f, 1.0f,
-	};
-
-	GLfloat color_buffer_data[72] = {
-		// Front, red
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-		1.0f, 0.0f, 0.0f,
-
-		// Back, yellow
-		1.0f, 1.0f, 0.0f,
-		1.0f, 1.0f, 0.0f,
-		1.0f, 1.0f, 0.0f,
-		1.0f, 1.0f, 0.0f,
-
-		// Left, green
-		0.0f, 1.0f, 0.0f,
-		0.0f, 1.0f, 0.0f,
-		0.0f, 1.0f, 0.0f,
-		0.0f, 1.0f, 0.0f,
-
-		// Right, cyan
-		0.0f, 1.0f, 1.0f,
-		0.0f, 1.0f, 1.0f,
-		0.0f, 1.0f, 1.0f,
-		0.0f, 1.0f, 1.0f,
-
-		// Top, blue
-		0.0f, 0.0f, 1.0f,
-		0.0f, 0.0f, 1.0f,
-		0.0f, 0.0f, 1.0f,
-		0.0f, 0.0f, 1.0f,
-
-		// Bottom, magenta
-		1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, 1.0f,
-		1.0f, 0.0f, 1.0f,
-	};
-
-	// Specify which vertices to connect to form triangles for each face. Each face has two triangles.
-	GLuint index_buffer_data[36] = {		// 12 triangle faces of a box
-		0, 1, 2,
-		0, 2, 3,
-
-		4, 5, 6,
-		4, 6, 7,
-
-		8, 9, 10,
-		8, 10, 11,
-
-		12, 13, 14,
-		12, 14, 15,
-
-		16, 17, 18,
-		16, 18, 19,
-
-		20, 21, 22,
-		20, 22, 23,
-	};
-
-	GLfloat uv_buffer_data[48] = {
-		// Front
-		0.0f, 1.0f,			// Bottom-left		U (horizontal), V (vertical)
-		1.0f, 1.0f,			// Bottom-right		U, V
-		1.0f, 0.0f,			// Top-right
-		0.0f, 0.0f,			// Top-left
-		// Back
-		0.0f, 1.0f,
-		1.0f, 1.0f,
-		1.0f, 0.0f,
-		0.0f, 0.0f,
-
-		// Left
-		0.0f, 1.0f,
-		1.0f, 1.0f,
-		1.0f, 0.0f,
-		0.0f, 0.0f,
-
-		// Right
-		0.0f, 1.0f,
-		1.0f, 1.0f,
-		1.0f, 0.0f,
-		0.0f, 0.0f,
-
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-		0.0f, 0.0f,
-	};
-
-	GLfloat normal_buffer_data[120];
+// Where one building stands and how it looks. BuildingBatch draws them all
+// from its one box, scaled and placed per building.
+struct Building {
+	glm::vec3 position = glm::vec3(0.0f);
+	glm::vec3 scale = glm::vec3(1.0f);	// Half extents, the box spans -1 to 1
+	int vFactor = 1;					// How often the facade repeats up the walls
+	GLuint facadeID = 0;
 };
 
-#endif
\ No newline at end of file
+#endif
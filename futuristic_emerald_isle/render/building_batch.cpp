@@ -0,0 +1,266 @@
+#include "building_batch.h"
+#include <algorithm>
+#include <iostream>
+#include "city.h"
+#include "shader.h"
+
+namespace {
+
+// Three rows of the model matrix, then the facade repeat
+const size_t RECORD_FLOATS = 13;
+const GLsizei RECORD_STRIDE = RECORD_FLOATS * sizeof(float);
+const GLuint BOX_INDEX_COUNT = 36;
+
+// The canonical box, four corners per face so each face gets its own
+// color, uv and normal
+const GLfloat BOX_POSITIONS[72] = {
+    // Front
+    -1.0f, -1.0f, 1.0f,   1.0f, -1.0f, 1.0f,   1.0f, 1.0f, 1.0f,   -1.0f, 1.0f, 1.0f,
+    // Back
+    1.0f, -1.0f, -1.0f,   -1.0f, -1.0f, -1.0f,   -1.0f, 1.0f, -1.0f,   1.0f, 1.0f, -1.0f,
+    // Left
+    -1.0f, -1.0f, -1.0f,   -1.0f, -1.0f, 1.0f,   -1.0f, 1.0f, 1.0f,   -1.0f, 1.0f, -1.0f,
+    // Right
+    1.0f, -1.0f, 1.0f,   1.0f, -1.0f, -1.0f,   1.0f, 1.0f, -1.0f,   1.0f, 1.0f, 1.0f,
+    // Top
+    -1.0f, 1.0f, 1.0f,   1.0f, 1.0f, 1.0f,   1.0f, 1.0f, -1.0f,   -1.0f, 1.0f, -1.0f,
+    // Bottom
+    -1.0f, -1.0f, -1.0f,   1.0f, -1.0f, -1.0f,   1.0f, -1.0f, 1.0f,   -1.0f, -1.0f, 1.0f,
+};
+
+// One per face: red, yellow, green, cyan, blue, magenta
+const GLfloat BOX_FACE_COLORS[18] = {
+    1.0f, 0.0f, 0.0f,   1.0f, 1.0f, 0.0f,   0.0f, 1.0f, 0.0f,
+    0.0f, 1.0f, 1.0f,   0.0f, 0.0f, 1.0f,   1.0f, 0.0f, 1.0f,
+};
+
+const GLfloat BOX_FACE_NORMALS[18] = {
+    0.0f, 0.0f, 1.0f,   0.0f, 0.0f, -1.0f,   -1.0f, 0.0f, 0.0f,
+    1.0f, 0.0f, 0.0f,   0.0f, 1.0f, 0.0f,    0.0f, -1.0f, 0.0f,
+};
+
+// The walls show the whole facade, the roof and floor a single texel
+const GLfloat BOX_WALL_UVS[8] = {
+    0.0f, 1.0f,   1.0f, 1.0f,   1.0f, 0.0f,   0.0f, 0.0f,
+};
+
+}
+
+BuildingBatch::BuildingBatch() : programID(0), boxVertexArrayID(0), boxVertexBufferID(0), boxIndexBufferID(0), recordBufferID(0) {}
+
+bool BuildingBatch::initialize() {
+    programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/box.vert", "../futuristic_emerald_isle/shaders/box.frag");
+    if (programID == 0) {
+        std::cerr << "Failed to load shaders for buildings!" << std::endl;
+        return false;
+    }
+
+    createBox();
+    return true;
+}
+
+void BuildingBatch::createBox() {
+    // Positions, colors, uvs and normals one after the other
+    const size_t corners = 24;
+    std::vector<GLfloat> vertices(corners * 11, 0.0f);
+    GLfloat* colors = &vertices[corners * 3];
+    GLfloat* uvs = &vertices[corners * 6];
+    GLfloat* normals = &vertices[corners * 8];
+    std::copy(BOX_POSITIONS, BOX_POSITIONS + corners * 3, vertices.begin());
+    for (size_t corner = 0; corner < corners; ++corner) {
+        size_t face = corner / 4;
+        std::copy(BOX_FACE_COLORS + face * 3, BOX_FACE_COLORS + face * 3 + 3, colors + corner * 3);
+        std::copy(BOX_FACE_NORMALS + face * 3, BOX_FACE_NORMALS + face * 3 + 3, normals + corner * 3);
+        if (face < 4) {
+            std::copy(BOX_WALL_UVS + (corner % 4) * 2, BOX_WALL_UVS + (corner % 4) * 2 + 2, uvs + corner * 2);
+        }
+    }
+
+    GLuint indices[BOX_INDEX_COUNT];
+    for (GLuint face = 0; face < 6; ++face) {
+        const GLuint corner[6] = {0, 1, 2, 0, 2, 3};
+        for (GLuint k = 0; k < 6; ++k) {
+            indices[face * 6 + k] = face * 4 + corner[k];
+        }
+    }
+
+    glGenVertexArrays(1, &boxVertexArrayID);
+    glBindVertexArray(boxVertexArrayID);
+
+    glGenBuffers(1, &boxVertexBufferID);
+    glBindBuffer(GL_ARRAY_BUFFER, boxVertexBufferID);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(0));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(corners * 3 * sizeof(GLfloat)));
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(corners * 6 * sizeof(GLfloat)));
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<void*>(corners * 8 * sizeof(GLfloat)));
+    for (GLuint location = 0; location < RECORD_LOCATION; ++location) {
+        glEnableVertexAttribArray(location);
+    }
+
+    glGenBuffers(1, &boxIndexBufferID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, boxIndexBufferID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+
+    // The VAO keeps the attributes and the index buffer from here on
+    glBindVertexArray(0);
+}
+
+void BuildingBatch::build(const std::vector<City>& cities) {
+    std::vector<const Building*> buildings;
+    for (const City& city : cities) {
+        for (const Building& building : city.buildings) {
+            buildings.push_back(&building);
+        }
+    }
+
+    // One contiguous range of records per facade
+    std::stable_sort(buildings.begin(), buildings.end(), [](const Building* a, const Building* b) {
+        return a->facadeID < b->facadeID;
+    });
+
+    std::vector<float> records(buildings.size() * RECORD_FLOATS);
+    for (std::vector<float>* bounds : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) {
+        bounds->resize(buildings.size());
+    }
+    facades.clear();
+    for (size_t i = 0; i < buildings.size(); ++i) {
+        const Building& b = *buildings[i];
+        if (facades.empty() || facades.back().facadeID != b.facadeID) {
+            facades.push_back({b.facadeID, i, 0, 0, 0});
+        }
+        facades.back().recordCount++;
+
+        // The box spans -1 to 1 before scaling
+        centerX[i] = b.position.x;
+        centerY[i] = b.position.y;
+        centerZ[i] = b.position.z;
+        extentX[i] = b.scale.x;
+        extentY[i] = b.scale.y;
+        extentZ[i] = b.scale.z;
+
+        // Translate then scale, as a row-major 3x4 matrix
+        float* record = &records[i * RECORD_FLOATS];
+        const float rows[RECORD_FLOATS] = {
+            b.scale.x, 0.0f, 0.0f, b.position.x,
+            0.0f, b.scale.y, 0.0f, b.position.y,
+            0.0f, 0.0f, b.scale.z, b.position.z,
+            static_cast<float>(b.vFactor)
+        };
+        std::copy(rows, rows + RECORD_FLOATS, record);
+    }
+
+    // Buildings never move, the tree is built once per set of cities
+    BoxArrays boxes = {centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data()};
+    std::vector<Aabb> bounds;
+    BoundsFromBoxes(boxes, buildings.size(), bounds);
+    bvh.build(bounds);
+
+    if (recordBufferID == 0) {
+        glGenBuffers(1, &recordBufferID);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, recordBufferID);
+    glBufferData(GL_ARRAY_BUFFER, records.size() * sizeof(float), records.data(), GL_STATIC_DRAW);
+
+    glBindVertexArray(boxVertexArrayID);
+    pointRecords(0);
+    for (GLuint location = RECORD_LOCATION; location < RECORD_LOCATION + 4; ++location) {
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+    glBindVertexArray(0);
+
+    std::cout << "Building batch: " << buildings.size() << " buildings, " << facades.size() << " facades"
+              << (IndirectDrawList::multiDrawSupported() ? "" : " (no multi-draw indirect, drawing per run)") << std::endl;
+}
+
+void BuildingBatch::pointRecords(GLuint baseInstance) const {
+    glBindBuffer(GL_ARRAY_BUFFER, recordBufferID);
+    size_t base = static_cast<size_t>(baseInstance) * RECORD_STRIDE;
+    for (GLuint row = 0; row < 3; ++row) {
+        glVertexAttribPointer(RECORD_LOCATION + row, 4, GL_FLOAT, GL_FALSE, RECORD_STRIDE, reinterpret_cast<void*>(base + row * 4 * sizeof(float)));
+    }
+    glVertexAttribPointer(RECORD_LOCATION + 3, 1, GL_FLOAT, GL_FALSE, RECORD_STRIDE, reinterpret_cast<void*>(base + 12 * sizeof(float)));
+}
+
+void BuildingBatch::cull(const CullView& view, std::vector<uint32_t>& visible) const {
+    visible.clear();
+    bvh.cull(view, visible);
+    std::sort(visible.begin(), visible.end());
+}
+
+void BuildingBatch::submit(RenderQueue& queue, const std::vector<uint32_t>& visible) {
+    if (centerX.empty()) return;
+
+    // Compacted into runs of consecutive records within each facade
+    commands.clear();
+    size_t k = 0;
+    for (FacadeRange& facade : facades) {
+        facade.firstCommand = commands.size();
+        size_t end = facade.firstRecord + facade.recordCount;
+        while (k < visible.size() && visible[k] < end) {
+            size_t runStart = visible[k];
+            size_t runEnd = runStart + 1;
+            for (++k; k < visible.size() && visible[k] == runEnd && runEnd < end; ++k) {
+                runEnd++;
+            }
+            commands.add({BOX_INDEX_COUNT, static_cast<GLuint>(runEnd - runStart), 0, 0, static_cast<GLuint>(runStart)});
+        }
+        facade.commandCount = commands.size() - facade.firstCommand;
+    }
+    commands.upload(queue.getStream());
+
+    for (size_t f = 0; f < facades.size(); ++f) {
+        if (facades[f].commandCount == 0) continue;
+
+        DrawItem item;
+        item.key = RenderQueue::makeKey(RenderQueue::PASS_OPAQUE, programID, facades[f].facadeID, boxVertexArrayID, 0.0f);
+        item.program = programID;
+        item.vertexArray = boxVertexArrayID;
+        item.textures[0] = facades[f].facadeID;
+        item.textures[1] = 0;
+        item.draw = drawFacade;
+        item.owner = this;
+        item.index = static_cast<uint32_t>(f);
+        item.count = 1;
+        queue.submit(item);
+    }
+}
+
+bool BuildingBatch::pick(const Ray& ray, Aabb& hit) const {
+    RayHit found = bvh.raycast(ray);
+    if (found.item == Bvh::NO_ITEM) return false;
+
+    glm::vec3 center(centerX[found.item], centerY[found.item], centerZ[found.item]);
+    glm::vec3 extent(extentX[found.item], extentY[found.item], extentZ[found.item]);
+    hit = {center - extent, center + extent};
+    return true;
+}
+
+void BuildingBatch::drawFacade(const DrawItem& item, const RenderView&) {
+    const BuildingBatch* batch = static_cast<const BuildingBatch*>(item.owner);
+    const FacadeRange& facade = batch->facades[item.index];
+    batch->commands.draw(facade.firstCommand, facade.commandCount, rebase, batch);
+}
+
+void BuildingBatch::rebase(const void* owner, GLuint baseInstance) {
+    static_cast<const BuildingBatch*>(owner)->pointRecords(baseInstance);
+}
+
+void BuildingBatch::cleanup() {
+    if (boxVertexBufferID != 0) glDeleteBuffers(1, &boxVertexBufferID);
+    if (boxIndexBufferID != 0) glDeleteBuffers(1, &boxIndexBufferID);
+    if (boxVertexArrayID != 0) glDeleteVertexArrays(1, &boxVertexArrayID);
+    boxVertexBufferID = boxIndexBufferID = boxVertexArrayID = 0;
+    commands.cleanup();
+    if (recordBufferID != 0) glDeleteBuffers(1, &recordBufferID);
+    recordBufferID = 0;
+    for (std::vector<float>* bounds : {&centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ}) {
+        bounds->clear();
+    }
+    bvh.clear();
+    facades.clear();
+
+    // The program itself belongs to programCache
+    programID = 0;
+}
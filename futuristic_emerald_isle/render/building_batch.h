@@ -0,0 +1,72 @@
+#ifndef BUILDING_BATCH_H
+#define BUILDING_BATCH_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "indirect_draw_list.h"
+#include "render_queue.h"
+#include <scene/bvh.h>
+
+class City;
+
+// Every building of every city drawn from one set of buffers: the canonical
+// box, plus one record per building (row-major 3x4 model matrix and how
+// often the facade repeats up the walls) read as per-instance attributes.
+// Records are stored grouped by facade. Each frame the simulation thread
+// culls the buildings in range against the view through a BVH over their
+// boxes; the GL thread compacts what is left into runs of consecutive
+// records, one indirect command per run, and each facade goes out as a
+// single draw item.
+class BuildingBatch {
+public:
+    // Record attributes follow the box's position, color, uv and normal
+    static const GLuint RECORD_LOCATION = 4;
+
+    BuildingBatch();
+
+    // GL thread
+    bool initialize();
+    // Replaces the records with the buildings of cities. The culling side
+    // changes too, so callers hold off cull() meanwhile.
+    void build(const std::vector<City>& cities);
+    // Queues the visible records, as cull() left them
+    void submit(RenderQueue& queue, const std::vector<uint32_t>& visible);
+    // The building whose box ray enters first, as its bounds
+    bool pick(const Ray& ray, Aabb& hit) const;
+    void cleanup();
+
+    // Any thread. Records in view and in the view's band, in record order.
+    void cull(const CullView& view, std::vector<uint32_t>& visible) const;
+
+    size_t size() const { return centerX.size(); }
+
+private:
+    struct FacadeRange {
+        GLuint facadeID;
+        size_t firstRecord;
+        size_t recordCount;
+        size_t firstCommand;
+        size_t commandCount;
+    };
+
+    void createBox();
+    static void drawFacade(const DrawItem& item, const RenderView& view);
+    static void rebase(const void* owner, GLuint baseInstance);
+    void pointRecords(GLuint baseInstance) const;
+
+    GLuint programID;
+    // The unit box every record scales and places
+    GLuint boxVertexArrayID;
+    GLuint boxVertexBufferID;
+    GLuint boxIndexBufferID;
+    GLuint recordBufferID;
+
+    // Bounding boxes in record order, for culling
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    Bvh bvh;
+    std::vector<FacadeRange> facades;
+    IndirectDrawList commands;
+};
+
+#endif // BUILDING_BATCH_H
@@ -1,154 +1,120 @@
 #include "cars.h"
+#include <cstring>
 #include <random>
 #include <iostream>
 #include "shader.h"
+#include <scene/transform_batch.h>
+#include <utils/job_system.h>
 #include <utils/utils.h>
 
-#include "city.h"
+namespace {
 
-Cars::Cars() {}
-Cars::~Cars() {}
-
-bool Cars::initialize(const std::string& modelPath) {
-    Car::programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/car.vert", "../futuristic_emerald_isle/shaders/car.frag");
-    if (Car::programID == 0) {
-        std::cerr << "Failed to load car shaders!" << std::endl;
-        return false;
-    }
+const size_t CULL_GRAIN = 2048;
 
-    tinygltf::TinyGLTF loader;
-    std::string err;
-    std::string warn;
+// Reach of a car from its position at the scale it is drawn
+const float CAR_CULL_RADIUS = 5.0f;
 
-    bool res = loader.LoadASCIIFromFile(&Car::model, &err, &warn, modelPath);
-    if (!warn.empty()) {
-        std::cout << "WARN: " << warn << std::endl;
-    }
+}
 
-    if (!err.empty()) {
-        std::cout << "ERR: " << err << std::endl;
-    }
+Cars::Cars() : ready(false), programID(0) {}
+Cars::~Cars() {}
 
-    if (!res) {
-        std::cout << "Failed to load glTF: " << modelPath << std::endl;
+bool Cars::initialize(const std::string& modelPath, AsyncLoader& loader) {
+    programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/car.vert", "../futuristic_emerald_isle/shaders/car.frag");
+    if (programID == 0) {
+        std::cerr << "Failed to load car shaders!" << std::endl;
         return false;
     }
 
-    std::cout << "Loaded glTF: " << modelPath << std::endl;
-
-    for (const auto& bufferView : Car::model.bufferViews) {
-        GLuint bufferID;
-        glGenBuffers(1, &bufferID);
-        glBindBuffer(bufferView.target, bufferID);
-        glBufferData(bufferView.target,
-                     bufferView.byteLength,
-                     &Car::model.buffers[bufferView.buffer].data[bufferView.byteOffset],
-                     GL_STATIC_DRAW);
-        Car::bufferIDs.push_back(bufferID);
-    }
-
-    for (const auto& texture : Car::model.textures) {
-        const auto& image = Car::model.images[texture.source];
-
-        GLuint textureID;
-        glGenTextures(1, &textureID);
-        glBindTexture(GL_TEXTURE_2D, textureID);
-
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.image.data());
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        Car::textureIDs.push_back(textureID);
-    }
-
-    for (const auto& material : Car::model.materials) {
-        if (material.normalTexture.index >= 0) {
-            const auto& textureInfo = material.normalTexture;
-            GLuint normalTextureID = Car::textureIDs[textureInfo.index];
-
-            glActiveTexture(GL_TEXTURE1);
-            glBindTexture(GL_TEXTURE_2D, normalTextureID);
-
-            std::cout << "Normal Map Loaded for Material: " << material.name
-                      << " Texture ID: " << normalTextureID << std::endl;
-        }
-    }
+    ready = false;
+    loader.loadMesh(mesh, modelPath, [this](bool ok) { ready = ok; });
 
     return true;
 }
 
-void Cars::generateCars(const std::vector<glm::vec3>& cityPositions, int nCars) {
-    if (cityPositions.size() < 2) {
+void Cars::generateCars(AirwayGraph&& airways, int nCars) {
+    if (airways.getEdgeCount() == 0) {
         std::cerr << "Not enough cities to generate car paths!" << std::endl;
         return;
     }
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dist(0, cityPositions.size() - 1);
-
-    for (int i = 0; i < nCars; ++i) {
-        int startIndex = dist(gen);
-        int endIndex;
-        do {
-            endIndex = dist(gen);
-        } while (endIndex == startIndex);
+    traffic.setAirways(std::move(airways));
+    size_t added = traffic.addCars(nCars, std::random_device()());
+    if (added < static_cast<size_t>(nCars)) {
+        std::cerr << "Airways are full, only " << added << " of " << nCars << " cars placed" << std::endl;
+    }
 
-        glm::vec3 start = cityPositions[startIndex];
-        glm::vec3 end = cityPositions[endIndex];
+    entities.clear();
+    entities.reserve(added);
+    for (size_t i = 0; i < added; ++i) {
+        size_t car = entities.add();
+        SetRotation(entities, car, glm::vec3(90.0f, 180.0f, 0.0f));
+        entities.scale[car] = 0.005f;
+    }
+}
 
-        start.y = 50.0f;
-        end.y = 50.0f;
+void Cars::update(double deltaTime, const glm::vec3& cameraPosition) {
+    traffic.step(static_cast<float>(deltaTime), cameraPosition);
+}
 
-        Car car;
-        car.setPosition(start);
-        car.setScale(glm::vec3(0.005f, 0.005f, 0.005f));
-        car.setRotationTowards(end);
-        car.setAnimation(start, end, 10.0f);
+void Cars::prepare(const CullView& view, float alpha, std::vector<float>& transforms) {
+    // Every car's blended position first, the culling reads them
+    jobSystem.parallelFor(traffic.size(), CULL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            entities.positionX[i] = glm::mix(traffic.previousPositionX[i], traffic.positionX[i], alpha);
+            entities.positionY[i] = glm::mix(traffic.previousPositionY[i], traffic.positionY[i], alpha);
+            entities.positionZ[i] = glm::mix(traffic.previousPositionZ[i], traffic.positionZ[i], alpha);
+        }
+    });
+
+    // Only the cars in view get their heading blended, in index order so
+    // the instance order does not depend on how the work was split
+    SphereArrays spheres = {entities.positionX.data(), entities.positionY.data(), entities.positionZ.data(), nullptr, CAR_CULL_RADIUS};
+    CullSpheresParallel(view, spheres, traffic.size(), visible);
+    jobSystem.parallelFor(visible.size(), CULL_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+            uint32_t i = visible[k];
+
+            // Shortest way round between the two headings
+            float turn = fmod(traffic.heading[i] - traffic.previousHeading[i] + 540.0f, 360.0f) - 180.0f;
+            float heading = traffic.previousHeading[i] + turn * alpha + 180.0f;
+            if (heading != entities.rotationZ[i]) {
+                SetRotation(entities, i, glm::vec3(entities.rotationX[i], entities.rotationY[i], heading));
+            }
+        }
+    });
 
-        cars.push_back(car);
-    }
+    transforms.resize(visible.size() * AFFINE_FLOATS);
+    TransformArrays arrays = GetTransformArrays(entities);
+    jobSystem.parallelFor(visible.size(), CULL_GRAIN, [&](size_t begin, size_t end) {
+        ComposeAffinePacked(arrays, visible.data() + begin, end - begin, transforms.data() + begin * AFFINE_FLOATS);
+    });
 }
 
-void Cars::render(const glm::mat4& vp, const glm::vec3& cameraPosition, float renderRadius, glm::vec3 lightPosition, glm::vec3 lightIntensity, double deltaTime) {
-    for (auto& car : cars) {
-        car.update(deltaTime);
-        float distanceToCamera = glm::distance(car.position, cameraPosition);
+void Cars::submit(RenderQueue& queue, const std::vector<float>& transforms) {
+    if (!ready || transforms.empty()) return;
 
-        if (distanceToCamera <= renderRadius) {
-            glUseProgram(Car::programID);
-            glUniform3fv(glGetUniformLocation(Car::programID, "lightPosition"), 1, &lightPosition[0]);
-            glUniform3fv(glGetUniformLocation(Car::programID, "lightIntensity"), 1, &lightIntensity[0]);
-            car.render(vp);
-        }
-    }
+    GLsizei count = static_cast<GLsizei>(transforms.size() / AFFINE_FLOATS);
+    float* mapped = instances.allocate(queue.getStream(), count);
+    if (!mapped) return;
+    memcpy(mapped, transforms.data(), transforms.size() * sizeof(float));
+
+    glBindVertexArray(mesh.vertexArrayID);
+    instances.bind();
+    glBindVertexArray(0);
+
+    mesh.submit(queue, programID, instances.getCount());
 }
 
 void Cars::cleanup() {
-    for (auto& car : cars) {
-        car.cleanup();
-    }
-    cars.clear();
+    traffic.cleanup();
+    entities.clear();
 
-    for (auto& bufferID : Car::bufferIDs) {
-        glDeleteBuffers(1, &bufferID);
-    }
-    Car::bufferIDs.clear();
+    mesh.cleanup();
+    ready = false;
 
-    for (auto& textureID : Car::textureIDs) {
-        glDeleteTextures(1, &textureID);
-    }
-    Car::textureIDs.clear();
-
-    if (Car::programID != 0) {
-        glDeleteProgram(Car::programID);
-        Car::programID = 0;
-    }
+    // The program itself belongs to programCache
+    programID = 0;
 
     std::cout << "Cars resources cleaned up." << std::endl;
 }
\ No newline at end of file
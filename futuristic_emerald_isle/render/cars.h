@@ -2,23 +2,48 @@
 #define CARS_H
 
 #include <string>
-#include "car.h"
+#include "mesh.h"
+#include "instance_buffer.h"
+#include <scene/entity_store.h>
+#include <scene/frustum_culling.h>
+#include <scene/traffic.h>
+#include <utils/async_loader.h>
 #include <vector>
 
-class Terrain;
-
+// Flying cars on the airways between cities. Traffic moves the whole fleet;
+// the cars in range are copied into an EntityStore for their transforms and
+// drawn with a single instanced call. Traffic and the store belong to the
+// simulation thread, the mesh and buffers to the GL thread.
 class Cars {
 public:
     Cars();
     ~Cars();
 
-    bool initialize(const std::string& modelPath);
-    void generateCars(const std::vector<glm::vec3>& cityPositions, int nCars);
-    void render(const glm::mat4& vp, const glm::vec3& cameraPosition, float renderRadius, glm::vec3 lightPosition, glm::vec3 lightIntensity, double deltaTime);
+    // Compiles the shaders now and streams the model in through loader
+    bool initialize(const std::string& modelPath, AsyncLoader& loader);
+    // Takes over airways, which can be built off the GL thread
+    void generateCars(AirwayGraph&& airways, int nCars);
+    // Simulation thread: one fixed step, steering the cars near the camera
+    // most often, and the transforms of the cars in view blended alpha of
+    // the way from the previous step
+    void update(double deltaTime, const glm::vec3& cameraPosition);
+    void prepare(const CullView& view, float alpha, std::vector<float>& transforms);
+
+    // GL thread: queues the transforms from prepare()
+    void submit(RenderQueue& queue, const std::vector<float>& transforms);
     void cleanup();
 
+    bool ready;
+
+    Traffic traffic;
+
 private:
-    std::vector<Car> cars;
+    EntityStore entities;
+    Mesh mesh;
+    GLuint programID;
+
+    InstanceBuffer instances;
+    std::vector<uint32_t> visible;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -5,6 +5,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+// Where the buildings of one hilltop city stand. They are drawn together
+// with every other city's by BuildingBatch.
 class City {
 public:
     std::vector<GLuint> facades;
@@ -13,18 +15,10 @@ public:
     City();
     ~City();
 
-    bool initialize();
+    // Facade textures are shared between cities and owned by the caller
+    bool initialize(const std::vector<GLuint>& facades);
     void addBuilding(glm::vec3 position, glm::vec3 scale, int vFactor, GLuint facadeID);
-    void render(const glm::mat4& vp, const glm::vec3& cameraPosition, float renderRadius, glm::vec3 lightPosition, glm::vec3 lightIntensity);
     void cleanup();
-
-private:
-    GLuint programID;
-    GLuint textureID;
-    GLuint mvpMatrixID;
-    GLuint modelMatrixID;
-    GLuint lightPositionID;
-    GLuint lightIntensityID;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,23 +1,45 @@
 #ifndef FOREST_H
 #define FOREST_H
 
-#include "tree.h"
+#include "mesh.h"
+#include "instance_buffer.h"
+#include <scene/bvh.h>
+#include <scene/entity_store.h>
+#include <utils/async_loader.h>
 #include <vector>
 
 class Terrain;
 
+// The trees every LOD draws from. Trees never move, so setup() composes
+// their transforms and builds the BVH over them once, and each LOD only
+// culls its band of it.
+class TreeSet {
+public:
+    void setup(const std::vector<glm::vec3>& positions, const std::vector<float>& rotations, const std::vector<float>& scales);
+    // Trees in view whose base is within [near, far) of the view's eye, in tree order
+    void cull(const CullView& view, std::vector<uint32_t>& visible) const;
+    void clear();
+    void printCoords() const;
+
+    size_t size() const { return trees.size(); }
+    const EntityStore& getTrees() const { return trees; }
+
+private:
+    EntityStore trees;
+    Bvh bvh;
+};
+
 class Forest {
 public:
     Forest();
     ~Forest();
 
-    bool initialize(int LOD, float minRenderRadius, float maxRenderRadius);
-    void render(const glm::mat4 & vp, const glm::vec3 & cameraPosition, glm::vec3 lightPosition, glm::vec3 lightIntensity);
+    // Compiles the shaders now and streams the mesh in through loader
+    bool initialize(int LOD, float minRenderRadius, float maxRenderRadius, AsyncLoader& loader);
+    // Queues the visible trees, culled to this LOD's render radii
+    void submit(RenderQueue& queue, const TreeSet& trees, const std::vector<uint32_t>& visible);
     void cleanup();
 
-    void setupLOD(int LOD, const std::vector<glm::vec3>& positions, const std::vector<float>& rotations, const std::vector<float>& scales);
-    void printCoords();
-
     int LOD;
     GLuint programID;
     const std::string LOD0_PATH = "../futuristic_emerald_isle/assets/imported_models/tree_lod0/LOD0.gltf";
@@ -28,13 +50,11 @@ public:
     const std::string LOD2_SHADERS_PATH = "../futuristic_emerald_isle/shaders/tree_lod2/tree";
     float minRenderRadius, maxRenderRadius;
 
-    tinygltf::Model model;
-    std::vector<GLuint> bufferIDs;
-    std::vector<GLuint> textureIDs;
+    Mesh mesh;
+    bool ready;
 
 private:
-    std::vector<Tree> trees;
-    GLuint instanceBuffer;
+    InstanceBuffer instances;
 };
 
 #endif
\ No newline at end of file
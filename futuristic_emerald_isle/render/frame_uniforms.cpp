@@ -0,0 +1,48 @@
+#include "frame_uniforms.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include "render_queue.h"
+#include "stream_buffer.h"
+
+// Offsets the shaders' std140 block expects
+static_assert(offsetof(FrameBlock, viewProjection) == 128, "Frame block layout does not match std140");
+static_assert(offsetof(FrameBlock, cameraPosition) == 192, "Frame block layout does not match std140");
+static_assert(offsetof(FrameBlock, lightPosition) == 208, "Frame block layout does not match std140");
+static_assert(offsetof(FrameBlock, lightIntensity) == 224, "Frame block layout does not match std140");
+static_assert(sizeof(FrameBlock) == 240, "Frame block layout does not match std140");
+
+const char* const FrameUniforms::BLOCK_NAME = "Frame";
+
+FrameUniforms::FrameUniforms() : offsetAlignment(0) {}
+
+void FrameUniforms::attach(GLuint programID) {
+    GLuint block = glGetUniformBlockIndex(programID, BLOCK_NAME);
+    if (block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(programID, block, BINDING);
+    }
+}
+
+void FrameUniforms::update(const RenderView& view, StreamBuffer& stream) {
+    FrameBlock frame;
+    frame.view = view.view;
+    frame.projection = view.projection;
+    frame.viewProjection = view.vp;
+    frame.cameraPosition = view.cameraPosition;
+    frame.lightPosition = view.lightPosition;
+    frame.lightIntensity = view.lightIntensity;
+    frame.padding0 = frame.padding1 = frame.padding2 = 0.0f;
+
+    if (offsetAlignment == 0) {
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+        offsetAlignment = std::max(offsetAlignment, 16);
+    }
+
+    // Out of room, the binding keeps last frame's copy for once
+    StreamBuffer::Allocation allocation = stream.allocate(sizeof(FrameBlock), offsetAlignment);
+    if (!allocation.data) {
+        return;
+    }
+    std::memcpy(allocation.data, &frame, sizeof(FrameBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, BINDING, stream.getBuffer(), allocation.offset, sizeof(FrameBlock));
+}
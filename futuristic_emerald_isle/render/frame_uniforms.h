@@ -0,0 +1,45 @@
+#ifndef FRAME_UNIFORMS_H
+#define FRAME_UNIFORMS_H
+
+#include <glm/glm.hpp>
+#include "glad/gl.h"
+
+struct RenderView;
+class StreamBuffer;
+
+// The std140 layout of the "Frame" uniform block at the top of every
+// shader. Each vec3 takes a full 16 bytes, the floats after them only pad.
+struct FrameBlock {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec3 cameraPosition;
+    float padding0;
+    glm::vec3 lightPosition;
+    float padding1;
+    glm::vec3 lightIntensity;
+    float padding2;
+};
+
+// Camera and lighting for the frame, written once into the frame's stream
+// buffer and read by every program through the uniform buffer binding
+// point BINDING
+class FrameUniforms {
+public:
+    static const GLuint BINDING = 0;
+    static const char* const BLOCK_NAME;
+
+    FrameUniforms();
+
+    // Points the program's Frame block, if it declares one, at BINDING.
+    // Block bindings reset on link, so this follows every link.
+    static void attach(GLuint programID);
+
+    // Between the stream's beginFrame() and endWrites()
+    void update(const RenderView& view, StreamBuffer& stream);
+
+private:
+    GLint offsetAlignment;          // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, queried on first use
+};
+
+#endif // FRAME_UNIFORMS_H
@@ -0,0 +1,57 @@
+#include "indirect_draw_list.h"
+#include <cstring>
+#include <utils/gl_ext.h>
+
+static_assert(sizeof(DrawElementsIndirectCommand) == 5 * sizeof(GLuint), "indirect commands must be tightly packed");
+
+bool IndirectDrawList::multiDrawSupported() {
+    return glExtMultiDrawElementsIndirect != nullptr;
+}
+
+IndirectDrawList::IndirectDrawList() : bufferID(0), offset(0) {}
+
+void IndirectDrawList::upload(StreamBuffer& stream) {
+    bufferID = 0;
+    if (!multiDrawSupported() || commands.empty()) {
+        return;
+    }
+
+    GLsizeiptr bytes = commands.size() * sizeof(DrawElementsIndirectCommand);
+    StreamBuffer::Allocation allocation = stream.allocate(bytes, sizeof(GLuint));
+    if (!allocation.data) {
+        return;
+    }
+    std::memcpy(allocation.data, commands.data(), bytes);
+    bufferID = stream.getBuffer();
+    offset = allocation.offset;
+}
+
+void IndirectDrawList::draw(size_t first, size_t count, RebaseFunction rebase, const void* owner) const {
+    if (count == 0 || first + count > commands.size()) {
+        return;
+    }
+
+    if (bufferID != 0) {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, bufferID);
+        const void* start = reinterpret_cast<const void*>(offset + first * sizeof(DrawElementsIndirectCommand));
+        glExtMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, start, static_cast<GLsizei>(count), 0);
+        return;
+    }
+
+    for (size_t i = first; i < first + count; ++i) {
+        const DrawElementsIndirectCommand& command = commands[i];
+        rebase(owner, command.baseInstance);
+        const void* offset = reinterpret_cast<const void*>(static_cast<size_t>(command.firstIndex) * sizeof(GLuint));
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, GL_UNSIGNED_INT, offset, command.instanceCount, command.baseVertex);
+    }
+
+    // Multi-draw frames add baseInstance on top of whatever the VAO points
+    // at, so leave it at the first record
+    rebase(owner, 0);
+}
+
+void IndirectDrawList::cleanup() {
+    // The buffer belongs to the stream
+    bufferID = 0;
+    commands.clear();
+}
@@ -0,0 +1,49 @@
+#ifndef INDIRECT_DRAW_LIST_H
+#define INDIRECT_DRAW_LIST_H
+
+#include <cstddef>
+#include <vector>
+#include "glad/gl.h"
+#include "stream_buffer.h"
+
+// One indexed draw, laid out as glMultiDrawElementsIndirect reads it
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;            // First per-draw record, read through divisor-1 attributes
+};
+
+// A frame's draw commands, written into the frame's stream buffer so a
+// whole range of them goes out in one glMultiDrawElementsIndirect. Drivers without it (or
+// without base instances) get one instanced draw per command instead, with
+// rebase() pointing the per-draw attributes of the bound VAO at the
+// command's records first, and back at record 0 once done.
+class IndirectDrawList {
+public:
+    typedef void (*RebaseFunction)(const void* owner, GLuint baseInstance);
+
+    static bool multiDrawSupported();
+
+    IndirectDrawList();
+
+    void clear() { commands.clear(); }
+    void add(const DrawElementsIndirectCommand& command) { commands.push_back(command); }
+    size_t size() const { return commands.size(); }
+
+    // Once per frame, after the last add() and before any draw(). Should
+    // the stream be out of room, this frame draws per command.
+    void upload(StreamBuffer& stream);
+    // GL thread, with the VAO the commands index into bound. Indices are
+    // GL_UNSIGNED_INT triangles.
+    void draw(size_t first, size_t count, RebaseFunction rebase, const void* owner) const;
+    void cleanup();
+
+private:
+    std::vector<DrawElementsIndirectCommand> commands;
+    GLuint bufferID;                // This frame's stream buffer, 0 when not uploaded
+    GLintptr offset;
+};
+
+#endif // INDIRECT_DRAW_LIST_H
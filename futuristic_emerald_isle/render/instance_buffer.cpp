@@ -0,0 +1,32 @@
+#include "instance_buffer.h"
+#include <scene/transform_batch.h>
+
+static const GLsizeiptr INSTANCE_STRIDE = AFFINE_FLOATS * sizeof(float);
+
+InstanceBuffer::InstanceBuffer() : bufferID(0), offset(0), count(0) {}
+
+float* InstanceBuffer::allocate(StreamBuffer& stream, GLsizei count) {
+    this->count = 0;
+    if (count == 0) {
+        return nullptr;
+    }
+
+    StreamBuffer::Allocation allocation = stream.allocate(count * INSTANCE_STRIDE);
+    if (!allocation.data) {
+        return nullptr;
+    }
+    bufferID = stream.getBuffer();
+    offset = allocation.offset;
+    this->count = count;
+    return static_cast<float*>(allocation.data);
+}
+
+void InstanceBuffer::bind() const {
+    glBindBuffer(GL_ARRAY_BUFFER, bufferID);
+    for (GLuint row = 0; row < 3; ++row) {
+        GLuint location = INSTANCE_ROWS_LOCATION + row;
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, static_cast<GLsizei>(INSTANCE_STRIDE), reinterpret_cast<void*>(offset + row * 4 * sizeof(float)));
+        glVertexAttribDivisor(location, 1);
+        glEnableVertexAttribArray(location);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef INSTANCE_BUFFER_H
+#define INSTANCE_BUFFER_H
+
+#include "glad/gl.h"
+#include "stream_buffer.h"
+
+// Per-instance transforms for an instanced Mesh::submit, as packed row-major
+// 3x4 affine matrices (see scene/transform_batch.h). The rows are three vec4
+// vertex attributes from INSTANCE_ROWS_LOCATION, right after the mesh's
+// position, uv and normal. The transforms live in the frame's stream
+// buffer, so they are written once per frame, straight where the GPU reads.
+class InstanceBuffer {
+public:
+    static const GLuint INSTANCE_ROWS_LOCATION = 3;
+
+    InstanceBuffer();
+
+    // Room in the stream for count instances, AFFINE_FLOATS each. Returns
+    // nullptr, and draws nothing this frame, if there is none.
+    float* allocate(StreamBuffer& stream, GLsizei count);
+
+    // Points the instance attributes of the bound VAO, the mesh's own, at
+    // this frame's instances
+    void bind() const;
+
+    GLsizei getCount() const { return count; }
+
+private:
+    GLuint bufferID;
+    GLintptr offset;
+    GLsizei count;
+};
+
+#endif // INSTANCE_BUFFER_H
@@ -0,0 +1,267 @@
+#include "mesh.h"
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <utils/cooked_mesh_format.h>
+#include <utils/load_textures.h>
+#include <utils/mesh_cooker.h>
+#include <utils/vfs.h>
+
+namespace {
+
+template <typename T>
+bool sectionInBounds(uint64_t offset, uint64_t count, size_t size) {
+    return offset <= size && count <= (size - offset) / sizeof(T);
+}
+
+// tinygltf reads the .gltf and everything it references through the VFS
+bool vfsFileExists(const std::string& path, void*) {
+    return vfs.exists(path);
+}
+
+std::string vfsExpandFilePath(const std::string& path, void*) {
+    return path;
+}
+
+bool vfsReadWholeFile(std::vector<unsigned char>* out, std::string* err, const std::string& path, void*) {
+    if (!vfs.read(path, *out)) {
+        if (err) *err += "File read error : " + path + "\n";
+        return false;
+    }
+    return true;
+}
+
+bool vfsGetFileSize(size_t* size, std::string* err, const std::string& path, void*) {
+    VfsFile file;
+    if (!vfs.open(path, file)) {
+        if (err) *err += "File open error : " + path + "\n";
+        return false;
+    }
+    *size = file.size();
+    return true;
+}
+
+bool cookGLTF(const std::string& gltfPath, std::vector<uint8_t>& out) {
+    tinygltf::Model model;
+    tinygltf::TinyGLTF loader;
+    std::string err, warn;
+
+    tinygltf::FsCallbacks fs;
+    fs.FileExists = vfsFileExists;
+    fs.ExpandFilePath = vfsExpandFilePath;
+    fs.ReadWholeFile = vfsReadWholeFile;
+    fs.WriteWholeFile = tinygltf::WriteWholeFile;
+    fs.GetFileSizeInBytes = vfsGetFileSize;
+    fs.user_data = nullptr;
+    loader.SetFsCallbacks(fs);
+
+    bool res = loader.LoadASCIIFromFile(&model, &err, &warn, gltfPath);
+    if (!warn.empty()) {
+        std::cout << "WARN: " << warn << std::endl;
+    }
+
+    if (!err.empty()) {
+        std::cout << "ERR: " << err << std::endl;
+    }
+
+    if (!res) {
+        std::cout << "Failed to load glTF: " << gltfPath << std::endl;
+        return false;
+    }
+
+    // Skip block compression here, it is only worth paying for offline
+    if (!CookGLTFModel(model, out, err, false)) {
+        std::cout << "Failed to cook glTF: " << gltfPath << " (" << err << ")" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+}
+
+Mesh::Mesh() : vertexArrayID(0), poolHandle(0) {}
+
+Mesh::~Mesh() {}
+
+bool Mesh::load(const std::string& gltfPath) {
+    std::string cookedPath = CookedMeshPath(gltfPath);
+    if (loadCooked(cookedPath)) {
+        std::cout << "Loaded cooked mesh: " << cookedPath << std::endl;
+        return true;
+    }
+
+    std::vector<uint8_t> cooked;
+    if (!cookGLTF(gltfPath, cooked)) {
+        return false;
+    }
+
+    std::cout << "Loaded glTF: " << gltfPath << " (run asset_cook to skip parsing)" << std::endl;
+    return loadFromMemory(cooked.data(), cooked.size());
+}
+
+bool Mesh::readCooked(const std::string& gltfPath, std::vector<uint8_t>& out) {
+    if (vfs.read(CookedMeshPath(gltfPath), out)) {
+        return true;
+    }
+    return cookGLTF(gltfPath, out);
+}
+
+bool Mesh::loadCooked(const std::string& cookedPath) {
+    VfsFile file;
+    if (!vfs.open(cookedPath, file)) {
+        return false;
+    }
+    return loadFromMemory(file.data(), file.size());
+}
+
+bool Mesh::loadFromMemory(const uint8_t* data, size_t size) {
+    if (size < sizeof(CookedMeshHeader)) {
+        return false;
+    }
+
+    const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(data);
+    if (header->magic != COOKED_MESH_MAGIC || header->version != COOKED_MESH_VERSION || header->fileSize > size) {
+        std::cerr << "Cooked mesh has a stale or unknown format, re-run asset_cook" << std::endl;
+        return false;
+    }
+
+    if (!sectionInBounds<CookedVertex>(header->vertexOffset, header->vertexCount, size) ||
+        !sectionInBounds<uint32_t>(header->indexOffset, header->indexCount, size) ||
+        !sectionInBounds<CookedPrimitive>(header->primitiveOffset, header->primitiveCount, size) ||
+        !sectionInBounds<CookedNode>(header->nodeOffset, header->nodeCount, size) ||
+        !sectionInBounds<CookedMaterial>(header->materialOffset, header->materialCount, size) ||
+        !sectionInBounds<CookedTexture>(header->textureOffset, header->textureCount, size) ||
+        !sectionInBounds<CookedAnimation>(header->animationOffset, header->animationCount, size) ||
+        !sectionInBounds<CookedAnimationChannel>(header->channelOffset, header->channelCount, size)) {
+        std::cerr << "Cooked mesh is truncated" << std::endl;
+        return false;
+    }
+
+    // Vertex and index streams go straight from the mapping to the pool
+    poolHandle = meshPool.add(reinterpret_cast<const CookedVertex*>(data + header->vertexOffset), header->vertexCount,
+                              reinterpret_cast<const uint32_t*>(data + header->indexOffset), header->indexCount);
+    vertexArrayID = meshPool.createVertexArray();
+
+    const CookedPrimitive* cookedPrimitives = reinterpret_cast<const CookedPrimitive*>(data + header->primitiveOffset);
+    for (uint32_t i = 0; i < header->primitiveCount; ++i) {
+        const CookedPrimitive& p = cookedPrimitives[i];
+        if (p.firstIndex + static_cast<uint64_t>(p.indexCount) > header->indexCount) {
+            std::cerr << "Cooked primitive " << i << " is out of range" << std::endl;
+            continue;
+        }
+        primitives.push_back({p.firstIndex, static_cast<GLsizei>(p.indexCount), p.material, p.node});
+    }
+
+    const CookedNode* cookedNodes = reinterpret_cast<const CookedNode*>(data + header->nodeOffset);
+    for (uint32_t i = 0; i < header->nodeCount; ++i) {
+        glm::mat4 m;
+        memcpy(&m[0][0], cookedNodes[i].worldMatrix, sizeof(cookedNodes[i].worldMatrix));
+        nodeTransforms.push_back(m);
+    }
+
+    const CookedMaterial* cookedMaterials = reinterpret_cast<const CookedMaterial*>(data + header->materialOffset);
+    for (uint32_t i = 0; i < header->materialCount; ++i) {
+        const CookedMaterial& m = cookedMaterials[i];
+        glm::vec4 factor(m.baseColorFactor[0], m.baseColorFactor[1], m.baseColorFactor[2], m.baseColorFactor[3]);
+        materials.push_back({factor, m.baseColorTexture, m.normalTexture});
+    }
+
+    const CookedTexture* cookedTextures = reinterpret_cast<const CookedTexture*>(data + header->textureOffset);
+    for (uint32_t i = 0; i < header->textureCount; ++i) {
+        const CookedTexture& t = cookedTextures[i];
+        bool valid = t.dataOffset <= size && t.dataSize <= size - t.dataOffset;
+
+        GLuint textureID = valid ? LoadCookedTexture(data + t.dataOffset, t.dataSize) : 0;
+        if (textureID == 0) {
+            std::cerr << "Cooked texture " << i << " could not be loaded" << std::endl;
+        }
+
+        textureIDs.push_back(textureID);
+    }
+
+    const CookedAnimation* cookedAnimations = reinterpret_cast<const CookedAnimation*>(data + header->animationOffset);
+    const CookedAnimationChannel* cookedChannels = reinterpret_cast<const CookedAnimationChannel*>(data + header->channelOffset);
+    for (uint32_t i = 0; i < header->animationCount; ++i) {
+        const CookedAnimation& a = cookedAnimations[i];
+        Animation animation;
+        animation.duration = a.duration;
+
+        for (uint32_t c = a.firstChannel; c < a.firstChannel + a.channelCount && c < header->channelCount; ++c) {
+            const CookedAnimationChannel& cc = cookedChannels[c];
+            if (!sectionInBounds<float>(cc.timesOffset, cc.keyCount, size) ||
+                !sectionInBounds<float>(cc.valuesOffset, static_cast<uint64_t>(cc.keyCount) * cc.components, size)) {
+                continue;
+            }
+
+            AnimationChannel channel;
+            channel.path = static_cast<int>(cc.path);
+            channel.node = cc.node;
+            channel.components = static_cast<int>(cc.components);
+
+            const float* times = reinterpret_cast<const float*>(data + cc.timesOffset);
+            const float* values = reinterpret_cast<const float*>(data + cc.valuesOffset);
+            channel.times.assign(times, times + cc.keyCount);
+            channel.values.assign(values, values + cc.keyCount * cc.components);
+            animation.channels.push_back(std::move(channel));
+        }
+
+        animations.push_back(std::move(animation));
+    }
+
+    return true;
+}
+
+void Mesh::submit(RenderQueue& queue, GLuint programID, GLsizei instanceCount, float depth) const {
+    for (size_t i = 0; i < primitives.size(); ++i) {
+        const Primitive& primitive = primitives[i];
+
+        DrawItem item;
+        item.program = programID;
+        item.vertexArray = vertexArrayID;
+        item.textures[0] = 0;
+        item.textures[1] = 0;
+        if (primitive.material >= 0 && primitive.material < static_cast<GLint>(materials.size())) {
+            const Material& material = materials[primitive.material];
+            if (material.baseColorTexture >= 0) item.textures[0] = textureIDs[material.baseColorTexture];
+            if (material.normalTexture >= 0) item.textures[1] = textureIDs[material.normalTexture];
+        }
+        item.key = RenderQueue::makeKey(RenderQueue::PASS_OPAQUE, programID, item.textures[0], vertexArrayID, depth);
+        item.draw = drawPrimitive;
+        item.owner = this;
+        item.index = static_cast<uint32_t>(i);
+        item.count = instanceCount;
+        queue.submit(item);
+    }
+}
+
+void Mesh::drawPrimitive(const DrawItem& item, const RenderView&) {
+    const Mesh* mesh = static_cast<const Mesh*>(item.owner);
+    if (mesh->poolHandle == 0) return;
+
+    const Primitive& primitive = mesh->primitives[item.index];
+    size_t firstIndex = static_cast<size_t>(meshPool.getFirstIndex(mesh->poolHandle)) + primitive.firstIndex;
+    void* offset = reinterpret_cast<void*>(firstIndex * sizeof(uint32_t));
+    GLint baseVertex = meshPool.getBaseVertex(mesh->poolHandle);
+    if (item.count == 1) {
+        glDrawElementsBaseVertex(GL_TRIANGLES, primitive.indexCount, GL_UNSIGNED_INT, offset, baseVertex);
+    } else {
+        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, primitive.indexCount, GL_UNSIGNED_INT, offset, item.count, baseVertex);
+    }
+}
+
+void Mesh::cleanup() {
+    meshPool.remove(poolHandle);
+    meshPool.deleteVertexArray(vertexArrayID);
+    poolHandle = 0;
+    vertexArrayID = 0;
+
+    for (auto& textureID : textureIDs) {
+        if (textureID != 0) glDeleteTextures(1, &textureID);
+    }
+    textureIDs.clear();
+
+    primitives.clear();
+    materials.clear();
+    nodeTransforms.clear();
+    animations.clear();
+}
@@ -0,0 +1,75 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include "glad/gl.h"
+#include "mesh_pool.h"
+#include "render_queue.h"
+
+// GPU-resident model built from a cooked (.feim) file. Cars, birds and trees
+// share one Mesh per model and draw it with their own program and matrices.
+// Vertices and indices live in meshPool; the mesh has a vertex array of
+// its own for the per-instance attributes its owner adds.
+class Mesh {
+public:
+    struct Primitive {
+        GLuint firstIndex;
+        GLsizei indexCount;
+        GLint material;
+        GLint node;
+    };
+
+    struct Material {
+        glm::vec4 baseColorFactor;
+        GLint baseColorTexture;
+        GLint normalTexture;
+    };
+
+    struct AnimationChannel {
+        int path;           // CookedAnimationPath
+        int node;
+        int components;
+        std::vector<float> times;
+        std::vector<float> values;
+    };
+
+    struct Animation {
+        float duration;
+        std::vector<AnimationChannel> channels;
+    };
+
+    Mesh();
+    ~Mesh();
+
+    // Loads the cooked sibling of gltfPath when present, otherwise parses
+    // the glTF and cooks it in memory.
+    bool load(const std::string& gltfPath);
+    bool loadCooked(const std::string& cookedPath);
+    bool loadFromMemory(const uint8_t* data, size_t size);
+
+    // CPU half of load(), safe to call off the GL thread. Fills out with the
+    // cooked sibling of gltfPath or with the glTF cooked in memory.
+    static bool readCooked(const std::string& gltfPath, std::vector<uint8_t>& out);
+
+    // Queues one draw per primitive, instanceCount instances each. Per-instance
+    // attributes, if any, are the caller's to set up in vertexArrayID, and
+    // uniforms beyond the view's are the caller's to set on the program.
+    void submit(RenderQueue& queue, GLuint programID, GLsizei instanceCount = 1, float depth = 0.0f) const;
+    void cleanup();
+
+    GLuint vertexArrayID;
+    MeshPool::Handle poolHandle;
+
+    std::vector<Primitive> primitives;
+    std::vector<Material> materials;
+    std::vector<GLuint> textureIDs;
+    std::vector<glm::mat4> nodeTransforms;
+    std::vector<Animation> animations;
+
+private:
+    static void drawPrimitive(const DrawItem& item, const RenderView& view);
+};
+
+#endif // MESH_H
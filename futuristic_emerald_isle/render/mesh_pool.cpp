@@ -0,0 +1,303 @@
+#include "mesh_pool.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+MeshPool meshPool;
+
+RangeAllocator::RangeAllocator() : capacity(0), free(0) {}
+
+void RangeAllocator::reset(GLuint capacity, GLuint used) {
+    ranges.clear();
+    this->capacity = capacity;
+    free = capacity - used;
+    if (free > 0) {
+        ranges[used] = free;
+    }
+}
+
+bool RangeAllocator::allocate(GLuint count, GLuint& first) {
+    for (auto it = ranges.begin(); it != ranges.end(); ++it) {
+        if (it->second < count) continue;
+
+        first = it->first;
+        GLuint rest = it->second - count;
+        ranges.erase(it);
+        if (rest > 0) {
+            ranges[first + count] = rest;
+        }
+        free -= count;
+        return true;
+    }
+    return false;
+}
+
+void RangeAllocator::release(GLuint first, GLuint count) {
+    if (count == 0) return;
+    free += count;
+
+    auto next = ranges.lower_bound(first);
+    if (next != ranges.end() && first + count == next->first) {
+        count += next->second;
+        next = ranges.erase(next);
+    }
+    if (next != ranges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == first) {
+            previous->second += count;
+            return;
+        }
+    }
+    ranges[first] = count;
+}
+
+bool RangeAllocator::fits(GLuint count) const {
+    for (const auto& range : ranges) {
+        if (range.second >= count) return true;
+    }
+    return false;
+}
+
+void RangeAllocator::grow(GLuint capacity) {
+    if (capacity <= this->capacity) return;
+    GLuint added = capacity - this->capacity;
+    GLuint first = this->capacity;
+    this->capacity = capacity;
+    release(first, added);
+}
+
+MeshPool::MeshPool() : vertexBufferID(0), indexBufferID(0), scratchBufferID(0), scratchSize(0), sharedVertexArrayID(0) {}
+
+void MeshPool::initialize(GLuint vertexCapacity, GLuint indexCapacity) {
+    glGenBuffers(1, &vertexBufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBufferID);
+    glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * sizeof(CookedVertex), nullptr, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &indexBufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBufferID);
+    glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity * sizeof(uint32_t), nullptr, GL_STATIC_DRAW);
+
+    vertexRanges.reset(vertexCapacity);
+    indexRanges.reset(indexCapacity);
+
+    sharedVertexArrayID = createVertexArray();
+}
+
+void MeshPool::pointVertexArray(GLuint vertexArrayID) const {
+    glBindVertexArray(vertexArrayID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(CookedVertex), reinterpret_cast<void*>(offsetof(CookedVertex, position)));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(CookedVertex), reinterpret_cast<void*>(offsetof(CookedVertex, uv)));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(CookedVertex), reinterpret_cast<void*>(offsetof(CookedVertex, normal)));
+    glEnableVertexAttribArray(2);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
+    glBindVertexArray(0);
+}
+
+GLuint MeshPool::createVertexArray() {
+    GLuint vertexArrayID = 0;
+    glGenVertexArrays(1, &vertexArrayID);
+    pointVertexArray(vertexArrayID);
+    vertexArrays.push_back(vertexArrayID);
+    return vertexArrayID;
+}
+
+void MeshPool::deleteVertexArray(GLuint vertexArrayID) {
+    auto it = std::find(vertexArrays.begin(), vertexArrays.end(), vertexArrayID);
+    if (it == vertexArrays.end()) return;
+    vertexArrays.erase(it);
+    glDeleteVertexArrays(1, &vertexArrayID);
+}
+
+MeshPool::Handle MeshPool::allocate(GLuint vertexCount, GLuint indexCount) {
+    if (vertexCount == 0 || indexCount == 0) {
+        return 0;
+    }
+
+    // Holes first, then more room
+    if (!vertexRanges.fits(vertexCount) || !indexRanges.fits(indexCount)) {
+        if (vertexRanges.getFree() >= vertexCount && indexRanges.getFree() >= indexCount) {
+            defragment();
+        }
+        grow(vertexCount, indexCount);
+    }
+
+    Entry entry;
+    entry.vertexCount = vertexCount;
+    entry.indexCount = indexCount;
+    entry.live = true;
+    vertexRanges.allocate(vertexCount, entry.firstVertex);
+    indexRanges.allocate(indexCount, entry.firstIndex);
+
+    Handle handle;
+    if (!freeHandles.empty()) {
+        handle = freeHandles.back();
+        freeHandles.pop_back();
+        entries[handle - 1] = entry;
+    } else {
+        entries.push_back(entry);
+        handle = static_cast<Handle>(entries.size());
+    }
+    return handle;
+}
+
+void MeshPool::writeVertices(Handle handle, GLuint first, const CookedVertex* vertices, GLuint count) {
+    const Entry& entry = entries[handle - 1];
+    if (first + count > entry.vertexCount) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vertexBufferID);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (entry.firstVertex + first) * sizeof(CookedVertex), count * sizeof(CookedVertex), vertices);
+}
+
+void MeshPool::writeIndices(Handle handle, GLuint first, const uint32_t* indices, GLuint count) {
+    const Entry& entry = entries[handle - 1];
+    if (first + count > entry.indexCount) return;
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, indexBufferID);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, (entry.firstIndex + first) * sizeof(uint32_t), count * sizeof(uint32_t), indices);
+}
+
+MeshPool::Handle MeshPool::add(const CookedVertex* vertices, GLuint vertexCount, const uint32_t* indices, GLuint indexCount) {
+    Handle handle = allocate(vertexCount, indexCount);
+    if (handle != 0) {
+        writeVertices(handle, 0, vertices, vertexCount);
+        writeIndices(handle, 0, indices, indexCount);
+    }
+    return handle;
+}
+
+void MeshPool::remove(Handle handle) {
+    if (handle == 0 || handle > entries.size() || !entries[handle - 1].live) return;
+
+    Entry& entry = entries[handle - 1];
+    vertexRanges.release(entry.firstVertex, entry.vertexCount);
+    indexRanges.release(entry.firstIndex, entry.indexCount);
+    entry.live = false;
+    freeHandles.push_back(handle);
+}
+
+void MeshPool::grow(GLuint vertexCount, GLuint indexCount) {
+    GLuint vertexCapacity = vertexRanges.getCapacity();
+    GLuint indexCapacity = indexRanges.getCapacity();
+
+    // The new space joins any free range at the end, so capacity plus count
+    // always fits
+    if (!vertexRanges.fits(vertexCount)) {
+        vertexCapacity = std::max(vertexCapacity + vertexCount, vertexCapacity * 2);
+    }
+    if (!indexRanges.fits(indexCount)) {
+        indexCapacity = std::max(indexCapacity + indexCount, indexCapacity * 2);
+    }
+
+    if (vertexCapacity == vertexRanges.getCapacity() && indexCapacity == indexRanges.getCapacity()) {
+        return;
+    }
+
+    if (vertexCapacity != vertexRanges.getCapacity()) {
+        growBuffer(vertexBufferID, vertexRanges.getCapacity() * sizeof(CookedVertex), vertexCapacity * sizeof(CookedVertex));
+        vertexRanges.grow(vertexCapacity);
+    }
+    if (indexCapacity != indexRanges.getCapacity()) {
+        growBuffer(indexBufferID, indexRanges.getCapacity() * sizeof(uint32_t), indexCapacity * sizeof(uint32_t));
+        indexRanges.grow(indexCapacity);
+    }
+
+    // The old buffers are gone, every vertex array reads the new ones
+    for (GLuint vertexArrayID : vertexArrays) {
+        pointVertexArray(vertexArrayID);
+    }
+
+    std::cout << "Mesh pool grown to " << vertexCapacity << " vertices, " << indexCapacity << " indices" << std::endl;
+}
+
+void MeshPool::growBuffer(GLuint& bufferID, GLsizeiptr oldSize, GLsizeiptr newSize) {
+    GLuint grown = 0;
+    glGenBuffers(1, &grown);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, grown);
+    glBufferData(GL_COPY_WRITE_BUFFER, newSize, nullptr, GL_STATIC_DRAW);
+    if (oldSize > 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, oldSize);
+    }
+    glDeleteBuffers(1, &bufferID);
+    bufferID = grown;
+}
+
+void MeshPool::moveRange(GLuint bufferID, GLintptr from, GLintptr to, GLsizeiptr size) {
+    // Copies within one buffer must not overlap, so those that would go
+    // through the scratch buffer
+    if (from < to + size && to < from + size) {
+        if (size > scratchSize) {
+            if (scratchBufferID == 0) glGenBuffers(1, &scratchBufferID);
+            scratchSize = size;
+            glBindBuffer(GL_COPY_WRITE_BUFFER, scratchBufferID);
+            glBufferData(GL_COPY_WRITE_BUFFER, scratchSize, nullptr, GL_STREAM_COPY);
+        }
+        glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, scratchBufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, 0, size);
+        glBindBuffer(GL_COPY_READ_BUFFER, scratchBufferID);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, to, size);
+        return;
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, bufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, to, size);
+}
+
+void MeshPool::defragment() {
+    std::vector<Entry*> live;
+    for (Entry& entry : entries) {
+        if (entry.live) live.push_back(&entry);
+    }
+
+    // Walking in address order, each mesh only ever moves down onto space
+    // already vacated
+    std::sort(live.begin(), live.end(), [](const Entry* a, const Entry* b) { return a->firstVertex < b->firstVertex; });
+    GLuint vertexEnd = 0;
+    for (Entry* entry : live) {
+        if (entry->firstVertex != vertexEnd) {
+            moveRange(vertexBufferID, entry->firstVertex * sizeof(CookedVertex), vertexEnd * sizeof(CookedVertex), entry->vertexCount * sizeof(CookedVertex));
+            entry->firstVertex = vertexEnd;
+        }
+        vertexEnd += entry->vertexCount;
+    }
+
+    std::sort(live.begin(), live.end(), [](const Entry* a, const Entry* b) { return a->firstIndex < b->firstIndex; });
+    GLuint indexEnd = 0;
+    for (Entry* entry : live) {
+        if (entry->firstIndex != indexEnd) {
+            moveRange(indexBufferID, entry->firstIndex * sizeof(uint32_t), indexEnd * sizeof(uint32_t), entry->indexCount * sizeof(uint32_t));
+            entry->firstIndex = indexEnd;
+        }
+        indexEnd += entry->indexCount;
+    }
+
+    vertexRanges.reset(vertexRanges.getCapacity(), vertexEnd);
+    indexRanges.reset(indexRanges.getCapacity(), indexEnd);
+}
+
+void MeshPool::cleanup() {
+    for (GLuint vertexArrayID : vertexArrays) {
+        glDeleteVertexArrays(1, &vertexArrayID);
+    }
+    vertexArrays.clear();
+    sharedVertexArrayID = 0;
+
+    if (vertexBufferID != 0) glDeleteBuffers(1, &vertexBufferID);
+    if (indexBufferID != 0) glDeleteBuffers(1, &indexBufferID);
+    if (scratchBufferID != 0) glDeleteBuffers(1, &scratchBufferID);
+    vertexBufferID = 0;
+    indexBufferID = 0;
+    scratchBufferID = 0;
+    scratchSize = 0;
+
+    vertexRanges.reset(0);
+    indexRanges.reset(0);
+    entries.clear();
+    freeHandles.clear();
+}
@@ -0,0 +1,102 @@
+#ifndef MESH_POOL_H
+#define MESH_POOL_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+#include "glad/gl.h"
+#include <utils/cooked_mesh_format.h>
+
+// First-fit allocator over [0, capacity) elements. Free ranges are kept by
+// start, so releasing one merges it with its neighbours.
+class RangeAllocator {
+public:
+    RangeAllocator();
+
+    // Everything from used on is free
+    void reset(GLuint capacity, GLuint used = 0);
+    bool allocate(GLuint count, GLuint& first);
+    void release(GLuint first, GLuint count);
+    // Adds [getCapacity(), capacity) to the free ranges
+    void grow(GLuint capacity);
+    // Whether allocate(count) would succeed
+    bool fits(GLuint count) const;
+
+    GLuint getCapacity() const { return capacity; }
+    GLuint getFree() const { return free; }
+
+private:
+    std::map<GLuint, GLuint> ranges;    // First element -> count
+    GLuint capacity;
+    GLuint free;
+};
+
+// Every static mesh's vertices and indices, suballocated out of one vertex
+// and one index buffer. Vertices are CookedVertex (position, uv, normal at
+// locations 0, 1 and 2), indices are relative to the mesh's first vertex,
+// so a mesh is drawn with its baseVertex and its indices offset by
+// firstIndex.
+//
+// Vertex arrays from createVertexArray() read the pool's buffers. They are
+// re-pointed whenever the buffers grow, so they stay valid for the life of
+// the pool; anything else the caller adds to them (per-instance attributes)
+// is left alone. getVertexArray() is one shared by the meshes that need
+// nothing else.
+//
+// GL thread only.
+class MeshPool {
+public:
+    typedef uint32_t Handle;        // 0 is no mesh
+
+    MeshPool();
+
+    void initialize(GLuint vertexCapacity, GLuint indexCapacity);
+    // Room for a mesh, compacting and then growing the buffers when they
+    // have none. Returns 0 if the mesh is empty. The contents are undefined
+    // until written, which large meshes can do a slice at a time.
+    Handle allocate(GLuint vertexCount, GLuint indexCount);
+    void writeVertices(Handle handle, GLuint first, const CookedVertex* vertices, GLuint count);
+    void writeIndices(Handle handle, GLuint first, const uint32_t* indices, GLuint count);
+    // allocate() and write the whole mesh
+    Handle add(const CookedVertex* vertices, GLuint vertexCount, const uint32_t* indices, GLuint indexCount);
+    void remove(Handle handle);
+    // Moves every mesh to the front of the buffers, closing the holes left
+    // by remove(). Where meshes live changes, handles do not.
+    void defragment();
+    void cleanup();
+
+    GLint getBaseVertex(Handle handle) const { return static_cast<GLint>(entries[handle - 1].firstVertex); }
+    GLuint getFirstIndex(Handle handle) const { return entries[handle - 1].firstIndex; }
+
+    GLuint createVertexArray();
+    void deleteVertexArray(GLuint vertexArrayID);
+    GLuint getVertexArray() const { return sharedVertexArrayID; }
+
+private:
+    struct Entry {
+        GLuint firstVertex, vertexCount;
+        GLuint firstIndex, indexCount;
+        bool live;
+    };
+
+    void pointVertexArray(GLuint vertexArrayID) const;
+    void growBuffer(GLuint& bufferID, GLsizeiptr oldSize, GLsizeiptr newSize);
+    void moveRange(GLuint bufferID, GLintptr from, GLintptr to, GLsizeiptr size);
+    void grow(GLuint vertexCount, GLuint indexCount);
+
+    GLuint vertexBufferID;
+    GLuint indexBufferID;
+    GLuint scratchBufferID;         // For moves whose source and destination overlap
+    GLsizeiptr scratchSize;
+    GLuint sharedVertexArrayID;
+
+    RangeAllocator vertexRanges;
+    RangeAllocator indexRanges;
+    std::vector<Entry> entries;     // By handle - 1
+    std::vector<Handle> freeHandles;
+    std::vector<GLuint> vertexArrays;
+};
+
+extern MeshPool meshPool;
+
+#endif // MESH_POOL_H
@@ -0,0 +1,297 @@
+#include "program_cache.h"
+#include "frame_uniforms.h"
+#include "shader_sources.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <utils/gl_ext.h>
+#include <utils/mapped_file.h>
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+ProgramCache programCache;
+
+namespace {
+
+const uint32_t PROGRAM_BINARY_MAGIC = 0x42504546u;    // "FEPB"
+
+struct ProgramBinaryHeader {
+    uint32_t magic;
+    uint32_t format;
+    uint32_t length;
+    uint32_t pad;
+    uint64_t driverHash;
+    uint64_t sourceHash;
+};
+
+uint64_t hashString(const std::string& s, uint64_t hash = 14695981039346656037ull) {
+    for (unsigned char c : s) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string glString(GLenum name) {
+    const char* s = reinterpret_cast<const char*>(glGetString(name));
+    return s ? s : "";
+}
+
+void printShaderLog(GLuint shaderID, const std::string& name) {
+    GLint result = GL_FALSE;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &result);
+    if (result) {
+        return;
+    }
+
+    std::cerr << "Error compiling shader : " << name << std::endl;
+    GLint infoLogLength = 0;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
+    if (infoLogLength > 0) {
+        std::vector<char> message(infoLogLength + 1);
+        glGetShaderInfoLog(shaderID, infoLogLength, NULL, &message[0]);
+        std::cerr << &message[0] << std::endl;
+    }
+}
+
+}
+
+ProgramCache::ProgramCache() : driverHash(0), binariesSupported(false) {}
+
+void ProgramCache::initialize(const std::string& cacheDir) {
+    this->cacheDir = cacheDir;
+#ifdef _WIN32
+    _mkdir(cacheDir.c_str());
+#else
+    mkdir(cacheDir.c_str(), 0755);
+#endif
+
+    // Binaries are only valid for the exact driver that produced them
+    driverHash = hashString(glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION));
+
+    GLint binaryFormats = 0;
+    if (glExtGetProgramBinary && glExtProgramBinary) {
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+    }
+    binariesSupported = binaryFormats > 0;
+
+    // Let the driver pick how many compiler threads to use
+    if (glExtMaxShaderCompilerThreads) {
+        glExtMaxShaderCompilerThreads(0xFFFFFFFFu);
+    }
+}
+
+void ProgramCache::precompile(const std::string& vertexPath, const std::string& fragmentPath) {
+    uint64_t sourceHash;
+    find(vertexPath, fragmentPath, sourceHash);
+}
+
+GLuint ProgramCache::get(const std::string& vertexPath, const std::string& fragmentPath) {
+    uint64_t sourceHash;
+    Program* program = find(vertexPath, fragmentPath, sourceHash);
+    if (!program || !finalize(*program, sourceHash)) {
+        return 0;
+    }
+    return program->programID;
+}
+
+void ProgramCache::cleanup() {
+    for (auto& entry : programs) {
+        Program& program = entry.second;
+        if (program.vertexShaderID != 0) glDeleteShader(program.vertexShaderID);
+        if (program.fragmentShaderID != 0) glDeleteShader(program.fragmentShaderID);
+        if (program.programID != 0) glDeleteProgram(program.programID);
+    }
+    programs.clear();
+    pathHashes.clear();
+}
+
+ProgramCache::Program* ProgramCache::find(const std::string& vertexPath, const std::string& fragmentPath, uint64_t& sourceHash) {
+    auto key = std::make_pair(vertexPath, fragmentPath);
+    auto known = pathHashes.find(key);
+    if (known != pathHashes.end()) {
+        sourceHash = known->second;
+        return &programs[sourceHash];
+    }
+
+    std::string vertexSource, fragmentSource;
+    if (!LoadShaderSource(vertexPath, vertexSource)) {
+        std::cerr << "Vertex shader not found " << vertexPath << std::endl;
+        return nullptr;
+    }
+    if (!LoadShaderSource(fragmentPath, fragmentSource)) {
+        std::cerr << "Fragment shader not found " << fragmentPath << std::endl;
+        return nullptr;
+    }
+
+    // Different paths with identical sources share one program
+    sourceHash = hashString(fragmentSource, hashString(vertexSource));
+    pathHashes[key] = sourceHash;
+    auto existing = programs.find(sourceHash);
+    if (existing != programs.end()) {
+        return &existing->second;
+    }
+
+    Program& program = programs[sourceHash];
+    program.programID = 0;
+    program.vertexShaderID = 0;
+    program.fragmentShaderID = 0;
+    program.fromBinary = false;
+    program.finalized = false;
+    program.failed = false;
+    program.vertexSource = std::move(vertexSource);
+    program.fragmentSource = std::move(fragmentSource);
+    program.name = vertexPath + " + " + fragmentPath;
+
+    if (!loadBinary(program, sourceHash)) {
+        compile(program);
+    }
+    return &program;
+}
+
+void ProgramCache::compile(Program& program) {
+    if (program.programID == 0) {
+        program.programID = glCreateProgram();
+    }
+
+    program.vertexShaderID = glCreateShader(GL_VERTEX_SHADER);
+    const char* vertexSourcePointer = program.vertexSource.c_str();
+    glShaderSource(program.vertexShaderID, 1, &vertexSourcePointer, NULL);
+    glCompileShader(program.vertexShaderID);
+
+    program.fragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+    const char* fragmentSourcePointer = program.fragmentSource.c_str();
+    glShaderSource(program.fragmentShaderID, 1, &fragmentSourcePointer, NULL);
+    glCompileShader(program.fragmentShaderID);
+
+    // No status queries here, linking straight away keeps the driver busy
+    glAttachShader(program.programID, program.vertexShaderID);
+    glAttachShader(program.programID, program.fragmentShaderID);
+    if (binariesSupported && glExtProgramParameteri) {
+        glExtProgramParameteri(program.programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glLinkProgram(program.programID);
+    program.fromBinary = false;
+}
+
+bool ProgramCache::finalize(Program& program, uint64_t sourceHash) {
+    if (program.finalized) {
+        return !program.failed;
+    }
+    program.finalized = true;
+
+    GLint result = GL_FALSE;
+    glGetProgramiv(program.programID, GL_LINK_STATUS, &result);
+
+    // A driver update can reject an old binary, rebuild it from source
+    if (!result && program.fromBinary) {
+        compile(program);
+        glGetProgramiv(program.programID, GL_LINK_STATUS, &result);
+    }
+
+    if (!result) {
+        printShaderLog(program.vertexShaderID, program.name);
+        printShaderLog(program.fragmentShaderID, program.name);
+
+        std::cerr << "Error linking program : " << program.name << std::endl;
+        GLint infoLogLength = 0;
+        glGetProgramiv(program.programID, GL_INFO_LOG_LENGTH, &infoLogLength);
+        if (infoLogLength > 0) {
+            std::vector<char> message(infoLogLength + 1);
+            glGetProgramInfoLog(program.programID, infoLogLength, NULL, &message[0]);
+            std::cerr << &message[0] << std::endl;
+        }
+
+        program.failed = true;
+    }
+
+    if (program.vertexShaderID != 0) {
+        glDetachShader(program.programID, program.vertexShaderID);
+        glDeleteShader(program.vertexShaderID);
+        program.vertexShaderID = 0;
+    }
+    if (program.fragmentShaderID != 0) {
+        glDetachShader(program.programID, program.fragmentShaderID);
+        glDeleteShader(program.fragmentShaderID);
+        program.fragmentShaderID = 0;
+    }
+
+    if (program.failed) {
+        glDeleteProgram(program.programID);
+        program.programID = 0;
+    } else {
+        FrameUniforms::attach(program.programID);
+        if (!program.fromBinary) {
+            saveBinary(program, sourceHash);
+        }
+    }
+
+    program.vertexSource.clear();
+    program.fragmentSource.clear();
+    return !program.failed;
+}
+
+bool ProgramCache::loadBinary(Program& program, uint64_t sourceHash) {
+    if (!binariesSupported || cacheDir.empty()) {
+        return false;
+    }
+
+    MappedFile file;
+    if (!file.open(binaryPath(sourceHash)) || file.size() < sizeof(ProgramBinaryHeader)) {
+        return false;
+    }
+
+    ProgramBinaryHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (header.magic != PROGRAM_BINARY_MAGIC || header.driverHash != driverHash ||
+        header.sourceHash != sourceHash || header.length > file.size() - sizeof(header)) {
+        return false;
+    }
+
+    program.programID = glCreateProgram();
+    glExtProgramBinary(program.programID, header.format, file.data() + sizeof(header), static_cast<GLsizei>(header.length));
+    program.fromBinary = true;
+    return true;
+}
+
+void ProgramCache::saveBinary(const Program& program, uint64_t sourceHash) {
+    if (!binariesSupported || cacheDir.empty()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program.programID, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    std::vector<uint8_t> binary(length);
+    ProgramBinaryHeader header = {};
+    GLsizei written = 0;
+    GLenum format = 0;
+    glExtGetProgramBinary(program.programID, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+
+    header.magic = PROGRAM_BINARY_MAGIC;
+    header.format = format;
+    header.length = static_cast<uint32_t>(written);
+    header.driverHash = driverHash;
+    header.sourceHash = sourceHash;
+
+    std::ofstream file(binaryPath(sourceHash), std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(binary.data()), written);
+}
+
+std::string ProgramCache::binaryPath(uint64_t sourceHash) const {
+    std::stringstream path;
+    path << cacheDir << "/" << std::hex << (sourceHash ^ driverHash) << ".bin";
+    return path.str();
+}
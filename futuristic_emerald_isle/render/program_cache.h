@@ -0,0 +1,58 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/gl.h>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+// Owns every linked program in the game. Programs are deduplicated by the
+// hash of their sources, so callers asking for the same pair of shaders get
+// the same handle and must not delete it themselves.
+//
+// precompile() only issues the GL calls; compile and link status are first
+// queried in get(), which gives the driver (and KHR_parallel_shader_compile
+// where available) the chance to work on every program at once. Linked
+// binaries are written to cacheDir keyed by the driver string, so a warm
+// start skips GLSL compilation entirely.
+class ProgramCache {
+public:
+    ProgramCache();
+
+    void initialize(const std::string& cacheDir);
+    void precompile(const std::string& vertexPath, const std::string& fragmentPath);
+    GLuint get(const std::string& vertexPath, const std::string& fragmentPath);
+    void cleanup();
+
+private:
+    struct Program {
+        GLuint programID;
+        GLuint vertexShaderID;
+        GLuint fragmentShaderID;
+        bool fromBinary;
+        bool finalized;
+        bool failed;
+        std::string vertexSource;
+        std::string fragmentSource;
+        std::string name;
+    };
+
+    Program* find(const std::string& vertexPath, const std::string& fragmentPath, uint64_t& sourceHash);
+    void compile(Program& program);
+    bool finalize(Program& program, uint64_t sourceHash);
+    bool loadBinary(Program& program, uint64_t sourceHash);
+    void saveBinary(const Program& program, uint64_t sourceHash);
+    std::string binaryPath(uint64_t sourceHash) const;
+
+    std::map<uint64_t, Program> programs;
+    std::map<std::pair<std::string, std::string>, uint64_t> pathHashes;
+
+    std::string cacheDir;
+    uint64_t driverHash;
+    bool binariesSupported;
+};
+
+extern ProgramCache programCache;
+
+#endif // PROGRAM_CACHE_H
@@ -0,0 +1,163 @@
+#include "render_queue.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Key fields from the most significant bit down
+const int PASS_BITS = 2;
+const int PROGRAM_BITS = 8;
+const int MATERIAL_BITS = 12;
+const int VERTEX_ARRAY_BITS = 14;
+const int DEPTH_BITS = 28;
+static_assert(PASS_BITS + PROGRAM_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS + DEPTH_BITS == 64, "key fields must fill 64 bits");
+
+const int RADIX_BITS = 8;
+const size_t RADIX_BUCKETS = size_t(1) << RADIX_BITS;
+
+uint64_t field(uint64_t value, int bits) {
+    return value & ((uint64_t(1) << bits) - 1);
+}
+
+}
+
+uint64_t RenderQueue::makeKey(Pass pass, GLuint program, GLuint material, GLuint vertexArray, float depth) {
+    // A non-negative float orders the same as its bits, the top ones are enough
+    uint32_t depthBits;
+    depth = std::max(depth, 0.0f);
+    memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    uint64_t key = field(pass, PASS_BITS);
+    key = key << PROGRAM_BITS | field(program, PROGRAM_BITS);
+    key = key << MATERIAL_BITS | field(material, MATERIAL_BITS);
+    key = key << VERTEX_ARRAY_BITS | field(vertexArray, VERTEX_ARRAY_BITS);
+    key = key << DEPTH_BITS | field(depthBits >> (31 - DEPTH_BITS), DEPTH_BITS);
+    return key;
+}
+
+RenderQueue::RenderQueue() : view() {}
+
+void RenderQueue::initialize() {
+    stream.initialize(STREAM_REGION_SIZE);
+}
+
+void RenderQueue::begin(const RenderView& view) {
+    this->view = view;
+    stream.beginFrame();
+    frameUniforms.update(view, stream);
+    items.clear();
+}
+
+void RenderQueue::submit(const DrawItem& item) {
+    items.push_back(item);
+}
+
+void RenderQueue::sort() {
+    order.resize(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        order[i] = std::make_pair(items[i].key, static_cast<uint32_t>(i));
+    }
+
+    // Least significant digit first, stable, so equal keys keep submission
+    // order. A digit every key shares is skipped.
+    scratch.resize(order.size());
+    uint32_t offsets[RADIX_BUCKETS];
+    for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+        std::fill(offsets, offsets + RADIX_BUCKETS, 0);
+        for (const auto& entry : order) {
+            offsets[(entry.first >> shift) & (RADIX_BUCKETS - 1)]++;
+        }
+        if (offsets[(order[0].first >> shift) & (RADIX_BUCKETS - 1)] == order.size()) {
+            continue;
+        }
+
+        uint32_t total = 0;
+        for (uint32_t& offset : offsets) {
+            uint32_t count = offset;
+            offset = total;
+            total += count;
+        }
+        for (const auto& entry : order) {
+            scratch[offsets[(entry.first >> shift) & (RADIX_BUCKETS - 1)]++] = entry;
+        }
+        order.swap(scratch);
+    }
+}
+
+void RenderQueue::setSamplers(GLuint program) {
+    // Samplers never change, they are set the first time the program is
+    // seen. It is bound by then.
+    if (!programs.insert(program).second) {
+        return;
+    }
+    GLint textureSampler = glGetUniformLocation(program, "textureSampler");
+    GLint normalMapSampler = glGetUniformLocation(program, "normalMapSampler");
+    if (textureSampler >= 0) glUniform1i(textureSampler, 0);
+    if (normalMapSampler >= 0) glUniform1i(normalMapSampler, 1);
+}
+
+void RenderQueue::flush() {
+    stats = RenderStats();
+    stats.items = static_cast<uint32_t>(items.size());
+
+    // Everything the draws read is written by now
+    stream.endWrites();
+    if (items.empty()) {
+        stream.endFrame();
+        return;
+    }
+
+    sort();
+
+    // Nothing is known to be bound when the flush starts
+    bool first = true;
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    GLuint textures[2] = {0, 0};
+
+    for (const auto& entry : order) {
+        const DrawItem& item = items[entry.second];
+
+        if (first || item.program != program) {
+            program = item.program;
+            glUseProgram(program);
+            setSamplers(program);
+            stats.programBinds++;
+        } else {
+            stats.programSkips++;
+        }
+
+        if (first || item.vertexArray != vertexArray) {
+            vertexArray = item.vertexArray;
+            glBindVertexArray(vertexArray);
+            stats.vertexArrayBinds++;
+        } else {
+            stats.vertexArraySkips++;
+        }
+
+        for (GLuint unit = 0; unit < 2; ++unit) {
+            if (item.textures[unit] == 0) continue;
+            if (first || item.textures[unit] != textures[unit]) {
+                textures[unit] = item.textures[unit];
+                glActiveTexture(GL_TEXTURE0 + unit);
+                glBindTexture(GL_TEXTURE_2D, textures[unit]);
+                stats.textureBinds++;
+            } else {
+                stats.textureSkips++;
+            }
+        }
+
+        first = false;
+        item.draw(item, view);
+    }
+
+    glBindVertexArray(0);
+    stream.endFrame();
+    items.clear();
+}
+
+void RenderQueue::cleanup() {
+    stream.cleanup();
+    items.clear();
+    programs.clear();
+}
@@ -0,0 +1,109 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "glad/gl.h"
+#include "frame_uniforms.h"
+#include "stream_buffer.h"
+
+// What every draw of a frame shares
+struct RenderView {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 vp;
+    glm::vec3 cameraPosition;
+    glm::vec3 lightPosition;
+    glm::vec3 lightIntensity;
+};
+
+struct DrawItem;
+typedef void (*DrawFunction)(const DrawItem& item, const RenderView& view);
+
+// One draw. The queue binds program, vertex array and textures; draw sets
+// whatever is particular to the item and issues the draw call. owner,
+// index and count are the submitter's to use.
+struct DrawItem {
+    uint64_t key;
+    GLuint program;
+    GLuint vertexArray;
+    GLuint textures[2];             // Units 0 and 1, 0 leaves the unit as it is
+    DrawFunction draw;
+    const void* owner;
+    uint32_t index;
+    GLsizei count;
+};
+
+// State changes of the last flush, made and skipped because the previous
+// item already had the same state bound
+struct RenderStats {
+    uint32_t items = 0;
+    uint32_t programBinds = 0, programSkips = 0;
+    uint32_t vertexArrayBinds = 0, vertexArraySkips = 0;
+    uint32_t textureBinds = 0, textureSkips = 0;
+
+    uint32_t binds() const { return programBinds + vertexArrayBinds + textureBinds; }
+    uint32_t skips() const { return programSkips + vertexArraySkips + textureSkips; }
+};
+
+// Collects the draws of a frame, sorts them by key and submits them,
+// binding only what differs from the previous item. Keys order by pass,
+// then program, material and vertex array so items sharing state end up
+// next to each other, then by depth, front to back, for early depth
+// rejection. The view goes to the shaders once per frame, through the
+// Frame uniform block (see frame_uniforms.h), so no item sets it itself.
+//
+// The queue also owns the frame's stream buffer. Data the draws read and
+// the next frame replaces (instances, indirect commands) is allocated from
+// getStream() between begin() and flush().
+//
+// GL thread only. Submitters may bind vertex arrays of their own while
+// submitting; the queue assumes nothing about bound state until flush().
+class RenderQueue {
+public:
+    enum Pass {
+        PASS_OPAQUE = 0,
+        PASS_SKY = 1                // After everything opaque, so covered sky is never shaded
+    };
+
+    // Program, material and vertex array are GL names folded into their
+    // fields. Names that collide only sort together, binds compare the
+    // full names. depth is a distance from the camera, >= 0.
+    static uint64_t makeKey(Pass pass, GLuint program, GLuint material, GLuint vertexArray, float depth);
+
+    // Per region of the stream buffer, grown when a frame needs more
+    static const GLsizeiptr STREAM_REGION_SIZE = 2 * 1024 * 1024;
+
+    RenderQueue();
+
+    void initialize();
+    // Starts a stream frame, writes the view to the Frame block and starts
+    // collecting
+    void begin(const RenderView& view);
+    void submit(const DrawItem& item);
+    // Sorts, submits and clears. Leaves no vertex array bound, so later
+    // buffer setup cannot change one by accident.
+    void flush();
+    void cleanup();
+
+    const RenderView& getView() const { return view; }
+    const RenderStats& getStats() const { return stats; }
+    StreamBuffer& getStream() { return stream; }
+
+private:
+    void sort();
+    void setSamplers(GLuint program);
+
+    RenderView view;
+    RenderStats stats;
+    FrameUniforms frameUniforms;
+    StreamBuffer stream;
+    std::vector<DrawItem> items;
+    std::vector<std::pair<uint64_t, uint32_t>> order, scratch;
+    std::unordered_set<GLuint> programs;
+};
+
+#endif // RENDER_QUEUE_H
@@ -4,6 +4,7 @@
 #include <glad/gl.h>
 #include <string>
 
+// Returns the cached program for this pair of shaders, owned by programCache
 GLuint LoadShadersFromFile(const char *vertex_file_path, const char *fragment_file_path);
 
 GLuint LoadShadersFromString(std::string VertexShaderCode, std::string FragmentShaderCode);
@@ -0,0 +1,49 @@
+#include "shader_sources.h"
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <embedded_shaders.h>
+
+namespace {
+
+bool readEmbedded(const std::string& path, std::string& out) {
+    size_t dir = path.rfind("shaders/");
+    std::string name = dir == std::string::npos ? path : path.substr(dir + strlen("shaders/"));
+
+    for (size_t i = 0; i < EMBEDDED_SHADER_COUNT; ++i) {
+        if (name == EMBEDDED_SHADERS[i].path) {
+            out = EMBEDDED_SHADERS[i].source;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readFromDisk(const std::string& path, std::string& out) {
+    std::ifstream stream(path, std::ios::in);
+    if (!stream.is_open()) {
+        return false;
+    }
+    std::stringstream sstr;
+    sstr << stream.rdbuf();
+    out = sstr.str();
+    return true;
+}
+
+}
+
+bool LoadShaderSource(const std::string& path, std::string& out) {
+#ifdef SHADERS_FROM_DISK
+    if (readFromDisk(path, out)) {
+        return true;
+    }
+#endif
+    if (readEmbedded(path, out)) {
+        return true;
+    }
+#ifndef SHADERS_FROM_DISK
+    return readFromDisk(path, out);
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,12 @@
+#ifndef SHADER_SOURCES_H
+#define SHADER_SOURCES_H
+
+#include <string>
+
+// Looks a shader up by the path the game uses for it (anything ending in
+// "shaders/<name>"). Release builds serve the copy embedded at build time
+// and only touch the disk for shaders that were not embedded; configure
+// with SHADERS_FROM_DISK to edit shaders without rebuilding.
+bool LoadShaderSource(const std::string& path, std::string& out);
+
+#endif // SHADER_SOURCES_H
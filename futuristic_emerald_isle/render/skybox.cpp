@@ -4,7 +4,9 @@
 #include <iostream>
 #include <utils/load_textures.h>
 
-void Skybox::initialize(glm::vec3 position, glm::vec3 scale) {
+const char* const Skybox::TEXTURE_PATH = "../futuristic_emerald_isle/assets/skyboxes/sky.png";
+
+void Skybox::initialize(glm::vec3 position, glm::vec3 scale, const std::vector<uint8_t>& texture) {
     this->position = position;
     this->scale = scale;
 
@@ -14,74 +16,69 @@ void Skybox::initialize(glm::vec3 position, glm::vec3 scale) {
     glGenBuffers(1, &vertexBufferID);
     glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertex_buffer_data), vertex_buffer_data, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(0);
 
     glGenBuffers(1, &colorBufferID);
     glBindBuffer(GL_ARRAY_BUFFER, colorBufferID);
     glBufferData(GL_ARRAY_BUFFER, sizeof(color_buffer_data), color_buffer_data, GL_STATIC_DRAW);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(1);
 
     glGenBuffers(1, &uvBufferID);
     glBindBuffer(GL_ARRAY_BUFFER, uvBufferID);
     glBufferData(GL_ARRAY_BUFFER, sizeof(uv_buffer_data), uv_buffer_data, GL_STATIC_DRAW);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 0, 0);
+    glEnableVertexAttribArray(2);
 
     glGenBuffers(1, &indexBufferID);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(index_buffer_data), index_buffer_data, GL_STATIC_DRAW);
 
+    // The VAO keeps the attributes and the index buffer from here on
+    glBindVertexArray(0);
+
     programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/skybox.vert", "../futuristic_emerald_isle/shaders/skybox.frag");
     if (programID == 0)
     {
         std::cerr << "Failed to load shaders." << std::endl;
     }
 
-    mvpMatrixID = glGetUniformLocation(programID, "MVP");
+    // The sky never moves, its model matrix is set once
+    glm::mat4 modelMatrix = glm::scale(glm::mat4(), scale);
+    modelMatrixID = glGetUniformLocation(programID, "modelMatrix");
+    glUseProgram(programID);
+    glUniformMatrix4fv(modelMatrixID, 1, GL_FALSE, &modelMatrix[0][0]);
 
-    textureID = LoadTextureTileBox("../futuristic_emerald_isle/assets/skyboxes/sky.png");
+    textureID = texture.empty() ? 0 : LoadCookedTexture(texture.data(), texture.size());
+    if (textureID == 0) {
+        textureID = LoadTextureTileBox(TEXTURE_PATH);
+    }
 
     textureSamplerID  = glGetUniformLocation(programID,"textureSampler");
 }
 
-void Skybox::render(glm::mat4 cameraMatrix) {
-    glUseProgram(programID);
-
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, colorBufferID);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
-
-    glm::mat4 modelMatrix = glm::mat4();
-    modelMatrix = glm::scale(modelMatrix, scale);
-
-    glm::mat4 mvp = cameraMatrix * modelMatrix;
-    glUniformMatrix4fv(mvpMatrixID, 1, GL_FALSE, &mvp[0][0]);
-
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ARRAY_BUFFER, uvBufferID);
-    glVertexAttribPointer(2,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        0,
-        0);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glUniform1i(textureSamplerID, 0);
+void Skybox::submit(RenderQueue& queue) const {
+    DrawItem item;
+    item.key = RenderQueue::makeKey(RenderQueue::PASS_SKY, programID, textureID, vertexArrayID, 0.0f);
+    item.program = programID;
+    item.vertexArray = vertexArrayID;
+    item.textures[0] = textureID;
+    item.textures[1] = 0;
+    item.draw = draw;
+    item.owner = this;
+    item.index = 0;
+    item.count = 1;
+    queue.submit(item);
+}
 
+void Skybox::draw(const DrawItem&, const RenderView&) {
     glDrawElements(
         GL_TRIANGLES,
         36,
         GL_UNSIGNED_INT,
         (void*)0
     );
-
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
 }
 
 void Skybox::cleanup() {
@@ -91,5 +88,4 @@ void Skybox::cleanup() {
     glDeleteVertexArrays(1, &vertexArrayID);
     glDeleteBuffers(1, &uvBufferID);
     glDeleteTextures(1, &textureID);
-    glDeleteProgram(programID);
 }
\ No newline at end of file
@@ -3,6 +3,8 @@
 
 #include <glad/gl.h>
 #include <glm/glm.hpp>
+#include "render_queue.h"
+#include <cstdint>
 #include <vector>
 #include <string>
 
@@ -18,14 +20,21 @@ struct Skybox {
 	GLuint uvBufferID;
 	GLuint textureID;
 
-	GLuint mvpMatrixID;
+	GLuint modelMatrixID;
 	GLuint textureSamplerID;
 	GLuint programID;
 
-    void initialize(glm::vec3 position, glm::vec3 scale);
-    void render(glm::mat4 cameraMatrix);
+    static const char* const TEXTURE_PATH;
+
+    // texture is the cooked sky texture, which can be read off the GL
+    // thread; empty loads it from TEXTURE_PATH here
+    void initialize(glm::vec3 position, glm::vec3 scale, const std::vector<uint8_t>& texture = std::vector<uint8_t>());
+    // Drawn after everything opaque, only where nothing else covers the sky
+    void submit(RenderQueue& queue) const;
     void cleanup();
 
+    static void draw(const DrawItem& item, const RenderView& view);
+
 	GLfloat vertex_buffer_data[72] = {
 		// Front face
 		-1.0f, -1.0f, 1.0f,
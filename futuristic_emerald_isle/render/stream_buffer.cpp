@@ -0,0 +1,154 @@
+#include "stream_buffer.h"
+#include <algorithm>
+#include <iostream>
+#include <utils/gl_ext.h>
+
+namespace {
+
+// Regions start on this boundary, so any alignment up to it carries over
+// from region-relative to buffer offsets. Covers every uniform buffer
+// offset alignment seen in practice.
+const GLsizeiptr REGION_ALIGNMENT = 256;
+
+const GLuint64 FENCE_POLL_NANOSECONDS = 1000000;
+
+GLsizeiptr alignUp(GLsizeiptr value, GLsizeiptr alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+}
+
+StreamBuffer::StreamBuffer() : bufferID(0), persistent(false), regionSize(0), region(0), mapped(nullptr), used(0), wanted(0) {
+    std::fill(fences, fences + REGIONS, nullptr);
+}
+
+void StreamBuffer::initialize(GLsizeiptr regionSize) {
+    create(regionSize);
+    std::cout << "Stream buffer: " << (persistent ? REGIONS : 1) << " x " << this->regionSize / 1024 << " KB, "
+              << (persistent ? "persistent mapping" : "orphaned every frame") << std::endl;
+}
+
+void StreamBuffer::create(GLsizeiptr size) {
+    regionSize = alignUp(std::max<GLsizeiptr>(size, REGION_ALIGNMENT), REGION_ALIGNMENT);
+    region = 0;
+    used = 0;
+    wanted = 0;
+    mapped = nullptr;
+
+    // COPY_WRITE is bound for mapping only, so no draw state is disturbed
+    glGenBuffers(1, &bufferID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+
+    persistent = false;
+    if (glExtBufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glExtBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * REGIONS, nullptr, flags);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * REGIONS, flags));
+        persistent = mapped != nullptr;
+        if (!persistent) {
+            // Storage is immutable, start over with a plain buffer
+            glDeleteBuffers(1, &bufferID);
+            glGenBuffers(1, &bufferID);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+        }
+    }
+
+    if (!persistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+void StreamBuffer::destroy() {
+    for (int i = 0; i < REGIONS; ++i) {
+        waitForRegion(i);
+    }
+
+    if (bufferID != 0) {
+        if (mapped) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glDeleteBuffers(1, &bufferID);
+    }
+    bufferID = 0;
+    mapped = nullptr;
+}
+
+void StreamBuffer::waitForRegion(int region) {
+    if (!fences[region]) {
+        return;
+    }
+
+    GLenum status = GL_TIMEOUT_EXPIRED;
+    while (status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_POLL_NANOSECONDS);
+    }
+    glDeleteSync(fences[region]);
+    fences[region] = nullptr;
+}
+
+void StreamBuffer::beginFrame() {
+    if (bufferID == 0) {
+        return;
+    }
+
+    // Last frame ran out of room, make enough for it and then some
+    if (wanted > regionSize) {
+        GLsizeiptr size = std::max(wanted + wanted / 2, regionSize * 2);
+        destroy();
+        create(size);
+        std::cout << "Stream buffer grown to " << (persistent ? REGIONS : 1) << " x " << regionSize / 1024 << " KB" << std::endl;
+    }
+    used = 0;
+    wanted = 0;
+
+    if (persistent) {
+        region = (region + 1) % REGIONS;
+        waitForRegion(region);
+    } else {
+        // Orphan, so the driver hands out fresh storage while the GPU
+        // still reads last frame's
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+        mapped = static_cast<uint8_t*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment) {
+    // wanted advances whether or not this fits, so a frame that runs out
+    // grows the buffer to hold all of it rather than its largest request
+    GLsizeiptr start = alignUp(used, alignment);
+    wanted = alignUp(wanted, alignment) + size;
+    if (!mapped || start + size > regionSize) {
+        return {nullptr, 0};
+    }
+    used = start + size;
+
+    GLintptr base = persistent ? region * regionSize : 0;
+    return {mapped + base + start, base + start};
+}
+
+void StreamBuffer::endWrites() {
+    if (persistent || !mapped) {
+        return;
+    }
+
+    // Nothing can be drawn from a buffer while it is mapped
+    glBindBuffer(GL_COPY_WRITE_BUFFER, bufferID);
+    if (glUnmapBuffer(GL_COPY_WRITE_BUFFER) == GL_FALSE) {
+        std::cerr << "Stream buffer contents were lost, this frame may draw garbage" << std::endl;
+    }
+    mapped = nullptr;
+}
+
+void StreamBuffer::endFrame() {
+    if (persistent) {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+}
+
+void StreamBuffer::cleanup() {
+    endWrites();
+    destroy();
+    regionSize = 0;
+}
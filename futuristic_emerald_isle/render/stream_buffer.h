@@ -0,0 +1,60 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <cstdint>
+#include "glad/gl.h"
+
+// Ring of GPU-visible memory for the data a frame writes once and draws
+// once: instance transforms, indirect commands, the Frame uniform block.
+// Callers get sub-allocations and write straight into them.
+//
+// With ARB_buffer_storage the buffer is mapped persistent and coherent
+// once, split into REGIONS regions used in turn, and a fence per region
+// keeps the CPU from overwriting one the GPU still reads. Without it the
+// buffer is orphaned and mapped every frame, which leaves the waiting to
+// the driver.
+//
+// A frame is beginFrame(), allocations, endWrites() before the first draw
+// that reads them, then endFrame() after the last.
+class StreamBuffer {
+public:
+    static const int REGIONS = 3;
+
+    struct Allocation {
+        void* data;                 // nullptr when the frame is out of room
+        GLintptr offset;            // Into getBuffer()
+    };
+
+    StreamBuffer();
+
+    // GL thread, as is everything else
+    void initialize(GLsizeiptr regionSize);
+    void beginFrame();
+    // alignment must be a power of two. Out of room, the allocation is
+    // empty and the region grows at the next beginFrame() to fit everything
+    // the frame asked for.
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    void endWrites();
+    void endFrame();
+    void cleanup();
+
+    GLuint getBuffer() const { return bufferID; }
+    bool isPersistent() const { return persistent; }
+
+private:
+    void create(GLsizeiptr regionSize);
+    void destroy();
+    void waitForRegion(int region);
+
+    GLuint bufferID;
+    bool persistent;
+    GLsizeiptr regionSize;
+    int region;
+
+    uint8_t* mapped;                // Whole buffer when persistent, this frame's region otherwise
+    GLsizeiptr used;
+    GLsizeiptr wanted;              // All this frame asked for, fitted or not, for growing
+    GLsync fences[REGIONS];
+};
+
+#endif // STREAM_BUFFER_H
@@ -6,153 +6,198 @@
 #include <sstream>
 
 #include "shader.h"
+#include <utils/job_system.h>
 #include <utils/load_textures.h>
 
 #include "Skybox.h"
 #include "Skybox.h"
 
-void Terrain::initialize(int width, int depth, float maxHeight, float repeatFactor) {
-    this->width = width;
-    this->depth = depth;
-    this->maxHeight = maxHeight;
+namespace {
 
-    float halfWidth = width / 2.0f;
-    float halfDepth = depth / 2.0f;
+// Rows per job when building the grid
+const size_t ROW_GRAIN = 16;
 
-    normals.resize((width + 1) * (depth + 1), glm::vec3(0.0f));
+// Vertices per job in the hilltop search
+const size_t HIGHEST_BLOCK = 1 << 16;
 
-    for (int z = 0; z <= depth; ++z) {
-        for (int x = 0; x <= width; ++x) {
-            float worldX = x - halfWidth;
-            float worldZ = z - halfDepth;
+// Vertices interleaved and written to the mesh pool at a time
+const size_t UPLOAD_SLICE_VERTICES = 1 << 16;
 
-            float height = sin(worldX * 0.03f) * cos(worldZ * 0.03f) * maxHeight;
+}
 
-            vertices.emplace_back(glm::vec3(worldX, height, worldZ));
+void Terrain::initialize(int width, int depth, float maxHeight, float repeatFactor) {
+    generate(width, depth, maxHeight, repeatFactor);
+    upload(std::vector<uint8_t>());
+}
 
-            uvs.emplace_back(glm::vec2(x / (float)width, z / (float)depth) * repeatFactor);
-        }
-    }
+void Terrain::generate(int width, int depth, float maxHeight, float repeatFactor) {
+    this->width = width;
+    this->depth = depth;
+    this->maxHeight = maxHeight;
 
-    for (int z = 0; z < depth; ++z) {
-        for (int x = 0; x < width; ++x) {
-            GLuint topLeft = z * (width + 1) + x;
-            GLuint topRight = topLeft + 1;
-            GLuint bottomLeft = (z + 1) * (width + 1) + x;
-            GLuint bottomRight = bottomLeft + 1;
-
-            indices.push_back(topLeft);
-            indices.push_back(bottomLeft);
-            indices.push_back(topRight);
-            indices.push_back(topRight);
-            indices.push_back(bottomLeft);
-            indices.push_back(bottomRight);
-
-            glm::vec3 v0 = vertices[topLeft];
-            glm::vec3 v1 = vertices[bottomLeft];
-            glm::vec3 v2 = vertices[topRight];
-            glm::vec3 normal1 = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-
-            glm::vec3 v3 = vertices[topRight];
-            glm::vec3 v4 = vertices[bottomLeft];
-            glm::vec3 v5 = vertices[bottomRight];
-            glm::vec3 normal2 = glm::normalize(glm::cross(v4 - v3, v5 - v3));
-
-            normals[topLeft] += normal1;
-            normals[bottomLeft] += normal1 + normal2;
-            normals[topRight] += normal1 + normal2;
-            normals[bottomRight] += normal2;
-        }
-    }
+    float halfWidth = width / 2.0f;
+    float halfDepth = depth / 2.0f;
+    size_t rowVertices = width + 1;
+
+    vertices.resize(rowVertices * (depth + 1));
+    uvs.resize(rowVertices * (depth + 1));
+    normals.resize(rowVertices * (depth + 1));
+    indices.resize(static_cast<size_t>(width) * depth * 6);
+
+    // Heights first, then normals from them. Indices depend on nothing and
+    // are filled alongside. Every row is written by exactly one job.
+    TaskGraph grid;
+    TaskGraph::Task heights = grid.add([&] {
+        jobSystem.parallelFor(depth + 1, ROW_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t z = begin; z < end; ++z) {
+                for (int x = 0; x <= width; ++x) {
+                    float worldX = x - halfWidth;
+                    float worldZ = z - halfDepth;
+
+                    float height = sin(worldX * 0.03f) * cos(worldZ * 0.03f) * maxHeight;
+
+                    vertices[z * rowVertices + x] = glm::vec3(worldX, height, worldZ);
+                    uvs[z * rowVertices + x] = glm::vec2(x / (float)width, z / (float)depth) * repeatFactor;
+                }
+            }
+        });
+    });
+
+    grid.add([&] {
+        jobSystem.parallelFor(depth, ROW_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t z = begin; z < end; ++z) {
+                GLuint* out = &indices[z * width * 6];
+                for (int x = 0; x < width; ++x) {
+                    GLuint topLeft = z * rowVertices + x;
+                    GLuint topRight = topLeft + 1;
+                    GLuint bottomLeft = (z + 1) * rowVertices + x;
+                    GLuint bottomRight = bottomLeft + 1;
+
+                    *out++ = topLeft;
+                    *out++ = bottomLeft;
+                    *out++ = topRight;
+                    *out++ = topRight;
+                    *out++ = bottomLeft;
+                    *out++ = bottomRight;
+                }
+            }
+        });
+    });
+
+    // Each vertex gathers the faces around it rather than every face
+    // scattering into its corners, so rows can be done independently. The
+    // sums are taken in the order the faces used to be visited in.
+    grid.add([&] {
+        jobSystem.parallelFor(depth + 1, ROW_GRAIN, [&](size_t begin, size_t end) {
+            for (size_t z = begin; z < end; ++z) {
+                for (int x = 0; x <= width; ++x) {
+                    glm::vec3 normal(0.0f);
+                    glm::vec3 first, second;
+                    if (x > 0 && z > 0) {
+                        faceNormals(x - 1, z - 1, first, second);
+                        normal += second;
+                    }
+                    if (x < width && z > 0) {
+                        faceNormals(x, z - 1, first, second);
+                        normal += first + second;
+                    }
+                    if (x > 0 && z < static_cast<size_t>(depth)) {
+                        faceNormals(x - 1, z, first, second);
+                        normal += first + second;
+                    }
+                    if (x < width && z < static_cast<size_t>(depth)) {
+                        faceNormals(x, z, first, second);
+                        normal += first;
+                    }
+
+                    if (glm::length(normal) > 0.0f) {
+                        normal = glm::normalize(normal);
+                    }
+                    normals[z * rowVertices + x] = normal;
+                }
+            }
+        });
+    }, {heights});
+
+    jobSystem.run(grid);
+}
 
-    for (auto& normal : normals) {
-        if (glm::length(normal) > 0.0f) {
-            normal = glm::normalize(normal);
+void Terrain::upload(const std::vector<uint8_t>& texture) {
+    // Interleaved into the pool's vertex format a slice at a time, the grid
+    // is too large to copy whole. Drawn through the pool's vertex array.
+    poolHandle = meshPool.allocate(static_cast<GLuint>(vertices.size()), static_cast<GLuint>(indices.size()));
+    if (poolHandle != 0) {
+        std::vector<CookedVertex> slice;
+        for (size_t first = 0; first < vertices.size(); first += UPLOAD_SLICE_VERTICES) {
+            size_t count = std::min(UPLOAD_SLICE_VERTICES, vertices.size() - first);
+            slice.resize(count);
+            for (size_t i = 0; i < count; ++i) {
+                const glm::vec3& position = vertices[first + i];
+                const glm::vec2& uv = uvs[first + i];
+                const glm::vec3& normal = normals[first + i];
+                slice[i] = {{position.x, position.y, position.z}, {uv.x, uv.y}, {normal.x, normal.y, normal.z}};
+            }
+            meshPool.writeVertices(poolHandle, static_cast<GLuint>(first), slice.data(), static_cast<GLuint>(count));
         }
+        meshPool.writeIndices(poolHandle, 0, indices.data(), static_cast<GLuint>(indices.size()));
     }
-
-    // OpenGL setup
-    glGenVertexArrays(1, &vertexArrayID);
-    glBindVertexArray(vertexArrayID);
-
-    glGenBuffers(1, &vertexBufferID);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec3), vertices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &uvBufferID);
-    glBindBuffer(GL_ARRAY_BUFFER, uvBufferID);
-    glBufferData(GL_ARRAY_BUFFER, uvs.size() * sizeof(glm::vec2), uvs.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &indexBufferID);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &normalBufferID);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+    vertexArrayID = meshPool.getVertexArray();
 
     programID = LoadShadersFromFile("../futuristic_emerald_isle/shaders/terrain.vert", "../futuristic_emerald_isle/shaders/terrain.frag");
 
-    // Uniform locations
-    mvpMatrixID = glGetUniformLocation(programID, "MVP");
+    // The terrain is built in world space, its model matrix never changes
     modelMatrixID = glGetUniformLocation(programID, "modelMatrix");
-    lightPositionID = glGetUniformLocation(programID, "lightPosition");
-    lightIntensityID = glGetUniformLocation(programID, "lightIntensity");
+    glm::mat4 model = glm::mat4(1.0f);
+    glUseProgram(programID);
+    glUniformMatrix4fv(modelMatrixID, 1, GL_FALSE, &model[0][0]);
 
     // Texture
-    textureID = LoadTextureTileBox("../futuristic_emerald_isle/assets/textures/grass.jpg");
+    textureID = texture.empty() ? 0 : LoadCookedTexture(texture.data(), texture.size());
+    if (textureID == 0) {
+        textureID = LoadTextureTileBox(TEXTURE_PATH);
+    }
     textureSamplerID = glGetUniformLocation(programID, "textureSampler");
 }
 
-void Terrain::render(const glm::mat4& vp, glm::vec3 lightPosition, glm::vec3 lightIntensity) {
-    glUseProgram(programID);
-
-    glEnableVertexAttribArray(0);
-    glBindBuffer(GL_ARRAY_BUFFER, vertexBufferID);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glEnableVertexAttribArray(1);
-    glBindBuffer(GL_ARRAY_BUFFER, uvBufferID);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glEnableVertexAttribArray(2);
-    glBindBuffer(GL_ARRAY_BUFFER, normalBufferID);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID);
-
-    // Model matrix
-    glm::mat4 model = glm::mat4(1.0f);
-    glUniformMatrix4fv(modelMatrixID, 1, GL_FALSE, &model[0][0]);
-
-    // MVP matrix
-    glm::mat4 mvp = vp * model;
-    glUniformMatrix4fv(mvpMatrixID, 1, GL_FALSE, &mvp[0][0]);
-
-    // Lighting
-    glUniform3fv(lightPositionID, 1, &lightPosition[0]);
-    glUniform3fv(lightIntensityID, 1, &lightIntensity[0]);
-
-    // Texture sampler
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, textureID);
-    glUniform1i(textureSamplerID, 0);
+void Terrain::submit(RenderQueue& queue) const {
+    DrawItem item;
+    item.key = RenderQueue::makeKey(RenderQueue::PASS_OPAQUE, programID, textureID, vertexArrayID, 0.0f);
+    item.program = programID;
+    item.vertexArray = vertexArrayID;
+    item.textures[0] = textureID;
+    item.textures[1] = 0;
+    item.draw = draw;
+    item.owner = this;
+    item.index = 0;
+    item.count = 1;
+    queue.submit(item);
+}
 
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+void Terrain::draw(const DrawItem& item, const RenderView&) {
+    const Terrain* terrain = static_cast<const Terrain*>(item.owner);
+    if (terrain->poolHandle == 0) return;
 
-    glDisableVertexAttribArray(0);
-    glDisableVertexAttribArray(1);
-    glDisableVertexAttribArray(2);
+    void* offset = reinterpret_cast<void*>(static_cast<size_t>(meshPool.getFirstIndex(terrain->poolHandle)) * sizeof(GLuint));
+    glDrawElementsBaseVertex(GL_TRIANGLES, terrain->indices.size(), GL_UNSIGNED_INT, offset, meshPool.getBaseVertex(terrain->poolHandle));
 }
 
 void Terrain::cleanup() {
-    glDeleteBuffers(1, &vertexBufferID);
-    glDeleteBuffers(1, &uvBufferID);
-    glDeleteBuffers(1, &indexBufferID);
-    glDeleteBuffers(1, &normalBufferID);
-    glDeleteVertexArrays(1, &vertexArrayID);
+    meshPool.remove(poolHandle);
+    poolHandle = 0;
+    vertexArrayID = 0;
     glDeleteTextures(1, &textureID);
-    glDeleteProgram(programID);
+}
+
+const char* const Terrain::TEXTURE_PATH = "../futuristic_emerald_isle/assets/textures/grass.jpg";
+
+void Terrain::faceNormals(int x, int z, glm::vec3& first, glm::vec3& second) const {
+    size_t topLeft = z * (width + 1) + x;
+    size_t topRight = topLeft + 1;
+    size_t bottomLeft = (z + 1) * (width + 1) + x;
+    size_t bottomRight = bottomLeft + 1;
+
+    first = glm::normalize(glm::cross(vertices[bottomLeft] - vertices[topLeft], vertices[topRight] - vertices[topLeft]));
+    second = glm::normalize(glm::cross(vertices[bottomLeft] - vertices[topRight], vertices[bottomRight] - vertices[topRight]));
 }
 
 glm::vec3 Terrain::getCenterHill() {
@@ -172,19 +217,50 @@ glm::vec3 Terrain::getCenterHill() {
     return closestVertex;
 }
 
-std::vector<glm::vec3> Terrain::getHighestPoints(int n) {
-    std::vector<glm::vec3> sortedVertices = vertices;
+std::vector<glm::vec3> Terrain::getHighestPoints(int n) const {
+    std::vector<glm::vec3> highest;
+    if (n <= 0 || vertices.empty()) {
+        return highest;
+    }
 
-    std::sort(sortedVertices.begin(), sortedVertices.end(),
-              [](const glm::vec3& a, const glm::vec3& b) {
-                  return a.y > b.y;
-              });
+    // Ties go to the lower index, so the pick is the same on every run
+    auto higher = [this](uint32_t a, uint32_t b) {
+        return vertices[a].y > vertices[b].y || (vertices[a].y == vertices[b].y && a < b);
+    };
+
+    // Every block keeps its own n highest, then only those are ranked
+    size_t keep = std::min<size_t>(n, vertices.size());
+    size_t blocks = (vertices.size() + HIGHEST_BLOCK - 1) / HIGHEST_BLOCK;
+    std::vector<uint32_t> candidates(blocks * keep);
+    std::vector<size_t> candidateCounts(blocks);
+    jobSystem.parallelFor(blocks, 1, [&](size_t beginBlock, size_t endBlock) {
+        for (size_t b = beginBlock; b < endBlock; ++b) {
+            size_t first = b * HIGHEST_BLOCK;
+            size_t size = std::min(HIGHEST_BLOCK, vertices.size() - first);
+            size_t kept = std::min(keep, size);
+
+            ArenaScope scratch;
+            uint32_t* order = scratch.allocate<uint32_t>(size);
+            for (size_t i = 0; i < size; ++i) {
+                order[i] = static_cast<uint32_t>(first + i);
+            }
+            std::partial_sort(order, order + kept, order + size, higher);
+            std::copy(order, order + kept, candidates.begin() + b * keep);
+            candidateCounts[b] = kept;
+        }
+    });
 
-    if (sortedVertices.size() > n) {
-        sortedVertices.resize(n);
+    std::vector<uint32_t> ranked;
+    for (size_t b = 0; b < blocks; ++b) {
+        ranked.insert(ranked.end(), candidates.begin() + b * keep, candidates.begin() + b * keep + candidateCounts[b]);
     }
+    std::partial_sort(ranked.begin(), ranked.begin() + keep, ranked.end(), higher);
 
-    return sortedVertices;
+    highest.reserve(keep);
+    for (size_t i = 0; i < keep; ++i) {
+        highest.push_back(vertices[ranked[i]]);
+    }
+    return highest;
 }
 
 int Terrain::getWidth() const {
@@ -225,3 +301,9 @@ float Terrain::getHeightAt(float x, float z) const {
 
     return h0 * (1 - tz) + h1 * tz;
 }
+
+float Terrain::getClampedHeightAt(float x, float z) const {
+    float halfWidth = width / 2.0f - 1.0f;
+    float halfDepth = depth / 2.0f - 1.0f;
+    return getHeightAt(glm::clamp(x, -halfWidth, halfWidth), glm::clamp(z, -halfDepth, halfDepth));
+}
@@ -1,18 +1,19 @@
+#include <cstdint>
 #include <vector>
 #include <glm/glm.hpp>
 
 #include "glad/gl.h"
+#include "mesh_pool.h"
+#include "render_queue.h"
 
 class Terrain {
 public:
-    GLuint vertexArrayID, vertexBufferID, indexBufferID, uvBufferID, normalBufferID;
+    GLuint vertexArrayID;           // meshPool's shared one
+    MeshPool::Handle poolHandle = 0;
     GLuint textureID;
     GLuint programID;
 
-    GLuint mvpMatrixID;
     GLuint modelMatrixID;
-    GLuint lightPositionID;
-    GLuint lightIntensityID;
     GLuint textureSamplerID;
 
     std::vector<glm::vec3> vertices;
@@ -20,17 +21,33 @@ public:
     std::vector<glm::vec2> uvs;
     std::vector<glm::vec3> normals;
 
+    static const char* const TEXTURE_PATH;
+
     void initialize(int width, int depth, float maxHeight, float repeatFactor);
-    void render(const glm::mat4& vp, glm::vec3 lightPosition, glm::vec3 lightIntensity);
+
+    // initialize() in two halves. generate() builds the grid and is safe off
+    // the GL thread; upload() creates the buffers, shaders and texture, from
+    // the cooked texture when one is given and from TEXTURE_PATH otherwise.
+    void generate(int width, int depth, float maxHeight, float repeatFactor);
+    void upload(const std::vector<uint8_t>& texture);
+    void submit(RenderQueue& queue) const;
     void cleanup();
 
     glm::vec3 getCenterHill();
-    std::vector<glm::vec3> getHighestPoints(int n);
+    std::vector<glm::vec3> getHighestPoints(int n) const;
     int getWidth() const;
     int getDepth() const;
     float getHeightAt(float x, float z) const;
+    // getHeightAt of the nearest point on the grid, for callers that can
+    // stray past the edge
+    float getClampedHeightAt(float x, float z) const;
 
 private:
+    static void draw(const DrawItem& item, const RenderView& view);
+
+    // The two triangle normals of the grid square at (x, z)
+    void faceNormals(int x, int z, glm::vec3& first, glm::vec3& second) const;
+
     int width;
     int depth;
     float maxHeight;
@@ -0,0 +1,213 @@
+#include "airways.h"
+#include "render/terrain.h"
+#include "utils/job_system.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <utility>
+
+namespace {
+
+// Catmull-Rom between p1 and p2
+glm::vec3 catmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t) {
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
+
+}
+
+const uint32_t AirwayGraph::NO_EDGE;
+
+void AirwayGraph::build(const std::vector<glm::vec3>& cities, const std::vector<ObstacleBox>& obstacles, const Terrain& terrain,
+                        const AirwaySettings& settings) {
+    nodes.clear();
+    flowFields.clear();
+    edges.clear();
+    samples.clear();
+    sampleHeadings.clear();
+    routes.clear();
+    sampleSpacing = settings.sampleSpacing;
+    carSpacing = settings.carSpacing;
+
+    for (const glm::vec3& city : cities) {
+        glm::vec3 node(city.x, terrain.getClampedHeightAt(city.x, city.z) + settings.cityClearance, city.z);
+        bool duplicate = std::any_of(nodes.begin(), nodes.end(),
+                                     [&](const glm::vec3& other) { return glm::distance(other, node) < settings.carSpacing; });
+        if (!duplicate) {
+            nodes.push_back(node);
+        }
+    }
+
+    flowFields.resize(nodes.size());
+    jobSystem.parallelFor(nodes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t node = begin; node < end; ++node) {
+            flowFields[node].build(nodes[node], obstacles, terrain, settings.flowField);
+        }
+    });
+
+    // Each city links to its nearest neighbours, both ways
+    std::vector<std::pair<uint32_t, uint32_t>> links;
+    for (uint32_t a = 0; a < nodes.size(); ++a) {
+        std::vector<std::pair<float, uint32_t>> byDistance;
+        for (uint32_t b = 0; b < nodes.size(); ++b) {
+            if (b != a) byDistance.emplace_back(glm::distance(nodes[a], nodes[b]), b);
+        }
+        size_t count = std::min<size_t>(settings.neighbours, byDistance.size());
+        std::partial_sort(byDistance.begin(), byDistance.begin() + count, byDistance.end());
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t b = byDistance[i].second;
+            links.emplace_back(std::min(a, b), std::max(a, b));
+        }
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    for (const auto& link : links) {
+        addEdge(link.first, link.second, terrain, settings);
+        addEdge(link.second, link.first, terrain, settings);
+    }
+
+    buildRoutes();
+}
+
+void AirwayGraph::addEdge(uint32_t from, uint32_t to, const Terrain& terrain, const AirwaySettings& settings) {
+    glm::vec3 start = nodes[from];
+    glm::vec3 end = nodes[to];
+    glm::vec3 flat(end.x - start.x, 0.0f, end.z - start.z);
+    float horizontal = glm::length(flat);
+    if (horizontal < 1e-3f) {
+        return;
+    }
+    glm::vec3 heading = flat / horizontal;
+
+    // Cruise above the highest ground between the two cities
+    float cruise = std::max(start.y, end.y);
+    int groundSamples = std::max(2, static_cast<int>(horizontal / 10.0f));
+    for (int i = 0; i <= groundSamples; ++i) {
+        glm::vec3 point = glm::mix(start, end, static_cast<float>(i) / groundSamples);
+        cruise = std::max(cruise, terrain.getClampedHeightAt(point.x, point.z) + settings.cruiseClearance);
+    }
+
+    float climb = std::min(settings.climbDistance, horizontal / 3.0f);
+    glm::vec3 control[4] = {
+        start,
+        glm::vec3(start.x, cruise, start.z) + heading * climb,
+        glm::vec3(end.x, cruise, end.z) - heading * climb,
+        end
+    };
+
+    // Dense pass over the spline, then resampled at equal arc length
+    std::vector<glm::vec3> dense;
+    std::vector<float> arc;
+    const int stepsPerSegment = 32;
+    for (int segment = 0; segment < 3; ++segment) {
+        const glm::vec3& p0 = control[std::max(segment - 1, 0)];
+        const glm::vec3& p1 = control[segment];
+        const glm::vec3& p2 = control[segment + 1];
+        const glm::vec3& p3 = control[std::min(segment + 2, 3)];
+        for (int step = segment == 0 ? 0 : 1; step <= stepsPerSegment; ++step) {
+            glm::vec3 point = catmullRom(p0, p1, p2, p3, static_cast<float>(step) / stepsPerSegment);
+            arc.push_back(dense.empty() ? 0.0f : arc.back() + glm::distance(dense.back(), point));
+            dense.push_back(point);
+        }
+    }
+
+    Edge edge;
+    edge.from = from;
+    edge.to = to;
+    edge.length = arc.back();
+    edge.firstSample = static_cast<uint32_t>(samples.size());
+    edge.sampleCount = static_cast<uint32_t>(std::ceil(edge.length / sampleSpacing)) + 1;
+    edge.capacity = std::max(1u, static_cast<uint32_t>(edge.length / settings.carSpacing));
+
+    size_t j = 0;
+    for (uint32_t i = 0; i < edge.sampleCount; ++i) {
+        float distance = std::min(i * sampleSpacing, edge.length);
+        while (j + 2 < arc.size() && arc[j + 1] < distance) {
+            ++j;
+        }
+        float span = arc[j + 1] - arc[j];
+        float t = span > 0.0f ? (distance - arc[j]) / span : 0.0f;
+        samples.push_back(glm::mix(dense[j], dense[j + 1], glm::clamp(t, 0.0f, 1.0f)));
+    }
+
+    // Worked out once here rather than for every car every step
+    float lastHeading = glm::degrees(atan2(heading.x, heading.z));
+    for (uint32_t i = 0; i < edge.sampleCount; ++i) {
+        glm::vec3 delta = i + 1 < edge.sampleCount ? samples[edge.firstSample + i + 1] - samples[edge.firstSample + i] : glm::vec3(0.0f);
+        if (delta.x * delta.x + delta.z * delta.z > 1e-8f) {
+            lastHeading = glm::degrees(atan2(delta.x, delta.z));
+        }
+        sampleHeadings.push_back(lastHeading);
+    }
+
+    edges.push_back(edge);
+}
+
+void AirwayGraph::buildRoutes() {
+    size_t count = nodes.size();
+    routes.assign(count * count, NO_EDGE);
+
+    std::vector<std::vector<uint32_t>> outgoing(count);
+    for (uint32_t e = 0; e < edges.size(); ++e) {
+        outgoing[edges[e].from].push_back(e);
+    }
+
+    // Dijkstra from every city, remembering the first edge of each route.
+    // Sources are independent and write their own row of routes.
+    typedef std::pair<float, uint32_t> QueueEntry;
+    jobSystem.parallelFor(count, 1, [&](size_t begin, size_t end) {
+        for (size_t source = begin; source < end; ++source) {
+            ArenaScope scratch;
+            float* cost = scratch.allocate<float>(count);
+            uint32_t* firstEdge = routes.data() + source * count;
+            std::fill(cost, cost + count, INFINITY);
+
+            // Every edge pushes at most once, plus the source
+            QueueEntry* queue = scratch.allocate<QueueEntry>(edges.size() + 1);
+            size_t queued = 0;
+            cost[source] = 0.0f;
+            queue[queued++] = QueueEntry(0.0f, static_cast<uint32_t>(source));
+
+            while (queued > 0) {
+                std::pop_heap(queue, queue + queued, std::greater<QueueEntry>());
+                QueueEntry top = queue[--queued];
+                uint32_t node = top.second;
+                if (top.first > cost[node]) {
+                    continue;
+                }
+                for (uint32_t e : outgoing[node]) {
+                    uint32_t next = edges[e].to;
+                    float candidate = cost[node] + edges[e].length;
+                    if (candidate < cost[next]) {
+                        cost[next] = candidate;
+                        firstEdge[next] = node == source ? e : firstEdge[node];
+                        queue[queued++] = QueueEntry(candidate, next);
+                        std::push_heap(queue, queue + queued, std::greater<QueueEntry>());
+                    }
+                }
+            }
+        }
+    });
+}
+
+void AirwayGraph::sample(uint32_t edge, float distance, glm::vec3& position, float& heading) const {
+    const Edge& e = edges[edge];
+    float f = glm::clamp(distance, 0.0f, e.length) / sampleSpacing;
+    uint32_t i = std::min(static_cast<uint32_t>(f), e.sampleCount - 2);
+    float t = std::min(f - i, 1.0f);
+
+    const glm::vec3& a = samples[e.firstSample + i];
+    const glm::vec3& b = samples[e.firstSample + i + 1];
+    position = a + (b - a) * t;
+    heading = sampleHeadings[e.firstSample + i];
+}
+
+glm::vec3 AirwayGraph::tangent(uint32_t edge, float distance) const {
+    const Edge& e = edges[edge];
+    uint32_t i = std::min(static_cast<uint32_t>(glm::clamp(distance, 0.0f, e.length) / sampleSpacing), e.sampleCount - 2);
+    glm::vec3 delta = samples[e.firstSample + i + 1] - samples[e.firstSample + i];
+    float length = glm::length(delta);
+    return length > 1e-6f ? delta / length : glm::vec3(0.0f, 0.0f, 1.0f);
+}
@@ -0,0 +1,74 @@
+#ifndef AIRWAYS_H
+#define AIRWAYS_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "flow_field.h"
+
+class Terrain;
+
+struct AirwaySettings {
+    int neighbours = 6;             // Airways from each city to its nearest cities
+    float cityClearance = 40.0f;    // Height of a city's node above the ground, clear of its towers
+    float cruiseClearance = 30.0f;  // Height kept above the highest ground under an airway
+    float climbDistance = 60.0f;    // Horizontal distance spent climbing to and from cruise height
+    float sampleSpacing = 2.0f;     // Arc length between stored spline samples
+    float carSpacing = 3.0f;        // Minimum gap between cars in a lane
+    FlowFieldSettings flowField;    // Around each city, towards its node
+};
+
+// Directed airways between cities. Each airway is a Catmull-Rom spline that
+// climbs out of its city over the terrain and down into the next, stored
+// resampled at equal arc length so a distance along it maps to a sample by
+// a single division. Routes between every pair of cities are precomputed.
+class AirwayGraph {
+public:
+    static const uint32_t NO_EDGE = 0xFFFFFFFFu;
+
+    struct Edge {
+        uint32_t from, to;
+        float length;
+        uint32_t firstSample;
+        uint32_t sampleCount;
+        uint32_t capacity;          // Cars that fit at carSpacing
+    };
+
+    // Safe off the GL thread; only reads the terrain. Cities closer together
+    // than a car spacing are merged into one node. Obstacles only shape the
+    // flow fields, airways pass over them by their clearance.
+    void build(const std::vector<glm::vec3>& cities, const std::vector<ObstacleBox>& obstacles, const Terrain& terrain,
+               const AirwaySettings& settings = AirwaySettings());
+
+    size_t getNodeCount() const { return nodes.size(); }
+    const FlowField& getFlowField(uint32_t node) const { return flowFields[node]; }
+    const Edge& getEdge(uint32_t edge) const { return edges[edge]; }
+    size_t getEdgeCount() const { return edges.size(); }
+    float getSampleSpacing() const { return sampleSpacing; }
+    float getCarSpacing() const { return carSpacing; }
+
+    // First airway on the shortest route, NO_EDGE if to is unreachable or
+    // equal to from
+    uint32_t nextEdge(uint32_t from, uint32_t to) const { return routes[from * nodes.size() + to]; }
+
+    // Position distance along an edge, and the heading about Y there in degrees
+    void sample(uint32_t edge, float distance, glm::vec3& position, float& heading) const;
+
+    // Unit direction of travel distance along an edge
+    glm::vec3 tangent(uint32_t edge, float distance) const;
+
+private:
+    void addEdge(uint32_t from, uint32_t to, const Terrain& terrain, const AirwaySettings& settings);
+    void buildRoutes();
+
+    std::vector<glm::vec3> nodes;
+    std::vector<FlowField> flowFields;
+    std::vector<Edge> edges;
+    std::vector<glm::vec3> samples;
+    std::vector<float> sampleHeadings;  // From each sample towards the next
+    std::vector<uint32_t> routes;
+    float sampleSpacing = 1.0f;
+    float carSpacing = 1.0f;
+};
+
+#endif // AIRWAYS_H
@@ -0,0 +1,449 @@
+#include "bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utils/job_system.h>
+
+namespace {
+
+const int SAH_BINS = 16;
+const uint32_t MAX_LEAF_ITEMS = 8;
+// A leaf this small is never worth splitting
+const uint32_t MIN_SPLIT_ITEMS = 2;
+// Cost of visiting a node relative to testing an item
+const float TRAVERSAL_COST = 1.0f;
+// Traversal stack size. Past SAH_DEPTH nodes are halved by count, which
+// takes any 2^32 items down to leaves well within it.
+const int STACK_DEPTH = 64;
+const uint32_t SAH_DEPTH = 30;
+
+// Nodes with this many items or fewer that are not wholly in view are
+// handed to CullBoxes rather than split further
+const uint32_t CULL_RUN_ITEMS = 32;
+
+// Queries per job in the batched queries
+const size_t QUERY_GRAIN = 64;
+
+Aabb emptyBox() {
+    float big = std::numeric_limits<float>::max();
+    return {glm::vec3(big), glm::vec3(-big)};
+}
+
+void grow(Aabb& box, const Aabb& other) {
+    box.min = glm::min(box.min, other.min);
+    box.max = glm::max(box.max, other.max);
+}
+
+void grow(Aabb& box, const glm::vec3& point) {
+    box.min = glm::min(box.min, point);
+    box.max = glm::max(box.max, point);
+}
+
+float surfaceArea(const Aabb& box) {
+    glm::vec3 size = box.max - box.min;
+    if (size.x < 0.0f) return 0.0f;
+    return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+glm::vec3 center(const Aabb& box) {
+    return (box.min + box.max) * 0.5f;
+}
+
+// Squared distance from point to the nearest and farthest points of box
+void distanceRange(const Aabb& box, const glm::vec3& point, float& nearSquared, float& farSquared) {
+    nearSquared = 0.0f;
+    farSquared = 0.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float below = box.min[axis] - point[axis];
+        float above = point[axis] - box.max[axis];
+        float outside = std::max(0.0f, std::max(below, above));
+        float across = std::max(std::fabs(below), std::fabs(above));
+        nearSquared += outside * outside;
+        farSquared += across * across;
+    }
+}
+
+enum Containment { OUTSIDE, PARTLY, INSIDE };
+
+Containment classify(const CullView& view, const Aabb& box) {
+    glm::vec3 c = center(box);
+    glm::vec3 e = (box.max - box.min) * 0.5f;
+    Containment result = INSIDE;
+    for (const glm::vec4& plane : view.planes) {
+        float d = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+        float reach = std::fabs(plane.x) * e.x + std::fabs(plane.y) * e.y + std::fabs(plane.z) * e.z;
+        if (d < -reach) return OUTSIDE;
+        if (d < reach) result = PARTLY;
+    }
+    return result;
+}
+
+// Entry distance of the ray into box, or a negative number if it misses
+float enter(const Aabb& box, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance) {
+    float nearT = 0.0f;
+    float farT = maxDistance;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+        float t1 = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        // NaN from a zero direction inside the slab leaves the range alone
+        if (t0 > nearT) nearT = t0;
+        if (t1 < farT) farT = t1;
+    }
+    return nearT <= farT ? nearT : -1.0f;
+}
+
+float boxSphereDistanceSquared(const Aabb& box, const glm::vec3& point) {
+    float nearSquared, farSquared;
+    distanceRange(box, point, nearSquared, farSquared);
+    return nearSquared;
+}
+
+}
+
+void BoundsFromBoxes(const BoxArrays& boxes, size_t count, std::vector<Aabb>& bounds) {
+    bounds.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 c(boxes.centerX[i], boxes.centerY[i], boxes.centerZ[i]);
+        glm::vec3 e(boxes.extentX[i], boxes.extentY[i], boxes.extentZ[i]);
+        bounds[i] = {c - e, c + e};
+    }
+}
+
+void BoundsFromSpheres(const SphereArrays& spheres, size_t count, std::vector<Aabb>& bounds) {
+    bounds.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 c(spheres.centerX[i], spheres.centerY[i], spheres.centerZ[i]);
+        glm::vec3 r((spheres.radius ? spheres.radius[i] : 1.0f) * spheres.radiusScale);
+        bounds[i] = {c - r, c + r};
+    }
+}
+
+Bvh::Bvh() : builtCost(0.0f) {}
+
+void Bvh::build(const std::vector<Aabb>& bounds) {
+    itemBounds = bounds;
+    items.resize(bounds.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        items[i] = static_cast<uint32_t>(i);
+    }
+
+    nodes.clear();
+    builtCost = 0.0f;
+    if (items.empty()) {
+        storeSlots();
+        return;
+    }
+
+    std::vector<glm::vec3> centroids(bounds.size());
+    for (size_t i = 0; i < bounds.size(); ++i) {
+        centroids[i] = center(bounds[i]);
+    }
+
+    // At most 2n - 1 nodes, reserved so splitting never reallocates
+    nodes.reserve(2 * items.size());
+    Node root;
+    root.bounds = emptyBox();
+    for (const Aabb& box : bounds) grow(root.bounds, box);
+    root.left = 0;
+    root.first = 0;
+    root.count = static_cast<uint32_t>(items.size());
+    nodes.push_back(root);
+
+    // Children are appended after their parent, so walking forwards visits
+    // every node after the one that made it
+    std::vector<uint32_t> depths(1, 0);
+    for (uint32_t n = 0; n < nodes.size(); ++n) {
+        uint32_t depth = depths[n];
+        split(n, depth, centroids);
+        depths.resize(nodes.size(), depth + 1);
+    }
+    builtCost = traversalCost();
+    storeSlots();
+}
+
+void Bvh::split(uint32_t nodeIndex, uint32_t depth, const std::vector<glm::vec3>& centroids) {
+    Node node = nodes[nodeIndex];
+    if (node.count < MIN_SPLIT_ITEMS) return;
+
+    Aabb centroidBounds = emptyBox();
+    for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+        grow(centroidBounds, centroids[items[i]]);
+    }
+
+    // Cheapest bin boundary over the three axes
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    int bestBoundary = 0;
+    for (int axis = 0; axis < 3 && depth < SAH_DEPTH; ++axis) {
+        float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        if (extent <= 0.0f) continue;
+
+        Aabb binBounds[SAH_BINS];
+        uint32_t binCounts[SAH_BINS] = {};
+        for (Aabb& box : binBounds) box = emptyBox();
+        float scale = SAH_BINS / extent;
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            uint32_t item = items[i];
+            int bin = std::min(SAH_BINS - 1, static_cast<int>((centroids[item][axis] - centroidBounds.min[axis]) * scale));
+            binCounts[bin]++;
+            grow(binBounds[bin], itemBounds[item]);
+        }
+
+        // Areas and counts left of each boundary, then sweep from the right
+        float leftArea[SAH_BINS - 1];
+        uint32_t leftCount[SAH_BINS - 1];
+        Aabb sweep = emptyBox();
+        uint32_t count = 0;
+        for (int b = 0; b < SAH_BINS - 1; ++b) {
+            grow(sweep, binBounds[b]);
+            count += binCounts[b];
+            leftArea[b] = surfaceArea(sweep);
+            leftCount[b] = count;
+        }
+        sweep = emptyBox();
+        count = 0;
+        for (int b = SAH_BINS - 1; b > 0; --b) {
+            grow(sweep, binBounds[b]);
+            count += binCounts[b];
+            if (leftCount[b - 1] == 0 || count == 0) continue;
+            float cost = leftArea[b - 1] * leftCount[b - 1] + surfaceArea(sweep) * count;
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBoundary = b;
+            }
+        }
+    }
+
+    // Splitting must beat testing every item of the node, unless the leaf
+    // would be too large
+    float leafCost = surfaceArea(node.bounds) * node.count;
+    float splitCost = TRAVERSAL_COST * surfaceArea(node.bounds) + bestCost;
+    if (bestAxis < 0 && node.count <= MAX_LEAF_ITEMS) return;
+    if (bestAxis >= 0 && splitCost >= leafCost && node.count <= MAX_LEAF_ITEMS) return;
+
+    uint32_t* begin = items.data() + node.first;
+    uint32_t* end = begin + node.count;
+    uint32_t* middle;
+    if (bestAxis >= 0) {
+        float extent = centroidBounds.max[bestAxis] - centroidBounds.min[bestAxis];
+        float scale = SAH_BINS / extent;
+        middle = std::partition(begin, end, [&](uint32_t item) {
+            int bin = std::min(SAH_BINS - 1, static_cast<int>((centroids[item][bestAxis] - centroidBounds.min[bestAxis]) * scale));
+            return bin < bestBoundary;
+        });
+    } else {
+        // Every centroid in one place, or too deep for more SAH, halve by count
+        middle = begin + node.count / 2;
+    }
+
+    uint32_t leftCount = static_cast<uint32_t>(middle - begin);
+    Node children[2];
+    children[0].first = node.first;
+    children[0].count = leftCount;
+    children[1].first = node.first + leftCount;
+    children[1].count = node.count - leftCount;
+    for (Node& child : children) {
+        child.left = 0;
+        child.bounds = emptyBox();
+        for (uint32_t i = child.first; i < child.first + child.count; ++i) {
+            grow(child.bounds, itemBounds[items[i]]);
+        }
+    }
+
+    nodes[nodeIndex].left = static_cast<uint32_t>(nodes.size());
+    nodes.push_back(children[0]);
+    nodes.push_back(children[1]);
+}
+
+void Bvh::refit(const std::vector<Aabb>& bounds) {
+    if (bounds.size() != itemBounds.size()) return;
+    itemBounds = bounds;
+
+    // Children come after their parents, so backwards is bottom up
+    for (size_t n = nodes.size(); n-- > 0;) {
+        Node& node = nodes[n];
+        if (node.left == 0) {
+            node.bounds = emptyBox();
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                grow(node.bounds, itemBounds[items[i]]);
+            }
+        } else {
+            node.bounds = nodes[node.left].bounds;
+            grow(node.bounds, nodes[node.left + 1].bounds);
+        }
+    }
+    storeSlots();
+}
+
+void Bvh::storeSlots() {
+    size_t count = items.size();
+    slotCenterX.resize(count); slotCenterY.resize(count); slotCenterZ.resize(count);
+    slotExtentX.resize(count); slotExtentY.resize(count); slotExtentZ.resize(count);
+    for (size_t slot = 0; slot < count; ++slot) {
+        const Aabb& box = itemBounds[items[slot]];
+        glm::vec3 c = center(box);
+        glm::vec3 e = (box.max - box.min) * 0.5f;
+        slotCenterX[slot] = c.x; slotCenterY[slot] = c.y; slotCenterZ[slot] = c.z;
+        slotExtentX[slot] = e.x; slotExtentY[slot] = e.y; slotExtentZ[slot] = e.z;
+    }
+}
+
+void Bvh::update(const std::vector<Aabb>& bounds, float maxDegradation) {
+    if (bounds.size() != itemBounds.size()) {
+        build(bounds);
+        return;
+    }
+    refit(bounds);
+    if (getDegradation() > maxDegradation) build(bounds);
+}
+
+float Bvh::traversalCost() const {
+    if (nodes.empty()) return 0.0f;
+
+    float cost = 0.0f;
+    for (const Node& node : nodes) {
+        float area = surfaceArea(node.bounds);
+        cost += node.left == 0 ? area * node.count : TRAVERSAL_COST * area;
+    }
+    float rootArea = surfaceArea(nodes[0].bounds);
+    return rootArea > 0.0f ? cost / rootArea : 0.0f;
+}
+
+float Bvh::getDegradation() const {
+    return builtCost > 0.0f ? traversalCost() / builtCost : 1.0f;
+}
+
+void Bvh::clear() {
+    nodes.clear();
+    items.clear();
+    itemBounds.clear();
+    storeSlots();
+    builtCost = 0.0f;
+}
+
+void Bvh::cull(const CullView& view, std::vector<uint32_t>& out) const {
+    if (nodes.empty()) return;
+
+    float bandNear = view.nearDistance * view.nearDistance;
+    float bandFar = view.farDistance * view.farDistance;
+    BoxArrays slots = {slotCenterX.data(), slotCenterY.data(), slotCenterZ.data(),
+                       slotExtentX.data(), slotExtentY.data(), slotExtentZ.data()};
+
+    uint32_t stack[STACK_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+
+        // Item centres lie in the box, so the box bounds their distances
+        float nearSquared, farSquared;
+        distanceRange(node.bounds, view.eye, nearSquared, farSquared);
+        if (nearSquared > bandFar || farSquared < bandNear) continue;
+
+        Containment containment = classify(view, node.bounds);
+        if (containment == OUTSIDE) continue;
+
+        if (containment == INSIDE && nearSquared >= bandNear && farSquared <= bandFar) {
+            out.insert(out.end(), items.begin() + node.first, items.begin() + node.first + node.count);
+            continue;
+        }
+
+        if (node.left != 0 && node.count > CULL_RUN_ITEMS) {
+            stack[top++] = node.left;
+            stack[top++] = node.left + 1;
+            continue;
+        }
+
+        // The node's items are one run of slots, culled four at a time and
+        // then turned from slots back into items
+        size_t start = out.size();
+        out.resize(start + node.count);
+        size_t kept = CullBoxes(view, slots, node.first, node.first + node.count, out.data() + start);
+        out.resize(start + kept);
+        for (size_t k = start; k < out.size(); ++k) {
+            out[k] = items[out[k]];
+        }
+    }
+}
+
+void Bvh::overlapSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const {
+    if (nodes.empty()) return;
+
+    float radiusSquared = radius * radius;
+    uint32_t stack[STACK_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+        if (boxSphereDistanceSquared(node.bounds, center) > radiusSquared) continue;
+
+        if (node.left != 0) {
+            stack[top++] = node.left;
+            stack[top++] = node.left + 1;
+            continue;
+        }
+
+        for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+            if (boxSphereDistanceSquared(itemBounds[items[i]], center) <= radiusSquared) out.push_back(items[i]);
+        }
+    }
+}
+
+RayHit Bvh::raycast(const Ray& ray) const {
+    RayHit hit = {NO_ITEM, ray.maxDistance};
+    if (nodes.empty()) return hit;
+
+    glm::vec3 inverseDirection(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+    if (enter(nodes[0].bounds, ray.origin, inverseDirection, hit.distance) < 0.0f) return hit;
+
+    uint32_t stack[STACK_DEPTH];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        const Node& node = nodes[stack[--top]];
+
+        if (node.left == 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+                float t = enter(itemBounds[items[i]], ray.origin, inverseDirection, hit.distance);
+                if (t >= 0.0f && (hit.item == NO_ITEM || t < hit.distance)) {
+                    hit.item = items[i];
+                    hit.distance = t;
+                }
+            }
+            continue;
+        }
+
+        // Nearer child on top, so it is searched first and shortens the ray
+        // for the other
+        uint32_t first = node.left, second = node.left + 1;
+        float t0 = enter(nodes[first].bounds, ray.origin, inverseDirection, hit.distance);
+        float t1 = enter(nodes[second].bounds, ray.origin, inverseDirection, hit.distance);
+        if (t0 >= 0.0f && t1 >= 0.0f && t1 < t0) {
+            std::swap(first, second);
+            std::swap(t0, t1);
+        }
+        if (t1 >= 0.0f) stack[top++] = second;
+        if (t0 >= 0.0f) stack[top++] = first;
+    }
+    return hit;
+}
+
+void Bvh::raycast(const Ray* rays, RayHit* hits, size_t count) const {
+    jobSystem.parallelFor(count, QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            hits[i] = raycast(rays[i]);
+        }
+    });
+}
+
+void Bvh::overlapSpheres(const glm::vec3* centers, const float* radii, size_t count, std::vector<std::vector<uint32_t>>& results) const {
+    results.resize(count);
+    jobSystem.parallelFor(count, QUERY_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            results[i].clear();
+            overlapSphere(centers[i], radii[i], results[i]);
+        }
+    });
+}
@@ -0,0 +1,93 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "frustum_culling.h"
+
+struct Aabb {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;            // Need not be normalised, distances are in its lengths
+    float maxDistance;
+};
+
+struct RayHit {
+    uint32_t item;                  // NO_ITEM when nothing was hit
+    float distance;                 // Where the ray enters the item's box, 0 when it starts inside
+};
+
+// Bounds of SoA volumes, for building a Bvh over what frustum_culling culls
+void BoundsFromBoxes(const BoxArrays& boxes, size_t count, std::vector<Aabb>& bounds);
+void BoundsFromSpheres(const SphereArrays& spheres, size_t count, std::vector<Aabb>& bounds);
+
+// Bounding volume hierarchy over a set of boxes, items being their indices.
+// build() splits by binned surface area heuristic. Sets that move keep
+// their tree and refit() it to the new boxes; the tree gets looser as
+// items drift from where it was built, and getDegradation() says by how
+// much, so the owner can rebuild when it is worth it.
+//
+// Queries leave the tree alone, so any number may run at once. The batched
+// ones spread their queries over jobSystem.
+class Bvh {
+public:
+    static const uint32_t NO_ITEM = 0xFFFFFFFFu;
+
+    Bvh();
+
+    void build(const std::vector<Aabb>& bounds);
+    // Same items as the last build(), new boxes
+    void refit(const std::vector<Aabb>& bounds);
+    // refit() for the same number of items, build() when that changed or
+    // the refitted tree degraded past maxDegradation
+    void update(const std::vector<Aabb>& bounds, float maxDegradation);
+    // Expected traversal cost now against just after build(), 1 or more
+    float getDegradation() const;
+    void clear();
+
+    size_t size() const { return items.size(); }
+
+    // Appends the items a CullBoxes over the same boxes would keep, in no
+    // particular order. Subtrees wholly in view and in the band are taken
+    // without testing their items; small ones across an edge go through
+    // CullBoxes whole.
+    void cull(const CullView& view, std::vector<uint32_t>& out) const;
+    // Appends the items whose box is within radius of center
+    void overlapSphere(const glm::vec3& center, float radius, std::vector<uint32_t>& out) const;
+    // The item whose box the ray enters first
+    RayHit raycast(const Ray& ray) const;
+
+    void raycast(const Ray* rays, RayHit* hits, size_t count) const;
+    void overlapSpheres(const glm::vec3* centers, const float* radii, size_t count, std::vector<std::vector<uint32_t>>& results) const;
+
+private:
+    // Inner nodes have their children at left and left + 1, leaves have
+    // left 0. Either way [first, first + count) of items is the subtree's.
+    struct Node {
+        Aabb bounds;
+        uint32_t left;
+        uint32_t first;
+        uint32_t count;
+    };
+
+    void split(uint32_t nodeIndex, uint32_t depth, const std::vector<glm::vec3>& centroids);
+    void storeSlots();
+    float traversalCost() const;
+
+    std::vector<Node> nodes;        // Parents before children, root first
+    std::vector<uint32_t> items;
+    std::vector<Aabb> itemBounds;   // By item
+    // Item boxes again, in the order of items, so a node's items are one
+    // run of SoA boxes for CullBoxes
+    std::vector<float> slotCenterX, slotCenterY, slotCenterZ;
+    std::vector<float> slotExtentX, slotExtentY, slotExtentZ;
+    float builtCost;
+};
+
+#endif // BVH_H
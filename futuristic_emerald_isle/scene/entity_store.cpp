@@ -0,0 +1,83 @@
+#include "entity_store.h"
+#include <glm/gtc/quaternion.hpp>
+#include <cstring>
+
+size_t EntityStore::add() {
+    size_t index = size();
+
+    positionX.push_back(0.0f); positionY.push_back(0.0f); positionZ.push_back(0.0f);
+    rotationX.push_back(0.0f); rotationY.push_back(0.0f); rotationZ.push_back(0.0f);
+    orientationX.push_back(0.0f); orientationY.push_back(0.0f); orientationZ.push_back(0.0f); orientationW.push_back(1.0f);
+    scale.push_back(1.0f);
+    transformDirty.push_back(1);
+    affine.resize(affine.size() + AFFINE_FLOATS, 0.0f);
+
+    return index;
+}
+
+void EntityStore::clear() {
+    positionX.clear(); positionY.clear(); positionZ.clear();
+    rotationX.clear(); rotationY.clear(); rotationZ.clear();
+    orientationX.clear(); orientationY.clear(); orientationZ.clear(); orientationW.clear();
+    scale.clear();
+    transformDirty.clear();
+    affine.clear();
+}
+
+void EntityStore::reserve(size_t count) {
+    positionX.reserve(count); positionY.reserve(count); positionZ.reserve(count);
+    rotationX.reserve(count); rotationY.reserve(count); rotationZ.reserve(count);
+    orientationX.reserve(count); orientationY.reserve(count); orientationZ.reserve(count); orientationW.reserve(count);
+    scale.reserve(count);
+    transformDirty.reserve(count);
+    affine.reserve(count * AFFINE_FLOATS);
+}
+
+void SetRotation(EntityStore& store, size_t index, const glm::vec3& eulerDegrees) {
+    store.rotationX[index] = eulerDegrees.x;
+    store.rotationY[index] = eulerDegrees.y;
+    store.rotationZ[index] = eulerDegrees.z;
+
+    glm::vec3 radians = glm::radians(eulerDegrees);
+    glm::quat orientation = glm::angleAxis(radians.x, glm::vec3(1.0f, 0.0f, 0.0f)) *
+                            glm::angleAxis(radians.y, glm::vec3(0.0f, 1.0f, 0.0f)) *
+                            glm::angleAxis(radians.z, glm::vec3(0.0f, 0.0f, 1.0f));
+    store.orientationX[index] = orientation.x;
+    store.orientationY[index] = orientation.y;
+    store.orientationZ[index] = orientation.z;
+    store.orientationW[index] = orientation.w;
+    store.transformDirty[index] = 1;
+}
+
+TransformArrays GetTransformArrays(const EntityStore& store) {
+    TransformArrays arrays;
+    arrays.positionX = store.positionX.data();
+    arrays.positionY = store.positionY.data();
+    arrays.positionZ = store.positionZ.data();
+    arrays.orientationX = store.orientationX.data();
+    arrays.orientationY = store.orientationY.data();
+    arrays.orientationZ = store.orientationZ.data();
+    arrays.orientationW = store.orientationW.data();
+    arrays.scale = store.scale.data();
+    return arrays;
+}
+
+void UpdateTransforms(EntityStore& store) {
+    std::vector<uint32_t> dirty;
+
+    size_t count = store.size();
+    for (size_t i = 0; i < count; ++i) {
+        if (store.transformDirty[i]) {
+            dirty.push_back(static_cast<uint32_t>(i));
+            store.transformDirty[i] = 0;
+        }
+    }
+
+    ComposeAffineScattered(GetTransformArrays(store), dirty.data(), dirty.size(), store.affine.data());
+}
+
+void GatherTransforms(const EntityStore& store, const std::vector<uint32_t>& indices, float* out) {
+    for (size_t k = 0; k < indices.size(); ++k) {
+        memcpy(out + k * AFFINE_FLOATS, store.affine.data() + indices[k] * AFFINE_FLOATS, AFFINE_FLOATS * sizeof(float));
+    }
+}
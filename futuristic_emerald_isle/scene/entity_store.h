@@ -0,0 +1,49 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "transform_batch.h"
+
+// Packed component arrays for the scene's props. Every component is its own
+// array indexed by entity, so a system only streams the values it uses
+// instead of whole objects with cached matrices and GL handles. Entities are
+// not removed one at a time; a store is cleared and refilled.
+class EntityStore {
+public:
+    // Returns the new entity's index. Scale starts at 1, everything else at 0.
+    size_t add();
+    void clear();
+    void reserve(size_t count);
+    size_t size() const { return positionX.size(); }
+
+    // Transform. Rotation is Euler degrees applied X, then Y, then Z, and
+    // mirrored as a quaternion for composing; set it through SetRotation.
+    // Anything writing the transform sets transformDirty.
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> rotationX, rotationY, rotationZ;
+    std::vector<float> orientationX, orientationY, orientationZ, orientationW;
+    std::vector<float> scale;
+    std::vector<uint8_t> transformDirty;
+
+    // Composed transforms, AFFINE_FLOATS per entity, kept by UpdateTransforms
+    std::vector<float> affine;
+};
+
+// Systems
+
+void SetRotation(EntityStore& store, size_t index, const glm::vec3& eulerDegrees);
+
+TransformArrays GetTransformArrays(const EntityStore& store);
+
+// Recomposes the cached affine of every dirty entity in one pass. Suits
+// entities that rarely move; everything else can compose straight into
+// the instance buffer with ComposeAffinePacked over GetTransformArrays.
+void UpdateTransforms(EntityStore& store);
+
+// Packed AFFINE_FLOATS per listed entity into out, copied from the cache
+void GatherTransforms(const EntityStore& store, const std::vector<uint32_t>& indices, float* out);
+
+#endif // ENTITY_STORE_H
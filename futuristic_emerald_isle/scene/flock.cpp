@@ -0,0 +1,214 @@
+#include "flock.h"
+#include "render/terrain.h"
+#include "utils/job_system.h"
+#include "utils/startup_timeline.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const size_t FLOCK_GRAIN = 256;
+
+// Velocity change that turns velocity towards direction at full speed
+glm::vec3 steerTowards(const glm::vec3& direction, const glm::vec3& velocity, float maxSpeed) {
+    float length = glm::length(direction);
+    if (length < 1e-6f) {
+        return glm::vec3(0.0f);
+    }
+    return direction * (maxSpeed / length) - velocity;
+}
+
+}
+
+Flock::Flock() : terrain(nullptr) {}
+
+Flock::~Flock() {
+    cleanup();
+}
+
+void Flock::initialize(const Terrain* terrain) {
+    this->terrain = terrain;
+}
+
+void Flock::cleanup() {
+    clear();
+    terrain = nullptr;
+}
+
+void Flock::addBird(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& home) {
+    positionX.push_back(position.x);
+    positionY.push_back(position.y);
+    positionZ.push_back(position.z);
+    previousPositionX.push_back(position.x);
+    previousPositionY.push_back(position.y);
+    previousPositionZ.push_back(position.z);
+    velocityX.push_back(velocity.x);
+    velocityY.push_back(velocity.y);
+    velocityZ.push_back(velocity.z);
+    homeX.push_back(home.x);
+    homeY.push_back(home.y);
+    homeZ.push_back(home.z);
+}
+
+void Flock::clear() {
+    positionX.clear(); positionY.clear(); positionZ.clear();
+    previousPositionX.clear(); previousPositionY.clear(); previousPositionZ.clear();
+    velocityX.clear(); velocityY.clear(); velocityZ.clear();
+    homeX.clear(); homeY.clear(); homeZ.clear();
+}
+
+void Flock::step(float dt) {
+    timings = FlockTimings();
+    size_t count = size();
+    if (count == 0) {
+        return;
+    }
+
+    previousPositionX = positionX;
+    previousPositionY = positionY;
+    previousPositionZ = positionZ;
+
+    auto start = std::chrono::steady_clock::now();
+    buildHash();
+    timings.hash += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    accelerationX.resize(count);
+    accelerationY.resize(count);
+    accelerationZ.resize(count);
+    jobSystem.parallelFor(count, FLOCK_GRAIN, [this](size_t begin, size_t end) { steer(begin, end); });
+    timings.steer += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(count, FLOCK_GRAIN, [this, dt](size_t begin, size_t end) { integrate(begin, end, dt); });
+    timings.integrate += MillisecondsSince(start);
+}
+
+void Flock::buildHash() {
+    size_t count = size();
+    hash.build(positionX.data(), positionY.data(), positionZ.data(), count, std::max(settings.neighbourRadius, 1.0f), FLOCK_GRAIN * 4);
+
+    const std::vector<uint32_t>& order = hash.getOrder();
+    sorted.resize(count);
+    jobSystem.parallelFor(count, FLOCK_GRAIN * 4, [&](size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; ++slot) {
+            uint32_t i = order[slot];
+            sorted[slot] = {positionX[i], positionY[i], positionZ[i], velocityX[i], velocityY[i], velocityZ[i]};
+        }
+    });
+}
+
+float Flock::groundHeight(float x, float z) const {
+    if (!terrain) {
+        return 0.0f;
+    }
+
+    // Birds past the edge see the rim
+    return terrain->getClampedHeightAt(x, z);
+}
+
+void Flock::steer(size_t begin, size_t end) {
+    const float radius2 = settings.neighbourRadius * settings.neighbourRadius;
+    const float separation2 = settings.separationRadius * settings.separationRadius;
+
+    for (size_t slot = begin; slot < end; ++slot) {
+        const Neighbour& self = sorted[slot];
+        uint32_t i = hash.getOrder()[slot];
+        glm::vec3 position(self.positionX, self.positionY, self.positionZ);
+        glm::vec3 velocity(self.velocityX, self.velocityY, self.velocityZ);
+
+        int cx = hash.cell(position.x);
+        int cy = hash.cell(position.y);
+        int cz = hash.cell(position.z);
+
+        glm::vec3 separation(0.0f), alignment(0.0f), centre(0.0f);
+        int neighbours = 0;
+
+        // Neighbouring cells can share a bucket, each bucket is scanned once
+        uint32_t visited[27];
+        int visitedCount = 0;
+
+        for (int dz = -1; dz <= 1 && neighbours < settings.maxNeighbours; ++dz) {
+            for (int dy = -1; dy <= 1 && neighbours < settings.maxNeighbours; ++dy) {
+                for (int dx = -1; dx <= 1 && neighbours < settings.maxNeighbours; ++dx) {
+                    uint32_t h = hash.bucket(cx + dx, cy + dy, cz + dz);
+                    if (std::find(visited, visited + visitedCount, h) != visited + visitedCount) {
+                        continue;
+                    }
+                    visited[visitedCount++] = h;
+
+                    for (uint32_t k = hash.bucketStart(h); k < hash.bucketEnd(h) && neighbours < settings.maxNeighbours; ++k) {
+                        const Neighbour& other = sorted[k];
+                        glm::vec3 offset(other.positionX - position.x, other.positionY - position.y, other.positionZ - position.z);
+                        float d2 = glm::dot(offset, offset);
+                        if (d2 > radius2 || d2 < 1e-6f) {
+                            continue;
+                        }
+
+                        neighbours++;
+                        alignment += glm::vec3(other.velocityX, other.velocityY, other.velocityZ);
+                        centre += offset;
+                        if (d2 < separation2) {
+                            separation -= offset / d2;
+                        }
+                    }
+                }
+            }
+        }
+
+        glm::vec3 acceleration(0.0f);
+        if (neighbours > 0) {
+            acceleration += settings.separationWeight * steerTowards(separation, velocity, settings.maxSpeed);
+            acceleration += settings.alignmentWeight * steerTowards(alignment, velocity, settings.maxSpeed);
+            acceleration += settings.cohesionWeight * steerTowards(centre, velocity, settings.maxSpeed);
+        }
+
+        glm::vec3 toHome(homeX[i] - position.x, homeY[i] - position.y, homeZ[i] - position.z);
+        float homeDistance = glm::length(toHome);
+        if (homeDistance > settings.homeRadius) {
+            acceleration += settings.homeWeight * (homeDistance / settings.homeRadius) * steerTowards(toHome, velocity, settings.maxSpeed);
+        }
+
+        glm::vec3 ahead = position + velocity * settings.lookAhead;
+        float ground = std::max(groundHeight(position.x, position.z), groundHeight(ahead.x, ahead.z));
+        float gap = position.y - (ground + settings.terrainClearance);
+        if (gap < 0.0f) {
+            acceleration.y -= settings.terrainWeight * gap;
+        }
+
+        float magnitude = glm::length(acceleration);
+        if (magnitude > settings.maxAcceleration) {
+            acceleration *= settings.maxAcceleration / magnitude;
+        }
+
+        accelerationX[i] = acceleration.x;
+        accelerationY[i] = acceleration.y;
+        accelerationZ[i] = acceleration.z;
+    }
+}
+
+void Flock::integrate(size_t begin, size_t end, float dt) {
+    for (size_t i = begin; i < end; ++i) {
+        glm::vec3 velocity(velocityX[i] + accelerationX[i] * dt,
+                           velocityY[i] + accelerationY[i] * dt,
+                           velocityZ[i] + accelerationZ[i] * dt);
+
+        float speed = glm::length(velocity);
+        if (speed > settings.maxSpeed) {
+            velocity *= settings.maxSpeed / speed;
+        } else if (speed < settings.minSpeed) {
+            velocity = speed > 1e-6f ? velocity * (settings.minSpeed / speed) : glm::vec3(settings.minSpeed, 0.0f, 0.0f);
+        }
+
+        velocityX[i] = velocity.x;
+        velocityY[i] = velocity.y;
+        velocityZ[i] = velocity.z;
+        positionX[i] += velocity.x * dt;
+        positionY[i] += velocity.y * dt;
+        positionZ[i] += velocity.z * dt;
+
+        // Steering is soft, never let a bird go through the ground
+        positionY[i] = std::max(positionY[i], groundHeight(positionX[i], positionZ[i]) + 2.0f);
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef FLOCK_H
+#define FLOCK_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+#include "spatial_hash.h"
+
+class Terrain;
+
+struct FlockSettings {
+    float neighbourRadius = 12.0f;
+    float separationRadius = 4.0f;
+    int maxNeighbours = 24;         // Nearest are not guaranteed, the first found are used
+
+    float minSpeed = 15.0f;
+    float maxSpeed = 40.0f;
+    float maxAcceleration = 60.0f;
+
+    float separationWeight = 1.6f;
+    float alignmentWeight = 1.0f;
+    float cohesionWeight = 0.8f;
+
+    // Birds drift back to the hill they started on once they stray this far
+    float homeRadius = 90.0f;
+    float homeWeight = 0.4f;
+
+    // Height kept above the heightfield, looking lookAhead seconds ahead
+    float terrainClearance = 20.0f;
+    float lookAhead = 0.75f;
+    float terrainWeight = 4.0f;
+};
+
+// Wall-clock milliseconds spent in each phase of the last step()
+struct FlockTimings {
+    double hash = 0.0;
+    double steer = 0.0;
+    double integrate = 0.0;
+};
+
+// Boids (separation, alignment, cohesion) with homing and terrain avoidance.
+// State is kept as structure of arrays. Neighbours come from a uniform
+// spatial hash rebuilt every step, and steering runs on the job system.
+// The caller steps it at a fixed rate and every bird only reads the previous
+// step's state, so results do not depend on frame rate or thread count.
+class Flock {
+public:
+    Flock();
+    ~Flock();
+
+    void initialize(const Terrain* terrain);
+    void cleanup();
+
+    void addBird(const glm::vec3& position, const glm::vec3& velocity, const glm::vec3& home);
+    void clear();
+    size_t size() const { return positionX.size(); }
+
+    // Keeps the current positions as previous, then advances by dt
+    void step(float dt);
+
+    FlockSettings settings;
+    FlockTimings timings;
+
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> previousPositionX, previousPositionY, previousPositionZ;
+    std::vector<float> velocityX, velocityY, velocityZ;
+    std::vector<float> homeX, homeY, homeZ;
+
+private:
+    void buildHash();
+    void steer(size_t begin, size_t end);
+    void integrate(size_t begin, size_t end, float dt);
+    float groundHeight(float x, float z) const;
+
+    const Terrain* terrain;
+
+    // Copy of one bird's state in the spatial hash. Interleaved rather than
+    // split like the main state: a neighbour scan wants all six values of
+    // a handful of birds, not one value of many.
+    struct Neighbour {
+        float positionX, positionY, positionZ;
+        float velocityX, velocityY, velocityZ;
+    };
+
+    // Spatial hash over the birds, with their state copied into sorted in
+    // its order. Steering walks birds in that order so consecutive birds
+    // scan the same buckets.
+    SpatialHash hash;
+    std::vector<Neighbour> sorted;
+
+    std::vector<float> accelerationX, accelerationY, accelerationZ;
+};
+
+#endif // FLOCK_H
@@ -0,0 +1,167 @@
+#include "flow_field.h"
+#include "render/terrain.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace {
+
+const uint32_t UNREACHED = 0xFFFFFFFFu;
+
+// Integer step costs for face, edge and corner neighbours (~10 * length)
+uint32_t stepCost(int dx, int dy, int dz) {
+    int axes = (dx != 0) + (dy != 0) + (dz != 0);
+    return axes == 1 ? 10 : axes == 2 ? 14 : 17;
+}
+
+}
+
+FlowField::FlowField() : origin(0.0f), cellSize(1.0f), sizeX(0), sizeY(0), sizeZ(0) {}
+
+void FlowField::build(const glm::vec3& goal, const std::vector<ObstacleBox>& obstacles, const Terrain& terrain,
+                      const FlowFieldSettings& settings) {
+    cellSize = settings.cellSize;
+    sizeX = sizeZ = settings.halfCells * 2 + 1;
+    sizeY = settings.belowCells + settings.aboveCells + 1;
+    origin = goal - glm::vec3(settings.halfCells + 0.5f, settings.belowCells + 0.5f, settings.halfCells + 0.5f) * cellSize;
+
+    size_t cellCount = static_cast<size_t>(sizeX) * sizeY * sizeZ;
+    Cell empty = {0, 0, 0, 0};
+    cells.assign(cellCount, empty);
+
+    // Terrain under each column, then every box the cell centres fall in
+    for (int z = 0; z < sizeZ; ++z) {
+        for (int x = 0; x < sizeX; ++x) {
+            float worldX = origin.x + (x + 0.5f) * cellSize;
+            float worldZ = origin.z + (z + 0.5f) * cellSize;
+            float ground = terrain.getClampedHeightAt(worldX, worldZ);
+            for (int y = 0; y < sizeY; ++y) {
+                if (origin.y + (y + 0.5f) * cellSize < ground + settings.margin) {
+                    cells[(static_cast<size_t>(y) * sizeZ + z) * sizeX + x].solid = 1;
+                }
+            }
+        }
+    }
+
+    glm::vec3 gridMax = origin + glm::vec3(sizeX, sizeY, sizeZ) * cellSize;
+    glm::vec3 margin(settings.margin);
+    for (const ObstacleBox& box : obstacles) {
+        glm::vec3 low = box.min - margin;
+        glm::vec3 high = box.max + margin;
+        if (high.x < origin.x || high.y < origin.y || high.z < origin.z ||
+            low.x > gridMax.x || low.y > gridMax.y || low.z > gridMax.z) {
+            continue;
+        }
+
+        int firstX, lastX, firstY, lastY, firstZ, lastZ;
+        cellRange(low.x, high.x, origin.x, sizeX, firstX, lastX);
+        cellRange(low.y, high.y, origin.y, sizeY, firstY, lastY);
+        cellRange(low.z, high.z, origin.z, sizeZ, firstZ, lastZ);
+        for (int y = firstY; y <= lastY; ++y) {
+            for (int z = firstZ; z <= lastZ; ++z) {
+                for (int x = firstX; x <= lastX; ++x) {
+                    cells[(static_cast<size_t>(y) * sizeZ + z) * sizeX + x].solid = 1;
+                }
+            }
+        }
+    }
+
+    // Dijkstra from the goal through free cells, then from every free cell
+    // into the blocked ones. Each cell points at its cheapest neighbour.
+    std::vector<uint32_t> cost(cellCount, UNREACHED);
+    typedef std::pair<uint32_t, uint32_t> QueueEntry;
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+
+    auto expand = [&](bool intoSolid) {
+        while (!queue.empty()) {
+            QueueEntry top = queue.top();
+            queue.pop();
+            uint32_t cell = top.second;
+            if (top.first > cost[cell]) {
+                continue;
+            }
+            int x = cell % sizeX;
+            int z = (cell / sizeX) % sizeZ;
+            int y = cell / (sizeX * sizeZ);
+            for (int dy = -1; dy <= 1; ++dy) {
+                for (int dz = -1; dz <= 1; ++dz) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int nx = x + dx, ny = y + dy, nz = z + dz;
+                        if ((dx | dy | dz) == 0 || nx < 0 || ny < 0 || nz < 0 || nx >= sizeX || ny >= sizeY || nz >= sizeZ) {
+                            continue;
+                        }
+                        uint32_t next = (static_cast<uint32_t>(ny) * sizeZ + nz) * sizeX + nx;
+                        if (cells[next].solid != (intoSolid ? 1 : 0)) {
+                            continue;
+                        }
+                        uint32_t candidate = top.first + stepCost(dx, dy, dz);
+                        if (candidate < cost[next]) {
+                            cost[next] = candidate;
+                            glm::vec3 back = glm::normalize(glm::vec3(-dx, -dy, -dz)) * 127.0f;
+                            cells[next].x = static_cast<int8_t>(std::lround(back.x));
+                            cells[next].y = static_cast<int8_t>(std::lround(back.y));
+                            cells[next].z = static_cast<int8_t>(std::lround(back.z));
+                            queue.emplace(candidate, next);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    int goalCell = cellIndex(goal);
+    if (goalCell >= 0 && !cells[goalCell].solid) {
+        cost[goalCell] = 0;
+        queue.emplace(0, goalCell);
+        expand(false);
+    }
+
+    // Every free cell is a source for the way out of the blocked ones
+    for (uint32_t cell = 0; cell < cellCount; ++cell) {
+        cost[cell] = cells[cell].solid ? UNREACHED : 0;
+        if (!cells[cell].solid) {
+            queue.emplace(0, cell);
+        }
+    }
+    expand(true);
+}
+
+void FlowField::cellRange(float low, float high, float start, int size, int& first, int& last) const {
+    // Cells whose centre lies within [low, high]
+    first = std::max(static_cast<int>(std::ceil((low - start) / cellSize - 0.5f)), 0);
+    last = std::min(static_cast<int>(std::floor((high - start) / cellSize - 0.5f)), size - 1);
+}
+
+int FlowField::cellIndex(const glm::vec3& position) const {
+    glm::vec3 local = (position - origin) / cellSize;
+    if (local.x < 0.0f || local.y < 0.0f || local.z < 0.0f) {
+        return -1;
+    }
+    int x = static_cast<int>(local.x);
+    int y = static_cast<int>(local.y);
+    int z = static_cast<int>(local.z);
+    if (x >= sizeX || y >= sizeY || z >= sizeZ) {
+        return -1;
+    }
+    return (y * sizeZ + z) * sizeX + x;
+}
+
+bool FlowField::contains(const glm::vec3& position) const {
+    return cellIndex(position) >= 0;
+}
+
+glm::vec3 FlowField::direction(const glm::vec3& position) const {
+    int cell = cellIndex(position);
+    if (cell < 0) {
+        return glm::vec3(0.0f);
+    }
+    const Cell& c = cells[cell];
+    return glm::vec3(c.x, c.y, c.z) * (1.0f / 127.0f);
+}
+
+bool FlowField::blocked(const glm::vec3& position) const {
+    int cell = cellIndex(position);
+    return cell >= 0 && cells[cell].solid;
+}
@@ -0,0 +1,59 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+class Terrain;
+
+// Axis-aligned box that cars keep out of, e.g. a building
+struct ObstacleBox {
+    glm::vec3 min;
+    glm::vec3 max;
+};
+
+struct FlowFieldSettings {
+    float cellSize = 4.0f;
+    int halfCells = 10;             // Cells from the goal to the side, in x and z
+    int belowCells = 12;            // Cells under the goal, which sits above the city
+    int aboveCells = 4;
+    float margin = 1.0f;            // Extra room kept around obstacles and above ground
+};
+
+// Directions towards one goal over a coarse 3D grid around it. Cells
+// inside buildings or under the terrain are blocked; free cells point at
+// their neighbour on the shortest way to the goal around the obstacles,
+// blocked cells at the way out to the nearest free cell.
+class FlowField {
+public:
+    FlowField();
+
+    // Safe off the GL thread; only reads the terrain
+    void build(const glm::vec3& goal, const std::vector<ObstacleBox>& obstacles, const Terrain& terrain,
+               const FlowFieldSettings& settings = FlowFieldSettings());
+
+    bool contains(const glm::vec3& position) const;
+
+    // Unit direction of the cell holding position, zero outside the grid,
+    // at the goal, and where the goal cannot be reached
+    glm::vec3 direction(const glm::vec3& position) const;
+    bool blocked(const glm::vec3& position) const;
+
+private:
+    int cellIndex(const glm::vec3& position) const;
+    void cellRange(float low, float high, float start, int size, int& first, int& last) const;
+
+    glm::vec3 origin;
+    float cellSize;
+    int sizeX, sizeY, sizeZ;
+
+    // Four bytes per cell keeps a field for every city small
+    struct Cell {
+        int8_t x, y, z;             // Direction scaled by 127
+        uint8_t solid;
+    };
+    std::vector<Cell> cells;
+};
+
+#endif // FLOW_FIELD_H
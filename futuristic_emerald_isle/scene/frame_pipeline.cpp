@@ -0,0 +1,72 @@
+#include "frame_pipeline.h"
+#include <chrono>
+
+FramePipeline::FramePipeline() : running(false), current(-1) {}
+
+FramePipeline::~FramePipeline() {
+    stop();
+}
+
+void FramePipeline::start(Producer producer) {
+    stop();
+    this->producer = producer;
+
+    int slot;
+    while (ready.pop(slot)) {}
+    while (recycled.pop(slot)) {}
+    recycled.push(0);
+    recycled.push(1);
+    current = -1;
+
+    running = true;
+    thread = std::thread(&FramePipeline::run, this);
+}
+
+void FramePipeline::stop() {
+    running = false;
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+void FramePipeline::setInput(const FrameInput& input) {
+    std::lock_guard<std::mutex> lock(inputMutex);
+    this->input = input;
+}
+
+const FramePacket* FramePipeline::acquire() {
+    int slot;
+    while (ready.pop(slot)) {
+        if (current >= 0) {
+            recycled.push(current);
+        }
+        current = slot;
+    }
+    return current >= 0 ? &slots[current] : nullptr;
+}
+
+void FramePipeline::run() {
+    auto last = std::chrono::steady_clock::now();
+
+    while (running) {
+        int slot;
+        if (!recycled.pop(slot)) {
+            // The GL thread still holds the other packet
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+
+        FrameInput frameInput;
+        {
+            std::lock_guard<std::mutex> lock(inputMutex);
+            frameInput = input;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        double deltaTime = std::chrono::duration<double>(now - last).count();
+        last = now;
+
+        producer(frameInput, deltaTime, slots[slot]);
+        ready.push(slot);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "render/bird.h"
+#include "utils/spsc_queue.h"
+
+// What the GL thread tells the simulation about the next frame
+struct FrameInput {
+    glm::mat4 view = glm::mat4(1.0f);
+    glm::mat4 projection = glm::mat4(1.0f);
+    glm::mat4 vp = glm::mat4(1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    glm::vec3 lightPosition = glm::vec3(0.0f);
+};
+
+// Everything the GL thread needs to draw one frame of the moving parts,
+// and which of the static ones are in view. Written only by the simulation
+// thread, and read-only once handed over.
+struct FramePacket {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 vp;
+    glm::vec3 cameraPosition;
+    glm::vec3 lightPosition;
+    glm::vec3 lightIntensity;
+
+    std::vector<float> carTransforms;   // AFFINE_FLOATS per visible car
+    std::vector<Bird> birds;
+    std::vector<uint32_t> trees[3];     // Visible trees per forest LOD, in tree order
+    std::vector<uint32_t> buildings;    // Visible building batch records, in record order
+};
+
+// Two-stage frame pipeline. A simulation thread produces FramePackets while
+// the GL thread draws the previous one, so frame time tends towards the
+// slower of the two stages rather than their sum. Two packet slots change
+// hands through lock-free queues: the GL thread holds one, the simulation
+// fills the other.
+class FramePipeline {
+public:
+    // Advances the simulation by deltaTime seconds of real time and fills the packet
+    typedef std::function<void(const FrameInput& input, double deltaTime, FramePacket& packet)> Producer;
+
+    FramePipeline();
+    ~FramePipeline();
+
+    void start(Producer producer);
+    void stop();
+
+    // GL thread: input for the next packet the simulation starts on
+    void setInput(const FrameInput& input);
+
+    // GL thread: the newest finished packet, or the one returned last time
+    // if no newer one is ready. nullptr until the first packet is done. The
+    // packet stays valid until the next call.
+    const FramePacket* acquire();
+
+private:
+    void run();
+
+    Producer producer;
+    std::thread thread;
+    std::atomic<bool> running;
+
+    std::mutex inputMutex;
+    FrameInput input;
+
+    FramePacket slots[2];
+    SpscQueue<int, 2> ready;        // Simulation to GL
+    SpscQueue<int, 2> recycled;     // GL to simulation
+    int current;
+};
+
+#endif // FRAME_PIPELINE_H
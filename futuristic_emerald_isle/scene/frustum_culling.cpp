@@ -0,0 +1,196 @@
+#include "frustum_culling.h"
+#include <algorithm>
+#include <cmath>
+#include <utils/job_system.h>
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define FRUSTUM_CULLING_SSE 1
+#endif
+
+namespace {
+
+// Volumes per job in the parallel culls
+const size_t CULL_GRAIN = 4096;
+
+// The band as squared distances, so no square roots are taken
+struct Band {
+    float nearSquared;
+    float farSquared;
+
+    explicit Band(const CullView& view)
+        : nearSquared(view.nearDistance * view.nearDistance), farSquared(view.farDistance * view.farDistance) {}
+};
+
+bool inBand(const CullView& view, const Band& band, float x, float y, float z) {
+    float dx = x - view.eye.x, dy = y - view.eye.y, dz = z - view.eye.z;
+    float distanceSquared = dx * dx + dy * dy + dz * dz;
+    return distanceSquared >= band.nearSquared && distanceSquared <= band.farSquared;
+}
+
+bool sphereVisible(const CullView& view, const Band& band, const SphereArrays& s, size_t i) {
+    float x = s.centerX[i], y = s.centerY[i], z = s.centerZ[i];
+    float radius = (s.radius ? s.radius[i] : 1.0f) * s.radiusScale;
+    for (const glm::vec4& plane : view.planes) {
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < -radius) return false;
+    }
+    return inBand(view, band, x, y, z);
+}
+
+bool boxVisible(const CullView& view, const Band& band, const BoxArrays& b, size_t i) {
+    float x = b.centerX[i], y = b.centerY[i], z = b.centerZ[i];
+    for (const glm::vec4& plane : view.planes) {
+        // The box's reach towards the plane's normal
+        float reach = std::fabs(plane.x) * b.extentX[i] + std::fabs(plane.y) * b.extentY[i] + std::fabs(plane.z) * b.extentZ[i];
+        if (plane.x * x + plane.y * y + plane.z * z + plane.w < -reach) return false;
+    }
+    return inBand(view, band, x, y, z);
+}
+
+#ifdef FRUSTUM_CULLING_SSE
+inline __m128 planeDistance(const glm::vec4& plane, __m128 x, __m128 y, __m128 z) {
+    __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), x), _mm_mul_ps(_mm_set1_ps(plane.y), y));
+    d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.z), z));
+    return _mm_add_ps(d, _mm_set1_ps(plane.w));
+}
+
+inline __m128 bandMask(const CullView& view, const Band& band, __m128 x, __m128 y, __m128 z) {
+    __m128 dx = _mm_sub_ps(x, _mm_set1_ps(view.eye.x));
+    __m128 dy = _mm_sub_ps(y, _mm_set1_ps(view.eye.y));
+    __m128 dz = _mm_sub_ps(z, _mm_set1_ps(view.eye.z));
+    __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+    return _mm_and_ps(_mm_cmpge_ps(distanceSquared, _mm_set1_ps(band.nearSquared)),
+                      _mm_cmple_ps(distanceSquared, _mm_set1_ps(band.farSquared)));
+}
+
+// Appends the lanes set in mask as indices from first, without branching.
+// Every store lands at or before the slot of its own lane, so out needs no
+// room past the four.
+inline size_t compact(int mask, uint32_t first, uint32_t* out) {
+    size_t n = 0;
+    out[n] = first;     n += mask & 1;
+    out[n] = first + 1; n += (mask >> 1) & 1;
+    out[n] = first + 2; n += (mask >> 2) & 1;
+    out[n] = first + 3; n += (mask >> 3) & 1;
+    return n;
+}
+#endif
+
+// Splits [0, count) into CULL_GRAIN pieces culled in parallel, each into
+// its own stretch of visible, then closes the gaps between them
+template <typename Cull>
+void cullParallel(size_t count, std::vector<uint32_t>& visible, const Cull& cull) {
+    visible.resize(count);
+    size_t pieces = (count + CULL_GRAIN - 1) / CULL_GRAIN;
+    std::vector<size_t> found(pieces);
+    jobSystem.parallelFor(pieces, 1, [&](size_t begin, size_t end) {
+        for (size_t piece = begin; piece < end; ++piece) {
+            size_t first = piece * CULL_GRAIN;
+            size_t last = std::min(first + CULL_GRAIN, count);
+            found[piece] = cull(first, last, visible.data() + first);
+        }
+    });
+
+    size_t total = 0;
+    for (size_t piece = 0; piece < pieces; ++piece) {
+        const uint32_t* from = visible.data() + piece * CULL_GRAIN;
+        std::copy(from, from + found[piece], visible.data() + total);
+        total += found[piece];
+    }
+    visible.resize(total);
+}
+
+}
+
+CullView MakeCullView(const glm::mat4& vp, const glm::vec3& eye, float nearDistance, float farDistance) {
+    // glm is column-major, row r of vp is (vp[0][r], vp[1][r], vp[2][r], vp[3][r])
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; ++r) {
+        rows[r] = glm::vec4(vp[0][r], vp[1][r], vp[2][r], vp[3][r]);
+    }
+
+    CullView view;
+    view.planes[0] = rows[3] + rows[0];    // Left
+    view.planes[1] = rows[3] - rows[0];    // Right
+    view.planes[2] = rows[3] + rows[1];    // Bottom
+    view.planes[3] = rows[3] - rows[1];    // Top
+    view.planes[4] = rows[3] + rows[2];    // Near
+    view.planes[5] = rows[3] - rows[2];    // Far
+    for (glm::vec4& plane : view.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) plane = plane * (1.0f / length);
+    }
+
+    view.eye = eye;
+    view.nearDistance = nearDistance;
+    view.farDistance = farDistance;
+    return view;
+}
+
+size_t CullSpheres(const CullView& view, const SphereArrays& spheres, size_t begin, size_t end, uint32_t* out) {
+    Band band(view);
+    size_t n = 0;
+    size_t i = begin;
+#ifdef FRUSTUM_CULLING_SSE
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(spheres.centerX + i);
+        __m128 y = _mm_loadu_ps(spheres.centerY + i);
+        __m128 z = _mm_loadu_ps(spheres.centerZ + i);
+        __m128 radius = _mm_set1_ps(spheres.radiusScale);
+        if (spheres.radius) radius = _mm_mul_ps(_mm_loadu_ps(spheres.radius + i), radius);
+        __m128 reach = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+        __m128 mask = bandMask(view, band, x, y, z);
+        for (const glm::vec4& plane : view.planes) {
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(planeDistance(plane, x, y, z), reach));
+        }
+        n += compact(_mm_movemask_ps(mask), static_cast<uint32_t>(i), out + n);
+    }
+#endif
+    for (; i < end; ++i) {
+        out[n] = static_cast<uint32_t>(i);
+        n += sphereVisible(view, band, spheres, i);
+    }
+    return n;
+}
+
+size_t CullBoxes(const CullView& view, const BoxArrays& boxes, size_t begin, size_t end, uint32_t* out) {
+    Band band(view);
+    size_t n = 0;
+    size_t i = begin;
+#ifdef FRUSTUM_CULLING_SSE
+    for (; i + 4 <= end; i += 4) {
+        __m128 x = _mm_loadu_ps(boxes.centerX + i);
+        __m128 y = _mm_loadu_ps(boxes.centerY + i);
+        __m128 z = _mm_loadu_ps(boxes.centerZ + i);
+        __m128 ex = _mm_loadu_ps(boxes.extentX + i);
+        __m128 ey = _mm_loadu_ps(boxes.extentY + i);
+        __m128 ez = _mm_loadu_ps(boxes.extentZ + i);
+
+        __m128 mask = bandMask(view, band, x, y, z);
+        for (const glm::vec4& plane : view.planes) {
+            __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey));
+            reach = _mm_add_ps(reach, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+            __m128 d = planeDistance(plane, x, y, z);
+            mask = _mm_and_ps(mask, _mm_cmpge_ps(d, _mm_sub_ps(_mm_setzero_ps(), reach)));
+        }
+        n += compact(_mm_movemask_ps(mask), static_cast<uint32_t>(i), out + n);
+    }
+#endif
+    for (; i < end; ++i) {
+        out[n] = static_cast<uint32_t>(i);
+        n += boxVisible(view, band, boxes, i);
+    }
+    return n;
+}
+
+void CullSpheresParallel(const CullView& view, const SphereArrays& spheres, size_t count, std::vector<uint32_t>& visible) {
+    cullParallel(count, visible, [&](size_t begin, size_t end, uint32_t* out) {
+        return CullSpheres(view, spheres, begin, end, out);
+    });
+}
+
+void CullBoxesParallel(const CullView& view, const BoxArrays& boxes, size_t count, std::vector<uint32_t>& visible) {
+    cullParallel(count, visible, [&](size_t begin, size_t end, uint32_t* out) {
+        return CullBoxes(view, boxes, begin, end, out);
+    });
+}
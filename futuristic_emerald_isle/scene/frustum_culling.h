@@ -0,0 +1,55 @@
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// What a cull keeps: volumes touching the view frustum whose centres are
+// between nearDistance and farDistance of the eye. The distance band is the
+// draw distance or LOD ring of the caller, the frustum the same for all.
+struct CullView {
+    glm::vec4 planes[6];            // Normals point inwards: dot(xyz, p) + w >= 0 inside
+    glm::vec3 eye;
+    float nearDistance;
+    float farDistance;
+};
+
+// Planes from the rows of vp (Gribb and Hartmann), normalised so plane
+// distances are in world units
+CullView MakeCullView(const glm::mat4& vp, const glm::vec3& eye, float nearDistance = 0.0f,
+                      float farDistance = std::numeric_limits<float>::max());
+
+// Structure-of-arrays bounding spheres. The radius of sphere i is
+// radius[i] * radiusScale, or just radiusScale when radius is null.
+struct SphereArrays {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* radius;
+    float radiusScale;
+};
+
+// Structure-of-arrays axis-aligned boxes, as centre and half extent
+struct BoxArrays {
+    const float* centerX;
+    const float* centerY;
+    const float* centerZ;
+    const float* extentX;
+    const float* extentY;
+    const float* extentZ;
+};
+
+// Writes the indices in [begin, end) that pass to out, in order, and
+// returns how many. Four at a time with SSE where available.
+size_t CullSpheres(const CullView& view, const SphereArrays& spheres, size_t begin, size_t end, uint32_t* out);
+size_t CullBoxes(const CullView& view, const BoxArrays& boxes, size_t begin, size_t end, uint32_t* out);
+
+// The whole of [0, count) in parallel pieces on jobSystem, compacted into
+// visible in index order
+void CullSpheresParallel(const CullView& view, const SphereArrays& spheres, size_t count, std::vector<uint32_t>& visible);
+void CullBoxesParallel(const CullView& view, const BoxArrays& boxes, size_t count, std::vector<uint32_t>& visible);
+
+#endif // FRUSTUM_CULLING_H
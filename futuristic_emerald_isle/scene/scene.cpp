@@ -1,13 +1,52 @@
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <scene/scene.h>
 #include <random>
 #include <set>
 #include <render/Forest.h>
+#include <render/mesh_pool.h>
+#include <render/program_cache.h>
+#include <scene/frustum_culling.h>
+#include <utils/job_system.h>
+#include <utils/load_textures.h>
+#include <utils/startup_timeline.h>
+
+namespace {
+
+// Mesh pool room for the glTF models on top of the terrain, the pool grows
+// past it if needed
+const GLuint MODEL_POOL_VERTICES = 1 << 20;
+const GLuint MODEL_POOL_INDICES = 1 << 22;
+
+}
 
 Scene::~Scene() {
     cleanup();
 }
 
+void Scene::precompileShaders() {
+    // Issue every compile up front so the driver can overlap them, nothing
+    // blocks until the first LoadShadersFromFile for a given pair
+    const char* shaders[] = {
+        "../futuristic_emerald_isle/shaders/skybox",
+        "../futuristic_emerald_isle/shaders/terrain",
+        "../futuristic_emerald_isle/shaders/axis",
+        "../futuristic_emerald_isle/shaders/box",
+        "../futuristic_emerald_isle/shaders/car",
+        "../futuristic_emerald_isle/shaders/bird",
+        "../futuristic_emerald_isle/shaders/tree_lod0/tree",
+        "../futuristic_emerald_isle/shaders/tree_lod1/tree",
+        "../futuristic_emerald_isle/shaders/tree_lod2/tree",
+    };
+
+    for (const char* shader : shaders) {
+        programCache.precompile(std::string(shader) + ".vert", std::string(shader) + ".frag");
+    }
+}
+
 void Scene::setupLighting() {
     const glm::vec3 wave500(0.0f, 255.0f, 146.0f);
     const glm::vec3 wave600(255.0f, 190.0f, 0.0f);
@@ -19,6 +58,75 @@ void Scene::setupLighting() {
     //lightCube.position = lightPosition;
 }
 
+void Scene::initialize(const SceneSettings& settings) {
+    StartupTimeline timeline;
+
+    setupLighting();
+    initializeAxis();
+
+    // Room for the terrain grid plus the models, before any of them arrive
+    GLuint terrainVertices = (settings.terrainWidth + 1) * (settings.terrainDepth + 1);
+    GLuint terrainIndices = settings.terrainWidth * settings.terrainDepth * 6;
+    meshPool.initialize(terrainVertices + MODEL_POOL_VERTICES, terrainIndices + MODEL_POOL_INDICES);
+
+    // Everything that only needs the loader is requested first, so file
+    // reads, glTF parses and image decodes overlap all of the below
+    loader.start();
+    timeline.measure("request streams", [&] {
+        loadFacades();
+        forestLOD0.initialize(0, 0.0f, 50.0f, loader);
+        forestLOD1.initialize(1, 50.0f, 100.0f, loader);
+        forestLOD2.initialize(2, 100.0f, 1000.0f, loader);
+        initializeCars(settings.cars);
+        if (!birds.initialize("../futuristic_emerald_isle/assets/imported_models/lowpoly_seagull/scene.gltf", terrain, loader)) {
+            std::cerr << "Failed to initialize birds!" << std::endl;
+        }
+    });
+
+    // CPU work. Hills and trees need the terrain grid, the images nothing.
+    // Cities and birds both start from the highest points, so one search
+    // serves both.
+    std::vector<uint8_t> grassTexture, skyTexture;
+    std::vector<glm::vec3> hilltops;
+    TaskGraph startup;
+    TaskGraph::Task grid = startup.add([&] {
+        timeline.measure("terrain grid", [&] {
+            terrain.generate(settings.terrainWidth, settings.terrainDepth, settings.terrainHeight, 100.0f);
+        });
+    });
+    startup.add([&] {
+        timeline.measure("grass texture", [&] { ReadCookedTexture(Terrain::TEXTURE_PATH, grassTexture); });
+    });
+    startup.add([&] {
+        timeline.measure("sky texture", [&] { ReadCookedTexture(Skybox::TEXTURE_PATH, skyTexture); });
+    });
+    startup.add([&] {
+        timeline.measure("hilltops", [&] { hilltops = terrain.getHighestPoints(std::max(settings.cities, settings.birds)); });
+    }, {grid});
+    startup.add([&] {
+        timeline.measure("trees", [&] {
+            std::vector<glm::vec3> positions;
+            std::vector<float> rotations, scales;
+            scatterTrees(terrain, positions, rotations, scales);
+            trees.setup(positions, rotations, scales);
+        });
+    }, {grid});
+    jobSystem.run(startup);
+
+    // GL uploads, in order on this thread
+    timeline.measure("terrain upload", [&] { terrain.upload(grassTexture); });
+    timeline.measure("skybox upload", [&] { skybox.initialize(settings.skyboxPosition, settings.skyboxScale, skyTexture); });
+    timeline.measure("building batch", [&] { buildingBatch.initialize(); });
+    timeline.measure("stream buffer", [&] { renderQueue.initialize(); });
+    timeline.measure("birds", [&] {
+        std::lock_guard<std::mutex> lock(simulationMutex);
+        birds.generateBirds(std::vector<glm::vec3>(hilltops.begin(), hilltops.begin() + std::min<size_t>(settings.birds, hilltops.size())));
+    });
+    initializeCitiesOnHills(std::vector<glm::vec3>(hilltops.begin(), hilltops.begin() + std::min<size_t>(settings.cities, hilltops.size())));
+
+    timeline.report(std::cout);
+}
+
 void Scene::initializeAxis() {
     axis.initialize();
 }
@@ -33,7 +141,7 @@ void Scene::initializeTerrain(int width, int depth, float maxHeight) {
 
 void Scene::initializeCityOnHill(const glm::vec3& hillPosition, int cityRows, int cityCols, float buildingWidth, float buildingSpacing) {
     City city;
-    if (!city.initialize()) {
+    if (!city.initialize(facades)) {
         std::cerr << "Failed to initialize city!" << std::endl;
         return;
     }
@@ -73,83 +181,127 @@ void Scene::initializeCityOnHill(const glm::vec3& hillPosition, int cityRows, in
                 vFactor,
                 city.facades.at(textureNum)
             );
-
-            cities.push_back(city);
         }
     }
+
+    cities.push_back(city);
 }
 
-void Scene::initializeCitiesOnHills(int nCities) {
-    std::vector<glm::vec3> highestPoints = terrain.getHighestPoints(nCities);
-    for (const auto& point : highestPoints) {
-        initializeCityOnHill(point, 4, 4, 2.0f, 4.0f);
+void Scene::loadFacades() {
+    const int nFacades = 6;
+
+    pendingCityInputs++;
+    facades.assign(nFacades, 0);
+    for (int i = 0; i < nFacades; ++i) {
+        pendingCityInputs++;
+        std::stringstream texturePath;
+        texturePath << "../futuristic_emerald_isle/assets/textures/facade" << i << ".jpg";
+        loader.loadTexture(texturePath.str(), [this, i](GLuint textureID) {
+            facades[i] = textureID;
+            initializeCitiesOnHills(std::vector<glm::vec3>());
+        });
     }
 }
 
-void Scene::initializeForest(const Terrain& terrain, int nTrees) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-
-    float halfWidth = terrain.getWidth() / 2.0f;
-    float halfDepth = terrain.getDepth() / 2.0f;
+void Scene::initializeCitiesOnHills(const std::vector<glm::vec3>& hills) {
+    // Called once with the hills and once per facade, all on the GL thread.
+    // Once everything is in, each city is built in its own pump slice.
+    cityHills.insert(cityHills.end(), hills.begin(), hills.end());
+    if (--pendingCityInputs > 0) return;
 
-    std::uniform_real_distribution<float> xDist(-halfWidth, halfWidth);
-    std::uniform_real_distribution<float> zDist(-halfDepth, halfDepth);
-    std::uniform_real_distribution<float> scaleDist(1.0f, 1.7f);
-    std::uniform_real_distribution<float> rotationDist(0.0f, 360.0f);
-
-    std::vector<glm::vec3> positions;
-    std::vector<float> rotations, scales;
-    int generated = 0;
-    while (generated < 25000) {
-        float x = xDist(gen);
-        float z = zDist(gen);
-        float altitude = terrain.getHeightAt(x, z);
-
-        if (altitude <= 10.0f) {
-            positions.emplace_back(x, altitude, z);
-            float scaleFactor = scaleDist(gen);
-            scales.emplace_back(scaleFactor);
-            float yRotation = rotationDist(gen);
-            rotations.emplace_back(yRotation);
-            generated++;
-        }
+    for (const auto& point : cityHills) {
+        loader.runOnMainThread([this, point] { initializeCityOnHill(point, 4, 4, 2.0f, 4.0f); });
     }
+    loader.runOnMainThread([this] {
+        {
+            // The simulation culls the batch
+            std::lock_guard<std::mutex> lock(simulationMutex);
+            buildingBatch.build(cities);
+        }
+        citiesReady = true;
+        placeCars();
+    });
+}
 
-    forestLOD0.initialize(0, 0.0f, 50.0f);
-    forestLOD0.setupLOD(0, positions, rotations, scales);
+void Scene::scatterTrees(const Terrain& terrain, std::vector<glm::vec3>& positions, std::vector<float>& rotations, std::vector<float>& scales) {
+    const size_t treeCount = 25000;
+    const size_t treesPerJob = 1024;
 
-    forestLOD1.initialize(1, 50.0f, 100.0f);
-    forestLOD1.setupLOD(1, positions, rotations, scales);
+    float halfWidth = terrain.getWidth() / 2.0f;
+    float halfDepth = terrain.getDepth() / 2.0f;
 
-    forestLOD2.initialize(2, 100.0f, 1000.0f);
-    forestLOD2.setupLOD(2, positions, rotations, scales);
+    positions.resize(treeCount);
+    rotations.resize(treeCount);
+    scales.resize(treeCount);
 
+    // Each job draws its own share of the trees from its own generator
+    std::random_device rd;
+    unsigned int seed = rd();
+    size_t jobs = (treeCount + treesPerJob - 1) / treesPerJob;
+    jobSystem.parallelFor(jobs, 1, [&](size_t beginJob, size_t endJob) {
+        for (size_t job = beginJob; job < endJob; ++job) {
+            std::mt19937 gen(seed + static_cast<unsigned int>(job));
+            std::uniform_real_distribution<float> xDist(-halfWidth, halfWidth);
+            std::uniform_real_distribution<float> zDist(-halfDepth, halfDepth);
+            std::uniform_real_distribution<float> scaleDist(1.0f, 1.7f);
+            std::uniform_real_distribution<float> rotationDist(0.0f, 360.0f);
+
+            size_t generated = job * treesPerJob;
+            size_t last = std::min(generated + treesPerJob, treeCount);
+            while (generated < last) {
+                float x = xDist(gen);
+                float z = zDist(gen);
+                float altitude = terrain.getHeightAt(x, z);
+
+                if (altitude <= 10.0f) {
+                    positions[generated] = glm::vec3(x, altitude, z);
+                    scales[generated] = scaleDist(gen);
+                    rotations[generated] = rotationDist(gen);
+                    generated++;
+                }
+            }
+        }
+    });
 }
 
 void Scene::initializeCars(int nCars) {
-    if (!cars.initialize("../futuristic_emerald_isle/assets/imported_models/flying_car/scene.gltf")) {
+    if (!cars.initialize("../futuristic_emerald_isle/assets/imported_models/flying_car/scene.gltf", loader)) {
         std::cerr << "Failed to initialize cars!" << std::endl;
         return;
     }
 
+    // Airways run between cities, so cars are placed once those exist
+    carCount = nCars;
+    if (citiesReady) {
+        placeCars();
+    }
+}
+
+void Scene::placeCars() {
+    if (carCount == 0) return;
+
+    // City positions become airway nodes, building boxes shape their flow fields
     std::vector<glm::vec3> cityPositions;
+    std::vector<ObstacleBox> obstacles;
     for (const City& city : cities) {
         if (!city.buildings.empty()) {
             cityPositions.push_back(city.buildings[0].position);
         }
+        for (const Building& building : city.buildings) {
+            obstacles.push_back({building.position - building.scale, building.position + building.scale});
+        }
     }
 
-    cars.generateCars(cityPositions, nCars);
-}
-
-void Scene::initializeBirds(int nBirds) {
-    if (!birds.initialize("../futuristic_emerald_isle/assets/imported_models/lowpoly_seagull/scene.gltf")) {
-        std::cerr << "Failed to initialize birds!" << std::endl;
-        return;
-    }
-    float altitudeThreshold = 30.0f;
-    birds.generateBirds(terrain, nBirds, altitudeThreshold);
+    // The airways sample the terrain along every route, so they are built on a worker
+    auto airways = std::make_shared<AirwayGraph>();
+    const Terrain* source = &terrain;
+    int count = carCount;
+    loader.submit([source, airways, cityPositions, obstacles] { airways->build(cityPositions, obstacles, *source); },
+                  [this, airways, count] {
+                      std::lock_guard<std::mutex> lock(simulationMutex);
+                      cars.generateCars(std::move(*airways), count);
+                  });
+    carCount = 0;
 }
 
 void Scene::adjustLighting(float threshold, float darkFactor, const glm::vec3& cameraPosition) {
@@ -165,37 +317,117 @@ void Scene::adjustLighting(float threshold, float darkFactor, const glm::vec3& c
     }
 }
 
-void Scene::render(const glm::mat4& vp, const glm::vec3& cameraPosition, double deltaTime) {
-    adjustLighting(20.0f, 0.01f, cameraPosition);
+void Scene::startSimulation() {
+    simulationTime = 0.0;
+    pipeline.start([this](const FrameInput& input, double deltaTime, FramePacket& packet) { produceFrame(input, deltaTime, packet); });
+}
 
-    // DEBUG AXIS
-    // axis.render(vp);
-    skybox.render(vp);
-    terrain.render(vp, lightPosition, lightIntensity);
-    cars.render(vp, cameraPosition, 200.0f, lightPosition, lightIntensity, deltaTime);
-    birds.render(vp, cameraPosition, 300.0f, lightPosition, lightIntensity, deltaTime);
-    forestLOD0.render(vp, cameraPosition, lightPosition, lightIntensity);
-    forestLOD1.render(vp, cameraPosition, lightPosition, lightIntensity);
-    forestLOD2.render(vp, cameraPosition, lightPosition, lightIntensity);
+void Scene::produceFrame(const FrameInput& input, double deltaTime, FramePacket& packet) {
+    std::lock_guard<std::mutex> lock(simulationMutex);
 
-    for (City& city : cities) {
-        city.render(vp, cameraPosition, 800.0f, lightPosition, lightIntensity);
+    // Fixed steps, then blend between the last two. After a long hitch the
+    // world slows down rather than stalling.
+    simulationTime += deltaTime;
+    int steps = 0;
+    while (simulationTime >= TIMESTEP && steps < MAX_STEPS_PER_FRAME) {
+        simulationTime -= TIMESTEP;
+        steps++;
     }
+    if (simulationTime > TIMESTEP) {
+        simulationTime = fmod(simulationTime, TIMESTEP);
+    }
+    float alpha = static_cast<float>(simulationTime / TIMESTEP);
+
+    adjustLighting(20.0f, 0.01f, input.cameraPosition);
+
+    packet.view = input.view;
+    packet.projection = input.projection;
+    packet.vp = input.vp;
+    packet.cameraPosition = input.cameraPosition;
+    packet.lightPosition = input.lightPosition;
+    packet.lightIntensity = lightIntensity;
+
+    // Cars and birds never touch each other's state, so each steps and
+    // fills its part of the packet as a chain of its own
+    TaskGraph frame;
+    glm::vec3 cameraPosition = input.cameraPosition;
+    TaskGraph::Task carSteps = frame.add([this, steps, cameraPosition] {
+        for (int i = 0; i < steps; ++i) cars.update(TIMESTEP, cameraPosition);
+    });
+    TaskGraph::Task birdSteps = frame.add([this, steps] {
+        for (int i = 0; i < steps; ++i) birds.update(TIMESTEP);
+    });
+    CullView carView = MakeCullView(input.vp, input.cameraPosition, 0.0f, 200.0f);
+    CullView birdView = MakeCullView(input.vp, input.cameraPosition, 0.0f, 300.0f);
+    frame.add([&] { cars.prepare(carView, alpha, packet.carTransforms); }, {carSteps});
+    frame.add([&] { birds.prepare(birdView, alpha, packet.birds); }, {birdSteps});
+
+    // Static scenery only needs culling, one band per forest LOD
+    const Forest* forests[] = {&forestLOD0, &forestLOD1, &forestLOD2};
+    CullView treeViews[3];
+    for (int lod = 0; lod < 3; ++lod) {
+        treeViews[lod] = MakeCullView(input.vp, input.cameraPosition, forests[lod]->minRenderRadius, forests[lod]->maxRenderRadius);
+        frame.add([&, lod] { trees.cull(treeViews[lod], packet.trees[lod]); });
+    }
+    CullView buildingView = MakeCullView(input.vp, input.cameraPosition, 0.0f, BUILDING_RENDER_RADIUS);
+    frame.add([&] { buildingBatch.cull(buildingView, packet.buildings); });
+    jobSystem.run(frame);
+}
+
+void Scene::render(const FramePacket& packet) {
+    RenderView view;
+    view.view = packet.view;
+    view.projection = packet.projection;
+    view.vp = packet.vp;
+    view.cameraPosition = packet.cameraPosition;
+    view.lightPosition = packet.lightPosition;
+    view.lightIntensity = packet.lightIntensity;
+
+    // DEBUG AXIS
+    // axis.render(view.vp);
+    renderQueue.begin(view);
+    skybox.submit(renderQueue);
+    terrain.submit(renderQueue);
+    cars.submit(renderQueue, packet.carTransforms);
+    birds.submit(renderQueue, packet.birds);
+    forestLOD0.submit(renderQueue, trees, packet.trees[0]);
+    forestLOD1.submit(renderQueue, trees, packet.trees[1]);
+    forestLOD2.submit(renderQueue, trees, packet.trees[2]);
+    buildingBatch.submit(renderQueue, packet.buildings);
+    renderQueue.flush();
 }
 
 void Scene::cleanup() {
+    // Stop the simulation and drop anything still in flight before the
+    // objects they target go away
+    pipeline.stop();
+    loader.stop();
+
     skybox.cleanup();
+    buildingBatch.cleanup();
     axis.cleanup();
     terrain.cleanup();
+    cars.cleanup();
     birds.cleanup();
     forestLOD0.cleanup();
     forestLOD1.cleanup();
     forestLOD2.cleanup();
+    trees.clear();
 
     for (City& city : cities) {
         city.cleanup();
     }
     cities.clear();
+    citiesReady = false;
+
+    for (GLuint& facade : facades) {
+        if (facade != 0) glDeleteTextures(1, &facade);
+    }
+    facades.clear();
+
+    renderQueue.cleanup();
+    meshPool.cleanup();
+    programCache.cleanup();
 }
 
 
@@ -232,12 +464,10 @@ void Scene::placeBuildingsOnHills(Terrain& terrain, int numHills, int buildingsP
 
             Building b;
             float buildingHeight = (rand() % 5 + 1) * 10.0f;
-            b.initialize(
-                buildingPosition,
-                glm::vec3(10.0f, buildingHeight, 10.0f),
-                vFactor,
-                rand() % 5
-            );
+            b.position = buildingPosition;
+            b.scale = glm::vec3(10.0f, buildingHeight, 10.0f);
+            b.vFactor = vFactor;
+            b.facadeID = rand() % 5;
             buildings.push_back(b);
         }
     }
@@ -264,13 +494,10 @@ void Scene::initializeCity(int cityRows, int cityCols, float buildingWidth, floa
             int textureNum = rand() % 5;
 
             Building b;
-            glm::vec3 position(j * spacingX, newHeight, i * spacingZ);
-            b.initialize(
-                position,
-                glm::vec3(newWidth, newHeight, buildingWidth),
-                vFactor,
-                textureNum
-            );
+            b.position = glm::vec3(j * spacingX, newHeight, i * spacingZ);
+            b.scale = glm::vec3(newWidth, newHeight, buildingWidth);
+            b.vFactor = vFactor;
+            b.facadeID = textureNum;
             buildings.push_back(b);
         }
     }
@@ -1,17 +1,34 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include <mutex>
 #include <vector>
 #include <render/building.h>
 #include "render/axys_xyz.h"
 #include "render/birds.h"
+#include "render/building_batch.h"
 #include "render/cars.h"
 #include "render/city.h"
 #include "render/skybox.h"
 #include "render/terrain.h"
 #include "render/forest.h"
+#include "render/render_queue.h"
+#include "frame_pipeline.h"
+#include "utils/async_loader.h"
 #include "utils/light_cube.cpp"
 
+// What Scene::initialize builds
+struct SceneSettings {
+    int terrainWidth = 4000;
+    int terrainDepth = 4000;
+    float terrainHeight = 30.0f;
+    glm::vec3 skyboxPosition = glm::vec3(0.0f);
+    glm::vec3 skyboxScale = glm::vec3(3000.0f);
+    int cities = 100;
+    int cars = 200;
+    int birds = 400;
+};
+
 class Scene {
 
 public:
@@ -21,29 +38,69 @@ public:
 
     std::vector<Building> buildings;
     std::vector<City> cities;
+    BuildingBatch buildingBatch;
     AxisXYZ axis;
     Skybox skybox;
     Terrain terrain;
     Cars cars;
     Birds birds;
+    TreeSet trees;
     Forest forestLOD0, forestLOD1, forestLOD2;
 
+    // Cities, forest and creatures stream in through the loader; main()
+    // pumps it once per frame and each part starts drawing once it lands
+    AsyncLoader loader;
+    std::vector<GLuint> facades;
+    std::vector<glm::vec3> cityHills;
+    int pendingCityInputs = 0;
+    bool citiesReady = false;
+    int carCount = 0;
+
+    FramePipeline pipeline;
+    std::mutex simulationMutex;
+    double simulationTime = 0.0;
+
+    // Every draw of a frame goes through here, sorted to share state
+    RenderQueue renderQueue;
+
     ~Scene();
 
+    void precompileShaders();
     void setupLighting();
     void adjustLighting(float threshold, float darkFactor, const glm::vec3& cameraPosition);
 
+    // Builds the scene as one startup graph. Loader streams are requested
+    // first; terrain, hilltops, trees and the sky and grass images are then
+    // worked out as tasks on the job system; the GL uploads the first frame
+    // needs follow in order on this thread. Cities, trees, cars and birds
+    // keep streaming in through the loader afterwards.
+    void initialize(const SceneSettings& settings);
+
     void initializeCity(int cityRows, int cityCols, float buildingWidth, float buildingSpacing);
     void initializeAxis();
     void initializeSkybox(glm::vec3 position, glm::vec3 scale);
     void initializeTerrain(int width, int depth, float maxHeight);
     void initializeCityOnHill(const glm::vec3& hillPosition, int cityRows, int cityCols, float buildingWidth, float buildingSpacing);
-    void initializeCitiesOnHills(int nCities);
-    void initializeForest(const Terrain &terrain, int nTrees);
+    // Cities go up once the facades from loadFacades() and the hills are all in
+    void loadFacades();
+    void initializeCitiesOnHills(const std::vector<glm::vec3>& hills);
     void initializeCars(int nCars);
-    void initializeBirds(int nBirds);
+    void placeCars();
+    static void scatterTrees(const Terrain& terrain, std::vector<glm::vec3>& positions, std::vector<float>& rotations, std::vector<float>& scales);
+
+    // The simulation advances in fixed steps, at a lower rate than a typical
+    // frame rate, on the pipeline's thread. Packets blend the last two steps.
+    static constexpr double TIMESTEP = 1.0 / 30.0;
+    static const int MAX_STEPS_PER_FRAME = 4;
+    static constexpr float BUILDING_RENDER_RADIUS = 800.0f;
+
+    // Cars and birds are simulated on their own thread from here on. Loader
+    // callbacks that touch their state hold simulationMutex.
+    void startSimulation();
+    void produceFrame(const FrameInput& input, double deltaTime, FramePacket& packet);
 
-    void render(const glm::mat4& vp, const glm::vec3& cameraPosition, double deltaTime);
+    // GL thread only. State changes made and saved show in renderQueue.getStats().
+    void render(const FramePacket& packet);
     void cleanup();
 
     /*** LEGACY METHODS ***/
@@ -0,0 +1,53 @@
+#include "spatial_hash.h"
+#include "utils/job_system.h"
+#include <cmath>
+
+SpatialHash::SpatialHash() : cellSize(1.0f), xBits(0), yBits(0), zBits(0) {}
+
+int SpatialHash::cell(float coordinate) const {
+    return static_cast<int>(std::floor(coordinate / cellSize));
+}
+
+uint32_t SpatialHash::bucket(int x, int y, int z) const {
+    uint32_t ux = static_cast<uint32_t>(x) & ((1u << xBits) - 1);
+    uint32_t uz = static_cast<uint32_t>(z) & ((1u << zBits) - 1);
+    uint32_t uy = static_cast<uint32_t>(y) & ((1u << yBits) - 1);
+    return ux | uz << xBits | uy << (xBits + zBits);
+}
+
+void SpatialHash::build(const float* x, const float* y, const float* z, size_t count, float cellSize, size_t grain) {
+    this->cellSize = cellSize;
+
+    // Everything flies over a flat-ish world, so most of the table goes to
+    // the ground plane
+    uint32_t tableBits = 14;
+    while ((1u << tableBits) < count * 2) {
+        tableBits++;
+    }
+    uint32_t tableSize = 1u << tableBits;
+    yBits = 3;
+    xBits = (tableBits - yBits + 1) / 2;
+    zBits = tableBits - yBits - xBits;
+
+    pointBucket.resize(count);
+    jobSystem.parallelFor(count, grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            pointBucket[i] = bucket(cell(x[i]), cell(y[i]), cell(z[i]));
+        }
+    });
+
+    // Bucket h is [cellStart[h], cellStart[h + 1]), so a lookup touches one
+    // array rather than a start and an end
+    cellStart.assign(tableSize + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        cellStart[pointBucket[i] + 1]++;
+    }
+    for (uint32_t h = 0; h < tableSize; ++h) {
+        cellStart[h + 1] += cellStart[h];
+    }
+    cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        order[cellCursor[pointBucket[i]]++] = static_cast<uint32_t>(i);
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Uniform grid over a set of points, hashed into a power-of-two table. The
+// grid wraps rather than scrambles, so neighbouring cells stay close
+// together in the table and in the sorted points. build() counting sorts
+// the points by bucket, stably so the order is the same every run.
+//
+// Cells far apart can share a bucket, so a lookup still has to check the
+// distance to every point it finds.
+class SpatialHash {
+public:
+    SpatialHash();
+
+    // Points are (x[i], y[i], z[i]); cells are assigned on the job system,
+    // grain points per job
+    void build(const float* x, const float* y, const float* z, size_t count, float cellSize, size_t grain);
+
+    float getCellSize() const { return cellSize; }
+    int cell(float coordinate) const;
+    uint32_t bucket(int x, int y, int z) const;
+
+    // Bucket h holds slots [bucketStart(h), bucketEnd(h)) of the sorted order
+    uint32_t bucketStart(uint32_t h) const { return cellStart[h]; }
+    uint32_t bucketEnd(uint32_t h) const { return cellStart[h + 1]; }
+    // The point in each slot
+    const std::vector<uint32_t>& getOrder() const { return order; }
+
+private:
+    float cellSize;
+    uint32_t xBits, yBits, zBits;
+    std::vector<uint32_t> pointBucket;
+    std::vector<uint32_t> cellStart, cellCursor;
+    std::vector<uint32_t> order;
+};
+
+#endif // SPATIAL_HASH_H
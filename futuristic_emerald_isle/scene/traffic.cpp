@@ -0,0 +1,422 @@
+#include "traffic.h"
+#include "utils/job_system.h"
+#include "utils/startup_timeline.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+const size_t CAR_GRAIN = 1024;
+const size_t LANE_GRAIN = 8;
+
+uint32_t xorshift(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+}
+
+Traffic::Traffic() {}
+
+Traffic::~Traffic() {
+    cleanup();
+}
+
+void Traffic::cleanup() {
+    clear();
+}
+
+void Traffic::setAirways(AirwayGraph&& graph) {
+    clear();
+    airways = std::move(graph);
+}
+
+void Traffic::clear() {
+    edge.clear();
+    distance.clear();
+    speed.clear();
+    destination.clear();
+    random.clear();
+    offsetX.clear(); offsetY.clear(); offsetZ.clear();
+    driftX.clear(); driftY.clear(); driftZ.clear();
+    positionX.clear(); positionY.clear(); positionZ.clear();
+    heading.clear();
+    previousPositionX.clear(); previousPositionY.clear(); previousPositionZ.clear();
+    previousHeading.clear();
+    laneStart.clear();
+    laneCars.clear();
+    moved.clear();
+    movedFlag.clear();
+    sortCursor.clear();
+    sortScratch.clear();
+    laneCount.clear();
+    laneTail.clear();
+    steerTime.clear();
+    scheduler.resize(0);
+}
+
+size_t Traffic::addCars(size_t count, uint32_t seed) {
+    size_t edgeCount = airways.getEdgeCount();
+    if (edgeCount == 0) {
+        return 0;
+    }
+
+    std::vector<uint32_t> fill(edgeCount, 0);
+    for (size_t car = 0; car < edge.size(); ++car) {
+        fill[edge[car]]++;
+    }
+
+    // Spread the cars round-robin from a random lane, each new one a car
+    // spacing behind the last car already in that lane
+    uint32_t state = seed | 1u;
+    uint32_t next = xorshift(state) % edgeCount;
+    size_t full = 0;
+    size_t added = 0;
+    while (added < count && full < edgeCount) {
+        const AirwayGraph::Edge& lane = airways.getEdge(next);
+        if (fill[next] >= lane.capacity) {
+            full++;
+            next = (next + 1) % edgeCount;
+            continue;
+        }
+        full = 0;
+
+        size_t car = edge.size();
+        edge.push_back(next);
+        distance.push_back(lane.length - (fill[next] + 0.5f) * airways.getCarSpacing());
+        speed.push_back(0.0f);
+        random.push_back(xorshift(state) | 1u);
+        destination.push_back(0);
+        destination[car] = pickDestination(car, lane.to);
+        fill[next]++;
+        added++;
+
+        next = (next + 1 + xorshift(state) % 7) % edgeCount;
+    }
+
+    size_t total = edge.size();
+    positionX.resize(total); positionY.resize(total); positionZ.resize(total);
+    heading.resize(total);
+    previousPositionX.resize(total); previousPositionY.resize(total); previousPositionZ.resize(total);
+    previousHeading.resize(total);
+    offsetX.resize(total); offsetY.resize(total); offsetZ.resize(total);
+    driftX.resize(total); driftY.resize(total); driftZ.resize(total);
+    steerTime.resize(total);
+    scheduler.resize(total);
+
+    // Full rebuild of the lanes, leader first
+    laneCars.resize(total);
+    for (uint32_t car = 0; car < total; ++car) {
+        laneCars[car] = car;
+    }
+    std::sort(laneCars.begin(), laneCars.end(), [this](uint32_t a, uint32_t b) {
+        if (edge[a] != edge[b]) return edge[a] < edge[b];
+        if (distance[a] != distance[b]) return distance[a] > distance[b];
+        return a < b;
+    });
+    moved.clear();
+    sortLanes();
+
+    jobSystem.parallelFor(total, CAR_GRAIN, [this](size_t begin, size_t end) { evaluate(begin, end); });
+
+    // Nothing to blend from yet
+    previousPositionX = positionX;
+    previousPositionY = positionY;
+    previousPositionZ = positionZ;
+    previousHeading = heading;
+    return added;
+}
+
+uint32_t Traffic::pickDestination(size_t car, uint32_t from) {
+    uint32_t nodeCount = static_cast<uint32_t>(airways.getNodeCount());
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        uint32_t node = xorshift(random[car]) % nodeCount;
+        if (node != from && airways.nextEdge(from, node) != AirwayGraph::NO_EDGE) {
+            return node;
+        }
+    }
+    for (uint32_t node = 0; node < nodeCount; ++node) {
+        if (node != from && airways.nextEdge(from, node) != AirwayGraph::NO_EDGE) {
+            return node;
+        }
+    }
+    return from;
+}
+
+void Traffic::step(float dt, const glm::vec3& focus) {
+    timings = TrafficTimings();
+    if (edge.empty()) {
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    sortLanes();
+    timings.sort += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(airways.getEdgeCount(), LANE_GRAIN, [this, dt](size_t begin, size_t end) { follow(begin, end, dt); });
+    timings.follow += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    transfer();
+    timings.transfer += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    buildHash();
+    timings.hash += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    schedule(dt, focus);
+    timings.schedule += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(edge.size(), CAR_GRAIN, [this](size_t begin, size_t end) { avoid(begin, end); });
+    timings.avoid += MillisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    jobSystem.parallelFor(edge.size(), CAR_GRAIN, [this](size_t begin, size_t end) { evaluate(begin, end); });
+    timings.evaluate += MillisecondsSince(start);
+}
+
+void Traffic::sortLanes() {
+    // Cars never overtake, and a car changing lanes joins behind everyone
+    // already in its new lane. A stable counting sort of the previous lane
+    // order, with the cars that moved last, therefore keeps every lane
+    // sorted leader first without comparing distances.
+    size_t edgeCount = airways.getEdgeCount();
+    laneStart.assign(edgeCount + 1, 0);
+    for (uint32_t car : laneCars) {
+        laneStart[edge[car] + 1]++;
+    }
+    for (size_t e = 0; e < edgeCount; ++e) {
+        laneStart[e + 1] += laneStart[e];
+    }
+
+    movedFlag.assign(laneCars.size(), 0);
+    for (uint32_t car : moved) {
+        movedFlag[car] = 1;
+    }
+
+    sortCursor.assign(laneStart.begin(), laneStart.end() - 1);
+    sortScratch.resize(laneCars.size());
+    for (uint32_t car : laneCars) {
+        if (!movedFlag[car]) {
+            sortScratch[sortCursor[edge[car]]++] = car;
+        }
+    }
+    for (uint32_t car : moved) {
+        sortScratch[sortCursor[edge[car]]++] = car;
+    }
+    laneCars.swap(sortScratch);
+    moved.clear();
+
+    laneCount.resize(edgeCount);
+    laneTail.resize(edgeCount);
+    for (size_t e = 0; e < edgeCount; ++e) {
+        laneCount[e] = laneStart[e + 1] - laneStart[e];
+        laneTail[e] = laneCount[e] > 0 ? distance[laneCars[laneStart[e + 1] - 1]] : FLT_MAX;
+    }
+}
+
+void Traffic::follow(size_t beginLane, size_t endLane, float dt) {
+    const float spacing = airways.getCarSpacing();
+
+    for (size_t e = beginLane; e < endLane; ++e) {
+        uint32_t first = laneStart[e];
+        uint32_t last = laneStart[e + 1];
+        if (first == last) {
+            continue;
+        }
+        const AirwayGraph::Edge& lane = airways.getEdge(static_cast<uint32_t>(e));
+
+        // The leader may run into the next lane of its route only if that
+        // lane has room, judged on the occupancy at the start of the step
+        uint32_t leader = laneCars[first];
+        float limit = lane.length;
+        uint32_t next = airways.nextEdge(lane.to, destination[leader]);
+        if (next != AirwayGraph::NO_EDGE && laneCount[next] < airways.getEdge(next).capacity) {
+            limit += std::min(laneTail[next], airways.getEdge(next).length) - spacing;
+        }
+
+        for (uint32_t i = first; i < last; ++i) {
+            uint32_t car = laneCars[i];
+            float gap = std::max(limit - distance[car], 0.0f);
+            float v = std::min(std::min(speed[car] + settings.acceleration * dt, settings.cruiseSpeed), gap / dt);
+            speed[car] = v;
+            distance[car] += v * dt;
+            // The leader may yet be held at the end of the lane by transfer()
+            limit = std::min(distance[car], lane.length) - spacing;
+        }
+    }
+}
+
+void Traffic::transfer() {
+    // Only a leader can pass the end of its lane, since everyone behind it
+    // stays a spacing back. Lanes are visited in order so the outcome does
+    // not depend on how follow() was split up.
+    const float spacing = airways.getCarSpacing();
+    size_t edgeCount = airways.getEdgeCount();
+
+    for (size_t e = 0; e < edgeCount; ++e) {
+        if (laneStart[e] == laneStart[e + 1]) {
+            continue;
+        }
+        uint32_t car = laneCars[laneStart[e]];
+        const AirwayGraph::Edge& lane = airways.getEdge(static_cast<uint32_t>(e));
+        if (distance[car] < lane.length) {
+            continue;
+        }
+
+        uint32_t next = airways.nextEdge(lane.to, destination[car]);
+        float entry = next != AirwayGraph::NO_EDGE ? std::min(distance[car] - lane.length, laneTail[next] - spacing) : -1.0f;
+        if (next == AirwayGraph::NO_EDGE || laneCount[next] >= airways.getEdge(next).capacity || entry < 0.0f) {
+            // Held at the end of the lane, and sent somewhere else so that a
+            // ring of full lanes can not lock up for good
+            distance[car] = lane.length;
+            speed[car] = 0.0f;
+            destination[car] = pickDestination(car, lane.to);
+            continue;
+        }
+
+        if (--laneCount[e] == 0) {
+            laneTail[e] = FLT_MAX;
+        }
+        laneCount[next]++;
+        laneTail[next] = entry;
+
+        edge[car] = next;
+        distance[car] = entry;
+        if (airways.getEdge(next).to == destination[car]) {
+            destination[car] = pickDestination(car, destination[car]);
+        }
+        moved.push_back(car);
+    }
+}
+
+void Traffic::evaluate(size_t begin, size_t end) {
+    for (size_t car = begin; car < end; ++car) {
+        previousPositionX[car] = positionX[car];
+        previousPositionY[car] = positionY[car];
+        previousPositionZ[car] = positionZ[car];
+        previousHeading[car] = heading[car];
+
+        glm::vec3 position;
+        airways.sample(edge[car], distance[car], position, heading[car]);
+        positionX[car] = position.x + offsetX[car];
+        positionY[car] = position.y + offsetY[car];
+        positionZ[car] = position.z + offsetZ[car];
+    }
+}
+
+void Traffic::buildHash() {
+    size_t count = size();
+    // Twice the radius, so the 2x2x2 block avoid() scans reaches a full
+    // radius past the car on every side
+    hash.build(positionX.data(), positionY.data(), positionZ.data(), count, 2.0f * std::max(settings.avoidanceRadius, 0.5f), CAR_GRAIN);
+
+    const std::vector<uint32_t>& order = hash.getOrder();
+    sorted.resize(count);
+    jobSystem.parallelFor(count, CAR_GRAIN, [&](size_t begin, size_t end) {
+        for (size_t slot = begin; slot < end; ++slot) {
+            uint32_t car = order[slot];
+            sorted[slot] = {positionX[car], positionY[car], positionZ[car], car};
+        }
+    });
+}
+
+void Traffic::schedule(float dt, const glm::vec3& focus) {
+    // Serial and in car order, so the budget goes to the same cars however
+    // the steps are split over threads
+    scheduler.beginFrame(dt);
+    for (size_t car = 0; car < edge.size(); ++car) {
+        glm::vec3 position(positionX[car], positionY[car], positionZ[car]);
+        double time;
+        UpdateScheduler::Tier tier = scheduler.schedule(car, glm::distance(position, focus), time);
+        steerTime[car] = tier == UpdateScheduler::TIER_FAR ? 0.0f : static_cast<float>(time);
+    }
+}
+
+void Traffic::avoid(size_t begin, size_t end) {
+    const float cellSize = hash.getCellSize();
+    const float radius = 0.5f * cellSize;
+    const float radiusSquared = radius * radius;
+
+    // Walk cars in hash order so consecutive cars scan the same buckets
+    for (size_t slot = begin; slot < end; ++slot) {
+        uint32_t car = sorted[slot].car;
+        float dt = steerTime[car];
+        if (dt <= 0.0f) continue;
+
+        glm::vec3 position(positionX[car], positionY[car], positionZ[car]);
+        glm::vec3 offset(offsetX[car], offsetY[car], offsetZ[car]);
+        glm::vec3 drift(driftX[car], driftY[car], driftZ[car]);
+        glm::vec3 acceleration = -settings.laneSpring * offset - settings.laneDamping * drift;
+
+        // Repulsion from whoever is too close, whatever lane they are in.
+        // Same-lane cars are a full spacing apart and so never push. Cells
+        // are twice as wide as the radius, so only the 2x2x2 block on the
+        // side of the cell the car is in can hold a neighbour.
+        float gridX = position.x / cellSize, gridY = position.y / cellSize, gridZ = position.z / cellSize;
+        int cellX = static_cast<int>(std::floor(gridX));
+        int cellY = static_cast<int>(std::floor(gridY));
+        int cellZ = static_cast<int>(std::floor(gridZ));
+        int firstX = gridX - cellX < 0.5f ? cellX - 1 : cellX;
+        int firstY = gridY - cellY < 0.5f ? cellY - 1 : cellY;
+        int firstZ = gridZ - cellZ < 0.5f ? cellZ - 1 : cellZ;
+        int found = 0;
+        for (int y = firstY; y <= firstY + 1 && found < settings.maxNeighbours; ++y) {
+            for (int z = firstZ; z <= firstZ + 1 && found < settings.maxNeighbours; ++z) {
+                for (int x = firstX; x <= firstX + 1 && found < settings.maxNeighbours; ++x) {
+                    uint32_t h = hash.bucket(x, y, z);
+                    for (uint32_t k = hash.bucketStart(h); k < hash.bucketEnd(h) && found < settings.maxNeighbours; ++k) {
+                        const Neighbour& other = sorted[k];
+                        if (other.car == car) continue;
+
+                        glm::vec3 away(position.x - other.positionX, position.y - other.positionY, position.z - other.positionZ);
+                        float distanceSquared = glm::dot(away, away);
+                        if (distanceSquared >= radiusSquared) continue;
+                        found++;
+
+                        float length = std::sqrt(distanceSquared);
+                        if (length < 1e-4f) {
+                            // Same spot, split them sideways by index so both agree
+                            away = glm::vec3(car < other.car ? -1.0f : 1.0f, 0.0f, 0.0f);
+                            length = 1.0f;
+                        }
+                        acceleration += away * (settings.repulsion * (1.0f - length / radius) / length);
+                    }
+                }
+            }
+        }
+
+        const AirwayGraph::Edge& lane = airways.getEdge(edge[car]);
+        const FlowField* field = &airways.getFlowField(lane.to);
+        if (!field->contains(position)) {
+            field = &airways.getFlowField(lane.from);
+        }
+        if (field->blocked(position)) {
+            acceleration += field->direction(position) * settings.flowWeight;
+        } else {
+            glm::vec3 tangent = airways.tangent(edge[car], distance[car]);
+            if (field->blocked(position + tangent * (speed[car] * settings.lookAhead + radius))) {
+                glm::vec3 flow = field->direction(position);
+                acceleration += (flow - tangent * glm::dot(flow, tangent)) * settings.flowWeight;
+            }
+        }
+
+        drift += acceleration * dt;
+        offset += drift * dt;
+        float offsetLength = glm::length(offset);
+        if (offsetLength > settings.maxOffset) {
+            offset *= settings.maxOffset / offsetLength;
+            drift -= offset * (glm::dot(drift, offset) / glm::dot(offset, offset));
+        }
+
+        offsetX[car] = offset.x; offsetY[car] = offset.y; offsetZ[car] = offset.z;
+        driftX[car] = drift.x; driftY[car] = drift.y; driftZ[car] = drift.z;
+    }
+}
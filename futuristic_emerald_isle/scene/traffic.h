@@ -0,0 +1,126 @@
+#ifndef TRAFFIC_H
+#define TRAFFIC_H
+
+#include <cstdint>
+#include <vector>
+#include "airways.h"
+#include "spatial_hash.h"
+#include "utils/update_scheduler.h"
+
+struct TrafficSettings {
+    float cruiseSpeed = 30.0f;
+    float acceleration = 20.0f;
+
+    // Local avoidance: cars drift off their lane, within maxOffset, away
+    // from cars of other lanes and out of buildings and ground
+    float avoidanceRadius = 3.0f;
+    int maxNeighbours = 8;          // Nearest are not guaranteed, the first found are used
+    float repulsion = 60.0f;
+    float flowWeight = 40.0f;
+    float lookAhead = 0.5f;         // Seconds ahead checked for obstacles
+    float laneSpring = 6.0f;        // Pull back onto the lane
+    float laneDamping = 5.0f;
+    float maxOffset = 6.0f;
+};
+
+// Wall-clock milliseconds spent in each phase of the last step()
+struct TrafficTimings {
+    double sort = 0.0;
+    double follow = 0.0;
+    double transfer = 0.0;
+    double hash = 0.0;
+    double schedule = 0.0;
+    double avoid = 0.0;
+    double evaluate = 0.0;
+};
+
+// Flying cars on an AirwayGraph. Every airway is a single lane: cars keep
+// at least the graph's car spacing to the one ahead, and only enter the
+// next airway of their route when it has room, waiting at the end of the
+// current one otherwise. Cars are grouped by lane each step so following
+// runs one lane per task; only the hand-over between lanes is serial, and
+// it visits lanes in a fixed order, so results do not depend on thread count.
+//
+// On top of the lanes, each car carries an offset steered by repulsion from
+// neighbours found in a spatial hash and by the flow field of the city it
+// is flying to or from. A car looks at no more than maxNeighbours cars and
+// two flow field cells, so steering costs the same however dense the
+// traffic gets. Steering is spent by distance to the focus through
+// scheduler: near cars steer every step, mid-range ones every few steps
+// with the time they skipped, and far ones only follow their lane and keep
+// their offset.
+class Traffic {
+public:
+    Traffic();
+    ~Traffic();
+
+    void cleanup();
+
+    // Replaces the graph and removes every car
+    void setAirways(AirwayGraph&& graph);
+    const AirwayGraph& getAirways() const { return airways; }
+
+    // Spreads count cars over the lanes, as many as fit. Returns how many were added.
+    size_t addCars(size_t count, uint32_t seed);
+    void clear();
+    size_t size() const { return edge.size(); }
+
+    // Keeps the current output as previous, then advances by dt with focus
+    // as the camera for scheduling. Callers step at a fixed rate to keep the
+    // results reproducible.
+    void step(float dt, const glm::vec3& focus);
+
+    TrafficSettings settings;
+    TrafficTimings timings;
+    UpdateScheduler scheduler;
+
+    // Output of the last two steps: world position and heading about Y in degrees
+    std::vector<float> positionX, positionY, positionZ;
+    std::vector<float> heading;
+    std::vector<float> previousPositionX, previousPositionY, previousPositionZ;
+    std::vector<float> previousHeading;
+
+private:
+    void sortLanes();
+    void follow(size_t beginLane, size_t endLane, float dt);
+    void transfer();
+    void buildHash();
+    void schedule(float dt, const glm::vec3& focus);
+    void avoid(size_t begin, size_t end);
+    void evaluate(size_t begin, size_t end);
+    uint32_t pickDestination(size_t car, uint32_t from);
+
+    AirwayGraph airways;
+
+    // Per car
+    std::vector<uint32_t> edge;
+    std::vector<float> distance;
+    std::vector<float> speed;
+    std::vector<uint32_t> destination;
+    std::vector<uint32_t> random;
+    std::vector<float> offsetX, offsetY, offsetZ;
+    std::vector<float> driftX, driftY, driftZ;
+    std::vector<float> steerTime;       // Time avoid() steers the car over this step, 0 to skip it
+
+    // Cars grouped by lane, leader first: laneCars[laneStart[e], laneStart[e + 1])
+    std::vector<uint32_t> laneStart;
+    std::vector<uint32_t> laneCars;
+    std::vector<uint32_t> moved;        // Cars that changed lane last step, in the order they entered
+    std::vector<uint8_t> movedFlag;
+    std::vector<uint32_t> sortCursor, sortScratch;
+
+    // Lane occupancy as of the start of the step, updated by transfer()
+    std::vector<uint32_t> laneCount;
+    std::vector<float> laneTail;        // Distance of the last car, or FLT_MAX when empty
+
+    // Spatial hash over last step's positions, and the positions copied
+    // out in its order
+    struct Neighbour {
+        float positionX, positionY, positionZ;
+        uint32_t car;
+    };
+    SpatialHash hash;
+    std::vector<Neighbour> sorted;
+};
+
+#endif // TRAFFIC_H
@@ -0,0 +1,103 @@
+#include "transform_batch.h"
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define TRANSFORM_BATCH_SSE 1
+#endif
+
+namespace {
+
+void composeOne(const TransformArrays& in, uint32_t i, float* out) {
+    float x = in.orientationX[i], y = in.orientationY[i], z = in.orientationZ[i], w = in.orientationW[i];
+    float s = in.scale[i];
+
+    out[0] = (1.0f - 2.0f * (y * y + z * z)) * s;
+    out[1] = 2.0f * (x * y - w * z) * s;
+    out[2] = 2.0f * (x * z + w * y) * s;
+    out[3] = in.positionX[i];
+
+    out[4] = 2.0f * (x * y + w * z) * s;
+    out[5] = (1.0f - 2.0f * (x * x + z * z)) * s;
+    out[6] = 2.0f * (y * z - w * x) * s;
+    out[7] = in.positionY[i];
+
+    out[8] = 2.0f * (x * z - w * y) * s;
+    out[9] = 2.0f * (y * z + w * x) * s;
+    out[10] = (1.0f - 2.0f * (x * x + y * y)) * s;
+    out[11] = in.positionZ[i];
+}
+
+#ifdef TRANSFORM_BATCH_SSE
+inline __m128 gather(const float* values, const uint32_t* indices) {
+    return _mm_setr_ps(values[indices[0]], values[indices[1]], values[indices[2]], values[indices[3]]);
+}
+
+// Same arithmetic as composeOne for four transforms, one per lane, then
+// transposed so each transform's rows are stored contiguously
+void composeFour(const TransformArrays& in, const uint32_t* indices, float* out0, float* out1, float* out2, float* out3) {
+    __m128 x = gather(in.orientationX, indices);
+    __m128 y = gather(in.orientationY, indices);
+    __m128 z = gather(in.orientationZ, indices);
+    __m128 w = gather(in.orientationW, indices);
+    __m128 s = gather(in.scale, indices);
+    __m128 two = _mm_set1_ps(2.0f);
+    __m128 one = _mm_set1_ps(1.0f);
+
+    __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+    __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+    __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+    __m128 s2 = _mm_mul_ps(two, s);
+
+    __m128 r00 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), s);
+    __m128 r01 = _mm_mul_ps(_mm_sub_ps(xy, wz), s2);
+    __m128 r02 = _mm_mul_ps(_mm_add_ps(xz, wy), s2);
+    __m128 t0 = gather(in.positionX, indices);
+
+    __m128 r10 = _mm_mul_ps(_mm_add_ps(xy, wz), s2);
+    __m128 r11 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), s);
+    __m128 r12 = _mm_mul_ps(_mm_sub_ps(yz, wx), s2);
+    __m128 t1 = gather(in.positionY, indices);
+
+    __m128 r20 = _mm_mul_ps(_mm_sub_ps(xz, wy), s2);
+    __m128 r21 = _mm_mul_ps(_mm_add_ps(yz, wx), s2);
+    __m128 r22 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), s);
+    __m128 t2 = gather(in.positionZ, indices);
+
+    _MM_TRANSPOSE4_PS(r00, r01, r02, t0);
+    _MM_TRANSPOSE4_PS(r10, r11, r12, t1);
+    _MM_TRANSPOSE4_PS(r20, r21, r22, t2);
+
+    _mm_storeu_ps(out0, r00); _mm_storeu_ps(out0 + 4, r10); _mm_storeu_ps(out0 + 8, r20);
+    _mm_storeu_ps(out1, r01); _mm_storeu_ps(out1 + 4, r11); _mm_storeu_ps(out1 + 8, r21);
+    _mm_storeu_ps(out2, r02); _mm_storeu_ps(out2 + 4, r12); _mm_storeu_ps(out2 + 8, r22);
+    _mm_storeu_ps(out3, t0); _mm_storeu_ps(out3 + 4, t1); _mm_storeu_ps(out3 + 8, t2);
+}
+#endif
+
+}
+
+void ComposeAffinePacked(const TransformArrays& in, const uint32_t* indices, size_t count, float* out) {
+    size_t k = 0;
+#ifdef TRANSFORM_BATCH_SSE
+    for (; k + 4 <= count; k += 4) {
+        float* base = out + k * AFFINE_FLOATS;
+        composeFour(in, indices + k, base, base + AFFINE_FLOATS, base + 2 * AFFINE_FLOATS, base + 3 * AFFINE_FLOATS);
+    }
+#endif
+    for (; k < count; ++k) {
+        composeOne(in, indices[k], out + k * AFFINE_FLOATS);
+    }
+}
+
+void ComposeAffineScattered(const TransformArrays& in, const uint32_t* indices, size_t count, float* out) {
+    size_t k = 0;
+#ifdef TRANSFORM_BATCH_SSE
+    for (; k + 4 <= count; k += 4) {
+        const uint32_t* four = indices + k;
+        composeFour(in, four, out + four[0] * AFFINE_FLOATS, out + four[1] * AFFINE_FLOATS,
+                    out + four[2] * AFFINE_FLOATS, out + four[3] * AFFINE_FLOATS);
+    }
+#endif
+    for (; k < count; ++k) {
+        composeOne(in, indices[k], out + indices[k] * AFFINE_FLOATS);
+    }
+}
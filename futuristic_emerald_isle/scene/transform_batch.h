@@ -0,0 +1,30 @@
+#ifndef TRANSFORM_BATCH_H
+#define TRANSFORM_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Structure-of-arrays view of the transforms a batch is composed from.
+// Rotation is a unit quaternion, scale is uniform.
+struct TransformArrays {
+    const float* positionX;
+    const float* positionY;
+    const float* positionZ;
+    const float* orientationX;
+    const float* orientationY;
+    const float* orientationZ;
+    const float* orientationW;
+    const float* scale;
+};
+
+// Floats per composed transform: a row-major 3x4 affine matrix, the rows
+// being the first three rows of translate * rotate * scale
+const size_t AFFINE_FLOATS = 12;
+
+// Composes the transforms listed in indices. Packed writes the k-th result
+// to out + k * AFFINE_FLOATS; Scattered writes it to out + indices[k] *
+// AFFINE_FLOATS. Four transforms at a time with SSE where available.
+void ComposeAffinePacked(const TransformArrays& in, const uint32_t* indices, size_t count, float* out);
+void ComposeAffineScattered(const TransformArrays& in, const uint32_t* indices, size_t count, float* out);
+
+#endif // TRANSFORM_BATCH_H
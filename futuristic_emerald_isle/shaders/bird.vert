@@ -4,22 +4,64 @@ layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec2 vertexUV;
 layout(location = 2) in vec3 vertexNormal;
 
+// Per instance, see render/bird.h
+layout(location = 3) in vec4 positionScale;     // xyz position, w scale
+layout(location = 4) in vec4 velocityPhase;     // xyz velocity, w seconds into the flap cycle
+
 out vec3 worldPosition;
 out vec3 worldNormal;
 out vec2 uv;
 
-uniform mat4 MVP;
-uniform mat4 modelMatrix;
+// Camera and lighting for the frame, see render/frame_uniforms.h
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    vec3 lightPosition;
+    vec3 lightIntensity;
+};
+
+// Baked animation, one row per track: translation, rotation (degrees), scale
+uniform sampler2D keyframeSampler;
+uniform float animationDuration;
+uniform float animationFramesPerSecond;
+uniform int animationFrameCount;
+uniform int animationTracks;
+
+vec3 sampleTrack(int row, float frame) {
+    int i = min(int(frame), animationFrameCount - 1);
+    vec3 a = texelFetch(keyframeSampler, ivec2(i, row), 0).xyz;
+    vec3 b = texelFetch(keyframeSampler, ivec2(i + 1, row), 0).xyz;
+    return mix(a, b, frame - float(i));
+}
+
+mat3 rotateX(float a) { float c = cos(a), s = sin(a); return mat3(1.0, 0.0, 0.0, 0.0, c, s, 0.0, -s, c); }
+mat3 rotateY(float a) { float c = cos(a), s = sin(a); return mat3(c, 0.0, -s, 0.0, 1.0, 0.0, s, 0.0, c); }
+mat3 rotateZ(float a) { float c = cos(a), s = sin(a); return mat3(c, s, 0.0, -s, c, 0.0, 0.0, 0.0, 1.0); }
 
 void main() {
-    gl_Position = MVP * vec4(vertexPosition, 1.0);
+    // The flock places the bird, the clip only moves it about that point
+    vec3 position = positionScale.xyz;
+    vec3 offset = vec3(0.0);
+    vec3 rotation = vec3(0.0);
+    vec3 scale = vec3(1.0);
+
+    if (animationFrameCount > 0) {
+        float frame = mod(velocityPhase.w, animationDuration) * animationFramesPerSecond;
+        if ((animationTracks & 1) != 0) offset = sampleTrack(0, frame);
+        if ((animationTracks & 2) != 0) rotation = sampleTrack(1, frame);
+        if ((animationTracks & 4) != 0) scale = sampleTrack(2, frame);
+    }
 
-    // Transform the vertex position to world space
-    worldPosition = vec3(modelMatrix * vec4(vertexPosition, 1.0));
+    // Head along the direction of flight
+    vec3 direction = velocityPhase.xyz;
+    rotation.z = degrees(atan(direction.x, direction.z)) + 180.0;
 
-    // Transform the normal to world space
-    //worldNormal = normalize(mat3(transpose(inverse(modelMatrix))) * vertexNormal);
-    worldNormal = normalize(vertexNormal);
+    mat3 model = rotateX(radians(rotation.x)) * rotateY(radians(rotation.y)) * rotateZ(radians(rotation.z));
+    worldPosition = position + model * (positionScale.w * (offset + scale * vertexPosition));
+    gl_Position = viewProjection * vec4(worldPosition, 1.0);
 
+    worldNormal = normalize(model * vertexNormal);
     uv = vertexUV;
-}
\ No newline at end of file
+}
@@ -5,23 +5,37 @@ layout(location = 1) in vec3 vertexColor;
 layout(location = 2) in vec2 vertexUV;
 layout(location = 3) in vec3 vertexNormal;
 
+// Per building, see render/building_batch.h
+layout(location = 4) in vec4 modelRow0;
+layout(location = 5) in vec4 modelRow1;
+layout(location = 6) in vec4 modelRow2;
+layout(location = 7) in float facadeRepeat;
+
 out vec3 fragColor;
 out vec3 worldPosition;
 out vec3 worldNormal;
 out vec2 uv;
 
-uniform mat4 MVP;
-uniform mat4 modelMatrix;
+// Camera and lighting for the frame, see render/frame_uniforms.h
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    vec3 lightPosition;
+    vec3 lightIntensity;
+};
 
 void main() {
-    gl_Position = MVP * vec4(vertexPosition, 1.0);
-
     // Transform the vertex position to world space
-    worldPosition = vec3(modelMatrix * vec4(vertexPosition, 1.0));
+    vec4 position = vec4(vertexPosition, 1.0);
+    worldPosition = vec3(dot(modelRow0, position), dot(modelRow1, position), dot(modelRow2, position));
+    gl_Position = viewProjection * vec4(worldPosition, 1.0);
 
-    // Transform the normal to world space
-    worldNormal = normalize(mat3(transpose(inverse(modelMatrix))) * vertexNormal);
+    // Transform the normal to world space, the scale is not uniform
+    mat3 model = transpose(mat3(modelRow0.xyz, modelRow1.xyz, modelRow2.xyz));
+    worldNormal = normalize(transpose(inverse(model)) * vertexNormal);
 
     //fragColor = vertexColor;
-    uv = vertexUV;
+    uv = vec2(vertexUV.x, vertexUV.y * facadeRepeat);
 }
@@ -6,8 +6,15 @@ in vec2 uv;
 
 out vec3 finalColor;
 
-uniform vec3 lightPosition;
-uniform vec3 lightIntensity;
+// Camera and lighting for the frame, see render/frame_uniforms.h
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    vec3 lightPosition;
+    vec3 lightIntensity;
+};
 uniform sampler2D textureSampler;
 uniform sampler2D normalMapSampler;
 
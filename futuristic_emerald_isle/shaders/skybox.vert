@@ -10,12 +10,22 @@ out vec3 color;
 // TODO: To add UV to this vertex shader
 out vec2 uv;
 
-// Matrix for vertex transformation
-uniform mat4 MVP;
+// Camera and lighting for the frame, see render/frame_uniforms.h
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    vec3 lightPosition;
+    vec3 lightIntensity;
+};
+
+// Model matrix, set once
+uniform mat4 modelMatrix;
 
 void main() {
     // Transform vertex
-    gl_Position =  MVP * vec4(vertexPosition, 1);
+    gl_Position = viewProjection * modelMatrix * vec4(vertexPosition, 1);
 
     // Pass vertex color to the fragment shader
     color = vertexColor;
@@ -21,14 +21,22 @@ out vec3 worldPosition;
 out vec3 worldNormal;
 out vec2 uv;
 
-uniform mat4 MVP;
+// Camera and lighting for the frame, see render/frame_uniforms.h
+layout(std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec3 cameraPosition;
+    vec3 lightPosition;
+    vec3 lightIntensity;
+};
+
 uniform mat4 modelMatrix;
 
 void main() {
-    gl_Position = MVP * vec4(vertexPosition, 1.0);
-
     // Transform the vertex position to world space
     worldPosition = vec3(modelMatrix * vec4(vertexPosition, 1.0));
+    gl_Position = viewProjection * vec4(worldPosition, 1.0);
 
     // Transform the normal to world space
     worldNormal = normalize(mat3(transpose(inverse(modelMatrix))) * vertexNormal);
@@ -0,0 +1,68 @@
+// Offline converter from glTF to the flat .feim layout loaded by Mesh.
+//
+//   asset_cook <input.gltf> [<input.gltf> ...]
+//
+// Each input is written next to itself with a .feim extension, which is
+// where Mesh::load looks before falling back to parsing the glTF.
+
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include <iostream>
+#include <tiny_gltf.h>
+#include <utils/cooked_mesh_format.h>
+#include <utils/mesh_cooker.h>
+
+static bool cookFile(const std::string& inputPath) {
+    tinygltf::Model model;
+    tinygltf::TinyGLTF loader;
+    std::string err, warn;
+
+    bool res = loader.LoadASCIIFromFile(&model, &err, &warn, inputPath);
+    if (!warn.empty()) {
+        std::cout << "WARN: " << warn << std::endl;
+    }
+
+    if (!res) {
+        std::cerr << "Failed to load glTF: " << inputPath << " " << err << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> cooked;
+    if (!CookGLTFModel(model, cooked, err)) {
+        std::cerr << "Failed to cook " << inputPath << ": " << err << std::endl;
+        return false;
+    }
+
+    std::string outputPath = CookedMeshPath(inputPath);
+    if (!WriteCookedFile(outputPath, cooked)) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return false;
+    }
+
+    const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(cooked.data());
+    std::cout << "Cooked " << inputPath << " -> " << outputPath << " ("
+              << header->vertexCount << " vertices, "
+              << header->indexCount / 3 << " triangles, "
+              << header->primitiveCount << " draws, "
+              << header->textureCount << " textures, "
+              << cooked.size() / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: asset_cook <input.gltf> [<input.gltf> ...]" << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    for (int i = 1; i < argc; ++i) {
+        if (!cookFile(argv[i])) {
+            failures++;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
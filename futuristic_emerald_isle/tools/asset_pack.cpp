@@ -0,0 +1,128 @@
+// Packs loose assets into a single .fepak archive mounted by the VFS.
+//
+//   asset_pack <output.fepak> <root> <file> [<file> ...]
+//
+// Entry names are the file paths relative to <root> (normally the
+// futuristic_emerald_isle/ directory). Entries are deflated when that saves
+// at least an eighth of their size; images and other pre-compressed data
+// are stored as they are.
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <climits>
+#include <string>
+#include <vector>
+#include <tinygltf-2.9.3/stb_image_write.h>
+#include <utils/asset_pack_format.h>
+#include <utils/mapped_file.h>
+
+struct PackedFile {
+    std::string name;
+    std::string path;
+};
+
+static void padTo(std::vector<uint8_t>& out, size_t alignment) {
+    out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+static bool appendEntry(const PackedFile& input, std::vector<uint8_t>& out, AssetPackEntry& entry) {
+    MappedFile file;
+    if (!file.open(input.path)) {
+        std::cerr << "Failed to read " << input.path << std::endl;
+        return false;
+    }
+
+    padTo(out, ASSET_PACK_ALIGNMENT);
+    entry.offset = out.size();
+    entry.rawSize = file.size();
+    entry.flags = 0;
+
+    if (file.size() > 0 && file.size() <= INT_MAX) {
+        int compressedSize = 0;
+        unsigned char* compressed = stbi_zlib_compress(const_cast<unsigned char*>(file.data()), static_cast<int>(file.size()), &compressedSize, 8);
+        if (compressed && static_cast<size_t>(compressedSize) <= file.size() - file.size() / 8) {
+            out.insert(out.end(), compressed, compressed + compressedSize);
+            entry.size = compressedSize;
+            entry.flags = ASSET_PACK_COMPRESSED;
+        }
+        free(compressed);
+    }
+
+    if (!(entry.flags & ASSET_PACK_COMPRESSED)) {
+        out.insert(out.end(), file.data(), file.data() + file.size());
+        entry.size = file.size();
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::cerr << "Usage: asset_pack <output.fepak> <root> <file> [<file> ...]" << std::endl;
+        return 1;
+    }
+
+    std::string outputPath = argv[1];
+    std::string root = AssetPackName(argv[2]);
+
+    std::vector<PackedFile> inputs;
+    for (int i = 3; i < argc; ++i) {
+        std::string name = AssetPackName(argv[i]);
+        if (!root.empty() && name.compare(0, root.size() + 1, root + "/") == 0) {
+            name = name.substr(root.size() + 1);
+        }
+        inputs.push_back({name, argv[i]});
+    }
+
+    // Sorted and deduplicated so the same inputs always give the same pack
+    std::sort(inputs.begin(), inputs.end(), [](const PackedFile& a, const PackedFile& b) { return a.name < b.name; });
+    inputs.erase(std::unique(inputs.begin(), inputs.end(), [](const PackedFile& a, const PackedFile& b) { return a.name == b.name; }), inputs.end());
+
+    std::vector<uint8_t> out(sizeof(AssetPackHeader), 0);
+    std::vector<AssetPackEntry> entries;
+    std::string names;
+    uint64_t rawTotal = 0;
+
+    for (const PackedFile& input : inputs) {
+        AssetPackEntry entry = {};
+        if (!appendEntry(input, out, entry)) {
+            return 1;
+        }
+        entry.nameOffset = static_cast<uint32_t>(names.size());
+        entry.nameLength = static_cast<uint32_t>(input.name.size());
+        names += input.name;
+        rawTotal += entry.rawSize;
+        entries.push_back(entry);
+    }
+
+    AssetPackHeader header = {};
+    header.magic = ASSET_PACK_MAGIC;
+    header.version = ASSET_PACK_VERSION;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+
+    padTo(out, ASSET_PACK_ALIGNMENT);
+    header.tocOffset = out.size();
+    const uint8_t* toc = reinterpret_cast<const uint8_t*>(entries.data());
+    out.insert(out.end(), toc, toc + entries.size() * sizeof(AssetPackEntry));
+
+    header.namesOffset = out.size();
+    header.namesSize = names.size();
+    out.insert(out.end(), names.begin(), names.end());
+
+    header.fileSize = out.size();
+    memcpy(out.data(), &header, sizeof(header));
+
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    if (!file.good()) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return 1;
+    }
+
+    std::cout << "Packed " << entries.size() << " files into " << outputPath << " ("
+              << rawTotal / 1024 << " KiB -> " << out.size() / 1024 << " KiB)" << std::endl;
+    return 0;
+}
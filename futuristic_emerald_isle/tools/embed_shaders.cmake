@@ -0,0 +1,22 @@
+# Writes every .vert/.frag under SHADER_DIR into a header of constexpr raw
+# string literals, keyed by their path relative to SHADER_DIR.
+#
+#   cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> -P embed_shaders.cmake
+
+file(GLOB_RECURSE SHADERS RELATIVE "${SHADER_DIR}" "${SHADER_DIR}/*.vert" "${SHADER_DIR}/*.frag")
+list(SORT SHADERS)
+
+set(CONTENT "// Generated from ${SHADER_DIR} by embed_shaders.cmake, do not edit.\n")
+set(CONTENT "${CONTENT}#ifndef EMBEDDED_SHADERS_H\n#define EMBEDDED_SHADERS_H\n\n#include <cstddef>\n\n")
+set(CONTENT "${CONTENT}struct EmbeddedShader {\n    const char* path;\n    const char* source;\n};\n\n")
+set(CONTENT "${CONTENT}constexpr EmbeddedShader EMBEDDED_SHADERS[] = {\n")
+foreach(SHADER ${SHADERS})
+	file(READ "${SHADER_DIR}/${SHADER}" SOURCE)
+	set(CONTENT "${CONTENT}    {\"${SHADER}\", R\"FEI_GLSL(${SOURCE})FEI_GLSL\"},\n")
+endforeach()
+set(CONTENT "${CONTENT}};\n\nconstexpr size_t EMBEDDED_SHADER_COUNT = sizeof(EMBEDDED_SHADERS) / sizeof(EMBEDDED_SHADERS[0]);\n\n#endif // EMBEDDED_SHADERS_H\n")
+
+# Only touch the header when a shader actually changed
+file(WRITE "${OUTPUT}.tmp" "${CONTENT}")
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
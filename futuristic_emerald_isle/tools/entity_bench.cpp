@@ -0,0 +1,188 @@
+// Compares the per-frame cost of the old object-per-entity layout with
+// packed arrays and an EntityStore on the old car workload: every car moves
+// back and forth along its path, a distance check decides who is drawn, and
+// the drawn ones get a matrix.
+//
+//   entity_bench [entityCount] [frames]
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include <glm/gtc/matrix_transform.hpp>
+#include <scene/entity_store.h>
+
+// The layout Car had: transform, cached matrix, path state and GL handles
+// all in one object
+struct LegacyEntity {
+    glm::vec3 position;
+    glm::vec3 rotation;
+    glm::vec3 scale;
+    glm::mat4 modelMatrix;
+    glm::vec3 startPosition;
+    glm::vec3 endPosition;
+    glm::vec3 targetPosition;
+    bool movingForward;
+    float animationSpeed;
+    unsigned int programID;
+    const void* mesh;
+
+    void updateModelMatrix() {
+        modelMatrix = glm::mat4(1.0f);
+        modelMatrix = glm::translate(modelMatrix, position);
+        modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+        modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+        modelMatrix = glm::rotate(modelMatrix, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+        modelMatrix = glm::scale(modelMatrix, scale);
+    }
+
+    void update(double deltaTime) {
+        if (glm::length(targetPosition - position) < 0.1f) {
+            movingForward = !movingForward;
+            targetPosition = movingForward ? endPosition : startPosition;
+        }
+        glm::vec3 direction = glm::normalize(targetPosition - position);
+        position += direction * static_cast<float>(animationSpeed * deltaTime);
+        updateModelMatrix();
+        rotation.z = glm::degrees(atan2(direction.x, direction.z)) + 180.0f;
+        updateModelMatrix();
+    }
+};
+
+// The same paths as packed arrays. parameter is the distance travelled, in
+// [0, 2 * length).
+struct PathArrays {
+    std::vector<float> startX, startY, startZ;
+    std::vector<float> endX, endY, endZ;
+    std::vector<float> speed, length, parameter;
+
+    void add(const glm::vec3& start, const glm::vec3& end, float pathSpeed) {
+        startX.push_back(start.x); startY.push_back(start.y); startZ.push_back(start.z);
+        endX.push_back(end.x); endY.push_back(end.y); endZ.push_back(end.z);
+        speed.push_back(pathSpeed);
+        length.push_back(glm::length(end - start));
+        parameter.push_back(0.0f);
+    }
+
+    // Only moves the parameters, for entities nobody is looking at
+    void advance(double deltaTime) {
+        for (size_t i = 0; i < parameter.size(); ++i) {
+            if (length[i] <= 0.0f) continue;
+            parameter[i] = static_cast<float>(fmod(parameter[i] + speed[i] * deltaTime, 2.0 * length[i]));
+        }
+    }
+
+    glm::vec3 position(size_t i) const {
+        glm::vec3 start(startX[i], startY[i], startZ[i]);
+        if (length[i] <= 0.0f) return start;
+
+        glm::vec3 end(endX[i], endY[i], endZ[i]);
+        float along = parameter[i] < length[i] ? parameter[i] : 2.0f * length[i] - parameter[i];
+        return start + (end - start) * (along / length[i]);
+    }
+
+    // Position and heading of path i into the store. The heading goes into
+    // rotationZ, the up axis of the car model as it was stored.
+    void evaluate(size_t i, EntityStore& store) const {
+        glm::vec3 p = position(i);
+        store.positionX[i] = p.x;
+        store.positionY[i] = p.y;
+        store.positionZ[i] = p.z;
+        store.transformDirty[i] = 1;
+        if (length[i] <= 0.0f) return;
+
+        glm::vec3 direction(endX[i] - startX[i], endY[i] - startY[i], endZ[i] - startZ[i]);
+        if (parameter[i] >= length[i]) direction = -direction;
+        float heading = glm::degrees(atan2(direction.x, direction.z)) + 180.0f;
+        if (heading != store.rotationZ[i]) {
+            SetRotation(store, i, glm::vec3(store.rotationX[i], store.rotationY[i], heading));
+        }
+    }
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+    const double deltaTime = 1.0 / 60.0;
+    const float renderRadius = 200.0f;
+    const glm::vec3 cameraPosition(0.0f, 50.0f, 0.0f);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> coordinate(-2000.0f, 2000.0f);
+
+    std::vector<LegacyEntity> legacy(count);
+    EntityStore store;
+    store.reserve(count);
+    PathArrays paths;
+    for (size_t i = 0; i < count; ++i) {
+        glm::vec3 start(coordinate(gen), 50.0f, coordinate(gen));
+        glm::vec3 end(coordinate(gen), 50.0f, coordinate(gen));
+
+        LegacyEntity& entity = legacy[i];
+        entity.position = start;
+        entity.rotation = glm::vec3(90.0f, 180.0f, 0.0f);
+        entity.scale = glm::vec3(0.005f);
+        entity.startPosition = start;
+        entity.endPosition = end;
+        entity.targetPosition = end;
+        entity.movingForward = true;
+        entity.animationSpeed = 10.0f;
+        entity.programID = 0;
+        entity.mesh = nullptr;
+
+        size_t index = store.add();
+        SetRotation(store, index, glm::vec3(90.0f, 180.0f, 0.0f));
+        store.scale[index] = 0.005f;
+        paths.add(start, end, 10.0f);
+    }
+
+    std::vector<glm::mat4> matrices;
+    matrices.reserve(count);
+    std::vector<float> transforms(count * AFFINE_FLOATS);
+    size_t drawn = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        matrices.clear();
+        for (LegacyEntity& entity : legacy) {
+            entity.update(deltaTime);
+            if (glm::distance(entity.position, cameraPosition) <= renderRadius) {
+                matrices.push_back(entity.modelMatrix);
+            }
+        }
+        drawn += matrices.size();
+    }
+    double legacySeconds = secondsSince(start);
+
+    std::vector<uint32_t> visible;
+    visible.reserve(count);
+    start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frames; ++frame) {
+        paths.advance(deltaTime);
+        visible.clear();
+        for (size_t i = 0; i < count; ++i) {
+            if (glm::distance(paths.position(i), cameraPosition) <= renderRadius) {
+                visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+        for (uint32_t i : visible) {
+            paths.evaluate(i, store);
+        }
+        ComposeAffinePacked(GetTransformArrays(store), visible.data(), visible.size(), transforms.data());
+        drawn += visible.size();
+    }
+    double storeSeconds = secondsSince(start);
+
+    double perEntity = 1e9 / (static_cast<double>(count) * frames);
+    std::cout << count << " entities, " << frames << " frames (" << drawn << " draws)" << std::endl;
+    std::cout << "  legacy objects: " << legacySeconds * perEntity << " ns/entity/frame, "
+              << sizeof(LegacyEntity) << " bytes/entity" << std::endl;
+    std::cout << "  packed arrays:  " << storeSeconds * perEntity << " ns/entity/frame" << std::endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+// Offline converter from .jpg/.png to the mip-mapped .fetx layout loaded by
+// LoadTextureTileBox.
+//
+//   texture_cook [--rgba8] [--linear] <image> [<image> ...]
+//
+// --rgba8 keeps the chain uncompressed, --linear filters the mips as data
+// (normal maps) instead of sRGB colour. Each input is written next to itself
+// with a .fetx extension.
+
+#define STB_IMAGE_IMPLEMENTATION
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tinygltf-2.9.3/stb_image.h>
+#include <utils/cooked_texture_format.h>
+#include <utils/texture_cooker.h>
+
+static bool cookFile(const std::string& inputPath, bool compress, bool srgb) {
+    int w, h, channels;
+    uint8_t* img = stbi_load(inputPath.c_str(), &w, &h, &channels, 4);
+    if (!img) {
+        std::cerr << "Failed to load image: " << inputPath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> cooked;
+    bool res = CookTexture(img, w, h, srgb, compress, cooked);
+    stbi_image_free(img);
+    if (!res) {
+        std::cerr << "Failed to cook " << inputPath << std::endl;
+        return false;
+    }
+
+    std::string outputPath = CookedTexturePath(inputPath);
+    std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(cooked.data()), static_cast<std::streamsize>(cooked.size()));
+    if (!file.good()) {
+        std::cerr << "Failed to write " << outputPath << std::endl;
+        return false;
+    }
+
+    const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(cooked.data());
+    const char* formatNames[] = {"RGBA8", "BC1", "BC3"};
+    std::cout << "Cooked " << inputPath << " -> " << outputPath << " ("
+              << w << "x" << h << ", "
+              << header->levelCount << " levels, "
+              << formatNames[header->format] << ", "
+              << cooked.size() / 1024 << " KiB)" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    bool compress = true;
+    bool srgb = true;
+    int failures = 0;
+    int inputs = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--rgba8") == 0) {
+            compress = false;
+        } else if (strcmp(argv[i], "--linear") == 0) {
+            srgb = false;
+        } else {
+            inputs++;
+            if (!cookFile(argv[i], compress, srgb)) {
+                failures++;
+            }
+        }
+    }
+
+    if (inputs == 0) {
+        std::cerr << "Usage: texture_cook [--rgba8] [--linear] <image> [<image> ...]" << std::endl;
+        return 1;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
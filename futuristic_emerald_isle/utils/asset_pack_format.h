@@ -0,0 +1,86 @@
+#ifndef ASSET_PACK_FORMAT_H
+#define ASSET_PACK_FORMAT_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Single-file archive written by asset_pack and mounted by the VFS. Entry
+// data comes first, each blob aligned to ASSET_PACK_ALIGNMENT, followed by
+// the table of contents and the packed (not null-terminated) entry names.
+// Names are paths relative to futuristic_emerald_isle/, e.g.
+// "assets/textures/facade0.jpg".
+
+#define ASSET_PACK_MAGIC 0x4B504546u    // "FEPK"
+#define ASSET_PACK_VERSION 1u
+#define ASSET_PACK_ALIGNMENT 64u
+#define ASSET_PACK_EXTENSION ".fepak"
+
+enum AssetPackEntryFlags : uint32_t {
+    ASSET_PACK_COMPRESSED = 1u          // zlib stream, rawSize bytes once inflated
+};
+
+struct AssetPackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t pad;
+    uint64_t tocOffset;                 // AssetPackEntry[entryCount], sorted by name
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    uint64_t fileSize;
+};
+
+struct AssetPackEntry {
+    uint64_t offset;
+    uint64_t size;                      // Bytes stored in the pack
+    uint64_t rawSize;                   // Bytes after decompression
+    uint32_t nameOffset;                // Into the names block
+    uint32_t nameLength;
+    uint32_t flags;
+    uint32_t pad;
+};
+
+static_assert(sizeof(AssetPackHeader) == 48, "AssetPackHeader layout changed");
+static_assert(sizeof(AssetPackEntry) == 40, "AssetPackEntry layout changed");
+
+// Maps any path the game uses to its entry name by collapsing "." and ".."
+// and dropping everything up to the futuristic_emerald_isle/ directory:
+// "../futuristic_emerald_isle/assets/a/../b.png" -> "assets/b.png"
+inline std::string AssetPackName(const std::string& path) {
+    std::vector<std::string> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == std::string::npos) end = path.size();
+
+        std::string part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty() && parts.back() != "..") {
+                parts.pop_back();
+            } else {
+                parts.push_back(part);
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+
+    // Pack names are relative to the game directory
+    size_t first = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (parts[i] == "futuristic_emerald_isle") {
+            first = i + 1;
+        }
+    }
+
+    std::string name;
+    for (size_t i = first; i < parts.size(); ++i) {
+        if (!name.empty()) name += '/';
+        name += parts[i];
+    }
+    return name;
+}
+
+#endif // ASSET_PACK_FORMAT_H
@@ -0,0 +1,194 @@
+#include "async_loader.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <render/mesh.h>
+#include "load_textures.h"
+
+namespace {
+
+// Parsing and decoding are the loader's only CPU work, and the job system
+// already has a thread per core, so the loader mostly waits on the disk
+const int DEFAULT_WORKERS = 2;
+
+}
+
+AsyncLoader::AsyncLoader() : stopping(false), inFlight(0), unpackBufferID(0) {}
+
+AsyncLoader::~AsyncLoader() {
+    stop();
+}
+
+void AsyncLoader::start(int workerCount) {
+    if (!workers.empty()) {
+        return;
+    }
+
+    if (workerCount <= 0) {
+        workerCount = DEFAULT_WORKERS;
+    }
+
+    stopping = false;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&AsyncLoader::workerLoop, this);
+    }
+}
+
+void AsyncLoader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        pending.clear();
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Finish callbacks may reference objects that are about to be cleaned up
+    completed.clear();
+    inFlight = 0;
+
+    if (unpackBufferID != 0) {
+        glDeleteBuffers(1, &unpackBufferID);
+        unpackBufferID = 0;
+    }
+}
+
+void AsyncLoader::submit(std::function<void()> work, std::function<void()> finish) {
+    if (workers.empty()) {
+        if (work) work();
+        runOnMainThread(std::move(finish));
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back({std::move(work), std::move(finish)});
+    }
+    wake.notify_one();
+}
+
+void AsyncLoader::runOnMainThread(std::function<void()> finish) {
+    std::lock_guard<std::mutex> lock(mutex);
+    completed.push_back(std::move(finish));
+}
+
+void AsyncLoader::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (stopping) {
+                return;
+            }
+            job = std::move(pending.front());
+            pending.pop_front();
+            inFlight++;
+        }
+
+        if (job.work) {
+            job.work();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        completed.push_back(std::move(job.finish));
+        inFlight--;
+    }
+}
+
+void AsyncLoader::loadTexture(const std::string& path, std::function<void(GLuint)> done) {
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    submit(
+        [path, data] {
+            if (!ReadCookedTexture(path.c_str(), *data)) {
+                data->clear();
+            }
+        },
+        [this, path, data, done] {
+            GLuint texture = data->empty() ? 0 : uploadTexture(*data);
+            if (texture == 0) {
+                std::cout << "Failed to load texture " << path << std::endl;
+            }
+            if (done) done(texture);
+        });
+}
+
+void AsyncLoader::loadMesh(Mesh& mesh, const std::string& gltfPath, std::function<void(bool)> done) {
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    Mesh* target = &mesh;
+    submit(
+        [gltfPath, data] {
+            if (!Mesh::readCooked(gltfPath, *data)) {
+                data->clear();
+            }
+        },
+        [target, gltfPath, data, done] {
+            bool ok = !data->empty() && target->loadFromMemory(data->data(), data->size());
+            if (!ok) {
+                std::cerr << "Failed to load mesh " << gltfPath << std::endl;
+            }
+            if (done) done(ok);
+        });
+}
+
+GLuint AsyncLoader::uploadTexture(const std::vector<uint8_t>& data) {
+    if (unpackBufferID == 0) {
+        glGenBuffers(1, &unpackBufferID);
+    }
+
+    // Orphan the previous contents so the driver never waits on an upload
+    // that is still reading from the old storage
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, unpackBufferID);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, data.size(), nullptr, GL_STREAM_DRAW);
+    void* staging = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, data.size(), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    GLuint texture = 0;
+    if (staging) {
+        memcpy(staging, data.data(), data.size());
+        if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER)) {
+            texture = LoadCookedTexture(data.data(), data.size(), unpackBufferID);
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // Mapping can fail (or the buffer can be lost); upload straight from memory
+    if (texture == 0) {
+        texture = LoadCookedTexture(data.data(), data.size());
+    }
+    return texture;
+}
+
+void AsyncLoader::pump(double budgetSeconds) {
+    auto start = std::chrono::steady_clock::now();
+
+    while (true) {
+        std::function<void()> finish;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (completed.empty()) {
+                return;
+            }
+            finish = std::move(completed.front());
+            completed.pop_front();
+        }
+
+        if (finish) {
+            finish();
+        }
+
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() >= budgetSeconds) {
+            return;
+        }
+    }
+}
+
+bool AsyncLoader::idle() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pending.empty() && completed.empty() && inFlight == 0;
+}
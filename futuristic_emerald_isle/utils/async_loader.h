@@ -0,0 +1,62 @@
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <glad/gl.h>
+
+class Mesh;
+
+// Background asset loading. File reads, glTF parsing and image decoding run
+// on worker threads; anything touching GL is queued back to the thread that
+// owns the context and drained by pump() under a per-frame time budget.
+class AsyncLoader {
+public:
+    AsyncLoader();
+    ~AsyncLoader();
+
+    // workerCount = 0 picks two, beside the job system's own threads
+    void start(int workerCount = 0);
+    void stop();
+
+    // Runs work on a worker, then finish on the GL thread. Without workers
+    // (start() not called) work runs inline.
+    void submit(std::function<void()> work, std::function<void()> finish);
+    void runOnMainThread(std::function<void()> finish);
+
+    // done receives the texture, or 0 if it could not be loaded
+    void loadTexture(const std::string& path, std::function<void(GLuint)> done);
+    void loadMesh(Mesh& mesh, const std::string& gltfPath, std::function<void(bool)> done);
+
+    // GL thread only. Runs finished callbacks until budgetSeconds is spent,
+    // always at least one so loading cannot stall.
+    void pump(double budgetSeconds);
+    bool idle();
+
+private:
+    struct Job {
+        std::function<void()> work;
+        std::function<void()> finish;
+    };
+
+    void workerLoop();
+    GLuint uploadTexture(const std::vector<uint8_t>& data);
+
+    std::vector<std::thread> workers;
+    std::deque<Job> pending;
+    std::deque<std::function<void()>> completed;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping;
+    int inFlight;
+
+    // Staging buffer for texture uploads, orphaned on every use
+    GLuint unpackBufferID;
+};
+
+#endif // ASYNC_LOADER_H
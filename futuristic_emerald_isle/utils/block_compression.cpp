@@ -0,0 +1,250 @@
+#include "block_compression.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+uint16_t packRGB565(const float rgb[3]) {
+    int r = std::min(31, std::max(0, static_cast<int>(rgb[0] * 31.0f / 255.0f + 0.5f)));
+    int g = std::min(63, std::max(0, static_cast<int>(rgb[1] * 63.0f / 255.0f + 0.5f)));
+    int b = std::min(31, std::max(0, static_cast<int>(rgb[2] * 31.0f / 255.0f + 0.5f)));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void unpackRGB565(uint16_t c, int rgb[3]) {
+    int r = (c >> 11) & 31;
+    int g = (c >> 5) & 63;
+    int b = c & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void colorPalette(uint16_t c0, uint16_t c1, bool fourColor, int palette[4][4]) {
+    unpackRGB565(c0, palette[0]);
+    unpackRGB565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    for (int k = 0; k < 3; ++k) {
+        if (fourColor) {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        } else {
+            palette[2][k] = (palette[0][k] + palette[1][k]) / 2;
+            palette[3][k] = 0;
+        }
+    }
+    palette[2][3] = 255;
+    palette[3][3] = fourColor ? 255 : 0;
+}
+
+void alphaPalette(uint8_t a0, uint8_t a1, int palette[8]) {
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i) palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+    } else {
+        for (int i = 1; i < 5; ++i) palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+// Colour part shared by BC1 and BC3; always uses the four-colour mode
+void encodeColorBlock(const uint8_t rgba[64], uint8_t out[8]) {
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; ++i)
+        for (int k = 0; k < 3; ++k)
+            mean[k] += rgba[i * 4 + k] / 16.0f;
+
+    float cov[6] = {0.0f};
+    for (int i = 0; i < 16; ++i) {
+        float d[3] = {rgba[i * 4] - mean[0], rgba[i * 4 + 1] - mean[1], rgba[i * 4 + 2] - mean[2]};
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+
+    // Principal axis by power iteration
+    float axis[3] = {1.0f, 1.0f, 1.0f};
+    for (int iter = 0; iter < 8; ++iter) {
+        float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+        float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+        float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+        float len = std::sqrt(x * x + y * y + z * z);
+        if (len < 1e-6f) break;
+        axis[0] = x / len; axis[1] = y / len; axis[2] = z / len;
+    }
+
+    float minProj = 1e30f, maxProj = -1e30f;
+    for (int i = 0; i < 16; ++i) {
+        float p = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] + (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        minProj = std::min(minProj, p);
+        maxProj = std::max(maxProj, p);
+    }
+
+    // Inset the endpoints slightly, the extremes are rarely worth a palette slot
+    float inset = (maxProj - minProj) / 16.0f;
+    minProj += inset;
+    maxProj -= inset;
+
+    float hi[3], lo[3];
+    for (int k = 0; k < 3; ++k) {
+        hi[k] = mean[k] + axis[k] * maxProj;
+        lo[k] = mean[k] + axis[k] * minProj;
+    }
+
+    uint16_t c0 = packRGB565(hi);
+    uint16_t c1 = packRGB565(lo);
+    if (c0 < c1) std::swap(c0, c1);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        int palette[4][4];
+        colorPalette(c0, c1, true, palette);
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDist = 1 << 30;
+            for (int p = 0; p < 4; ++p) {
+                int dr = rgba[i * 4] - palette[p][0];
+                int dg = rgba[i * 4 + 1] - palette[p][1];
+                int db = rgba[i * 4 + 2] - palette[p][2];
+                int dist = dr * dr + dg * dg + db * db;
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint32_t>(best) << (2 * i);
+        }
+    }
+
+    out[0] = c0 & 0xFF; out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF; out[3] = c1 >> 8;
+    for (int i = 0; i < 4; ++i) out[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+void encodeAlphaBlock(const uint8_t rgba[64], uint8_t out[8]) {
+    uint8_t a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; ++i) {
+        a0 = std::max(a0, rgba[i * 4 + 3]);
+        a1 = std::min(a1, rgba[i * 4 + 3]);
+    }
+
+    uint64_t indices = 0;
+    if (a0 != a1) {
+        int palette[8];
+        alphaPalette(a0, a1, palette);
+        for (int i = 0; i < 16; ++i) {
+            int best = 0, bestDist = 1 << 30;
+            for (int p = 0; p < 8; ++p) {
+                int dist = std::abs(rgba[i * 4 + 3] - palette[p]);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = p;
+                }
+            }
+            indices |= static_cast<uint64_t>(best) << (3 * i);
+        }
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for (int i = 0; i < 6; ++i) out[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+void decodeColorBlock(const uint8_t block[8], bool allowThreeColor, uint8_t rgba[64]) {
+    uint16_t c0 = block[0] | (block[1] << 8);
+    uint16_t c1 = block[2] | (block[3] << 8);
+    uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+
+    int palette[4][4];
+    colorPalette(c0, c1, !allowThreeColor || c0 > c1, palette);
+    for (int i = 0; i < 16; ++i) {
+        const int* c = palette[(indices >> (2 * i)) & 3];
+        for (int k = 0; k < 4; ++k) rgba[i * 4 + k] = static_cast<uint8_t>(c[k]);
+    }
+}
+
+}
+
+void EncodeBC1Block(const uint8_t rgba[64], uint8_t out[8]) {
+    encodeColorBlock(rgba, out);
+}
+
+void EncodeBC3Block(const uint8_t rgba[64], uint8_t out[16]) {
+    encodeAlphaBlock(rgba, out);
+    encodeColorBlock(rgba, out + 8);
+}
+
+void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64]) {
+    decodeColorBlock(block, true, rgba);
+}
+
+void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64]) {
+    decodeColorBlock(block + 8, false, rgba);
+
+    int palette[8];
+    alphaPalette(block[0], block[1], palette);
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    for (int i = 0; i < 16; ++i) {
+        rgba[i * 4 + 3] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+    }
+}
+
+size_t BlockCompressedSize(int width, int height, bool withAlpha) {
+    size_t blocksX = std::max(1, (width + 3) / 4);
+    size_t blocksY = std::max(1, (height + 3) / 4);
+    return blocksX * blocksY * (withAlpha ? 16 : 8);
+}
+
+void CompressImage(const uint8_t* rgba, int width, int height, bool withAlpha, std::vector<uint8_t>& out) {
+    out.resize(BlockCompressedSize(width, height, withAlpha));
+    size_t blockBytes = withAlpha ? 16 : 8;
+    int blocksX = std::max(1, (width + 3) / 4);
+    int blocksY = std::max(1, (height + 3) / 4);
+
+    uint8_t block[64];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            for (int y = 0; y < 4; ++y) {
+                int sy = std::min(by * 4 + y, height - 1);
+                for (int x = 0; x < 4; ++x) {
+                    int sx = std::min(bx * 4 + x, width - 1);
+                    memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(sy) * width + sx) * 4], 4);
+                }
+            }
+
+            uint8_t* dst = &out[(static_cast<size_t>(by) * blocksX + bx) * blockBytes];
+            if (withAlpha) {
+                EncodeBC3Block(block, dst);
+            } else {
+                EncodeBC1Block(block, dst);
+            }
+        }
+    }
+}
+
+void DecompressImage(const uint8_t* blocks, int width, int height, bool withAlpha, std::vector<uint8_t>& rgba) {
+    rgba.resize(static_cast<size_t>(width) * height * 4);
+    size_t blockBytes = withAlpha ? 16 : 8;
+    int blocksX = std::max(1, (width + 3) / 4);
+    int blocksY = std::max(1, (height + 3) / 4);
+
+    uint8_t block[64];
+    for (int by = 0; by < blocksY; ++by) {
+        for (int bx = 0; bx < blocksX; ++bx) {
+            const uint8_t* src = &blocks[(static_cast<size_t>(by) * blocksX + bx) * blockBytes];
+            if (withAlpha) {
+                DecodeBC3Block(src, block);
+            } else {
+                DecodeBC1Block(src, block);
+            }
+
+            for (int y = 0; y < 4 && by * 4 + y < height; ++y) {
+                for (int x = 0; x < 4 && bx * 4 + x < width; ++x) {
+                    memcpy(&rgba[(static_cast<size_t>(by * 4 + y) * width + bx * 4 + x) * 4], &block[(y * 4 + x) * 4], 4);
+                }
+            }
+        }
+    }
+}
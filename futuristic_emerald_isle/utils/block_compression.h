@@ -0,0 +1,25 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// S3TC/BC block codecs. Blocks are 4x4 pixels; BC1 blocks take 8 bytes and
+// BC3 blocks 16. The encoders fit endpoints along the principal colour axis,
+// which is plenty for facade and foliage textures.
+
+void EncodeBC1Block(const uint8_t rgba[64], uint8_t out[8]);
+void EncodeBC3Block(const uint8_t rgba[64], uint8_t out[16]);
+
+void DecodeBC1Block(const uint8_t block[8], uint8_t rgba[64]);
+void DecodeBC3Block(const uint8_t block[16], uint8_t rgba[64]);
+
+size_t BlockCompressedSize(int width, int height, bool withAlpha);
+
+// Whole-image helpers. Images whose sides are not multiples of 4 are padded
+// by replicating the last row/column.
+void CompressImage(const uint8_t* rgba, int width, int height, bool withAlpha, std::vector<uint8_t>& out);
+void DecompressImage(const uint8_t* blocks, int width, int height, bool withAlpha, std::vector<uint8_t>& rgba);
+
+#endif // BLOCK_COMPRESSION_H
@@ -0,0 +1,103 @@
+#ifndef COOKED_MESH_FORMAT_H
+#define COOKED_MESH_FORMAT_H
+
+#include <stdint.h>
+
+// Flat binary layout written by asset_cook and mmapped at runtime.
+// Every section is a tightly packed array of the structs below, starting at
+// the offset stored in the header and aligned to COOKED_MESH_ALIGNMENT.
+
+#define COOKED_MESH_MAGIC 0x4D494546u   // "FEIM"
+#define COOKED_MESH_VERSION 2u
+#define COOKED_MESH_ALIGNMENT 16u
+#define COOKED_MESH_EXTENSION ".feim"
+
+enum CookedAnimationPath : uint32_t {
+    COOKED_PATH_TRANSLATION = 0,
+    COOKED_PATH_ROTATION = 1,
+    COOKED_PATH_SCALE = 2
+};
+
+struct CookedMeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t primitiveCount;
+    uint32_t nodeCount;
+    uint32_t materialCount;
+    uint32_t textureCount;
+    uint32_t animationCount;
+    uint32_t channelCount;
+    uint64_t fileSize;
+    uint64_t vertexOffset;      // CookedVertex[vertexCount]
+    uint64_t indexOffset;       // uint32_t[indexCount], already rebased
+    uint64_t primitiveOffset;   // CookedPrimitive[primitiveCount]
+    uint64_t nodeOffset;        // CookedNode[nodeCount]
+    uint64_t materialOffset;    // CookedMaterial[materialCount]
+    uint64_t textureOffset;     // CookedTexture[textureCount]
+    uint64_t animationOffset;   // CookedAnimation[animationCount]
+    uint64_t channelOffset;     // CookedAnimationChannel[channelCount]
+};
+
+// Interleaved stream matching the attribute locations of the model shaders:
+// 0 = position, 1 = uv, 2 = normal.
+struct CookedVertex {
+    float position[3];
+    float uv[2];
+    float normal[3];
+};
+
+// Primitives are stored in the draw order of the source node list.
+struct CookedPrimitive {
+    uint32_t firstIndex;
+    uint32_t indexCount;
+    int32_t material;
+    int32_t node;
+};
+
+struct CookedNode {
+    float worldMatrix[16];      // Column-major, parents already applied
+    int32_t mesh;
+    int32_t parent;
+    uint32_t pad[2];
+};
+
+struct CookedMaterial {
+    float baseColorFactor[4];
+    int32_t baseColorTexture;
+    int32_t normalTexture;
+    uint32_t pad[2];
+};
+
+// Each texture is an embedded .fetx container (see cooked_texture_format.h).
+struct CookedTexture {
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pad[2];
+};
+
+struct CookedAnimation {
+    uint32_t firstChannel;
+    uint32_t channelCount;
+    float duration;
+    uint32_t pad;
+};
+
+// Keyframe times are float[keyCount], values float[keyCount * components].
+struct CookedAnimationChannel {
+    uint32_t path;
+    int32_t node;
+    uint32_t keyCount;
+    uint32_t components;
+    uint64_t timesOffset;
+    uint64_t valuesOffset;
+};
+
+static_assert(sizeof(CookedVertex) == 32, "CookedVertex must stay GPU-friendly");
+static_assert(sizeof(CookedMeshHeader) % COOKED_MESH_ALIGNMENT == 0, "Header must keep sections aligned");
+static_assert(sizeof(CookedNode) % COOKED_MESH_ALIGNMENT == 0, "CookedNode must keep sections aligned");
+
+#endif // COOKED_MESH_FORMAT_H
@@ -0,0 +1,48 @@
+#ifndef COOKED_TEXTURE_FORMAT_H
+#define COOKED_TEXTURE_FORMAT_H
+
+#include <stdint.h>
+
+// Container written by texture_cook (and embedded in .feim meshes) holding a
+// complete mip chain, either block compressed or as plain RGBA8. Level data
+// is stored largest first at the offsets listed in the level table.
+
+#define COOKED_TEXTURE_MAGIC 0x58544546u    // "FETX"
+#define COOKED_TEXTURE_VERSION 1u
+#define COOKED_TEXTURE_MAX_LEVELS 16u
+#define COOKED_TEXTURE_EXTENSION ".fetx"
+
+enum CookedTextureFormat : uint32_t {
+    COOKED_TEXTURE_RGBA8 = 0,
+    COOKED_TEXTURE_BC1 = 1,         // S3TC DXT1, opaque
+    COOKED_TEXTURE_BC3 = 2          // S3TC DXT5, interpolated alpha
+};
+
+enum CookedTextureFlags : uint32_t {
+    COOKED_TEXTURE_SRGB = 1u,       // Mips were filtered in linear light
+    COOKED_TEXTURE_HAS_ALPHA = 2u
+};
+
+struct CookedTextureHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t format;
+    uint32_t flags;
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;
+    uint32_t pad;
+};
+
+struct CookedTextureLevel {
+    uint64_t offset;                // From the start of the container
+    uint64_t size;
+    uint32_t width;
+    uint32_t height;
+    uint32_t pad[2];
+};
+
+static_assert(sizeof(CookedTextureHeader) == 32, "CookedTextureHeader layout changed");
+static_assert(sizeof(CookedTextureLevel) == 32, "CookedTextureLevel layout changed");
+
+#endif // COOKED_TEXTURE_FORMAT_H
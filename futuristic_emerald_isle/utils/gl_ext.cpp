@@ -0,0 +1,54 @@
+#include "gl_ext.h"
+#include <cstring>
+#include <set>
+#include <string>
+
+GLExtGetProgramBinaryProc glExtGetProgramBinary = nullptr;
+GLExtProgramBinaryProc glExtProgramBinary = nullptr;
+GLExtProgramParameteriProc glExtProgramParameteri = nullptr;
+GLExtMaxShaderCompilerThreadsProc glExtMaxShaderCompilerThreads = nullptr;
+GLExtMultiDrawElementsIndirectProc glExtMultiDrawElementsIndirect = nullptr;
+GLExtBufferStorageProc glExtBufferStorage = nullptr;
+
+void LoadGLExtensions(GLADloadfunc load) {
+    // Program binaries are core in 4.1 and otherwise come with ARB_get_program_binary
+    if (HasGLExtension("GL_ARB_get_program_binary")) {
+        glExtGetProgramBinary = reinterpret_cast<GLExtGetProgramBinaryProc>(load("glGetProgramBinary"));
+        glExtProgramBinary = reinterpret_cast<GLExtProgramBinaryProc>(load("glProgramBinary"));
+        glExtProgramParameteri = reinterpret_cast<GLExtProgramParameteriProc>(load("glProgramParameteri"));
+    }
+
+    if (HasGLExtension("GL_KHR_parallel_shader_compile")) {
+        glExtMaxShaderCompilerThreads = reinterpret_cast<GLExtMaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsKHR"));
+    } else if (HasGLExtension("GL_ARB_parallel_shader_compile")) {
+        glExtMaxShaderCompilerThreads = reinterpret_cast<GLExtMaxShaderCompilerThreadsProc>(load("glMaxShaderCompilerThreadsARB"));
+    }
+
+    // Core in 4.3. Draws read their per-draw attributes from baseInstance
+    // on, which is only honoured with ARB_base_instance (core in 4.2).
+    if (HasGLExtension("GL_ARB_multi_draw_indirect") && HasGLExtension("GL_ARB_draw_indirect") && HasGLExtension("GL_ARB_base_instance")) {
+        glExtMultiDrawElementsIndirect = reinterpret_cast<GLExtMultiDrawElementsIndirectProc>(load("glMultiDrawElementsIndirect"));
+    }
+
+    // Immutable storage, which persistent mappings need. Core in 4.4.
+    if (HasGLExtension("GL_ARB_buffer_storage")) {
+        glExtBufferStorage = reinterpret_cast<GLExtBufferStorageProc>(load("glBufferStorage"));
+    }
+}
+
+bool HasGLExtension(const char* name) {
+    static std::set<std::string> extensions;
+    static bool queried = false;
+
+    if (!queried) {
+        GLint count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for (GLint i = 0; i < count; ++i) {
+            const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+            if (extension) extensions.insert(extension);
+        }
+        queried = true;
+    }
+
+    return extensions.count(name) > 0;
+}
@@ -0,0 +1,60 @@
+#ifndef GL_EXT_H
+#define GL_EXT_H
+
+#include <glad/gl.h>
+
+// Tokens for extensions the 3.3 core loader does not know about
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_DRAW_INDIRECT_BUFFER
+#define GL_DRAW_INDIRECT_BUFFER 0x8F3F
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+#ifndef GLAD_API_PTR
+#define GLAD_API_PTR
+#endif
+
+// Entry points above the 3.3 core that glad does not load for us. They stay
+// null unless the driver exposes them, so check before calling.
+typedef void (GLAD_API_PTR *GLExtGetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (GLAD_API_PTR *GLExtProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (GLAD_API_PTR *GLExtProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+typedef void (GLAD_API_PTR *GLExtMaxShaderCompilerThreadsProc)(GLuint count);
+typedef void (GLAD_API_PTR *GLExtMultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+typedef void (GLAD_API_PTR *GLExtBufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+extern GLExtGetProgramBinaryProc glExtGetProgramBinary;
+extern GLExtProgramBinaryProc glExtProgramBinary;
+extern GLExtProgramParameteriProc glExtProgramParameteri;
+extern GLExtMaxShaderCompilerThreadsProc glExtMaxShaderCompilerThreads;
+// Only set when base instances come with it, so per-draw attributes work
+extern GLExtMultiDrawElementsIndirectProc glExtMultiDrawElementsIndirect;
+extern GLExtBufferStorageProc glExtBufferStorage;
+
+// Resolves the entry points above. Call once after gladLoadGL.
+void LoadGLExtensions(GLADloadfunc load);
+
+// Queries the extension list of the current context (cached after first use)
+bool HasGLExtension(const char* name);
+
+#endif // GL_EXT_H
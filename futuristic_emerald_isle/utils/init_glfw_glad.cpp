@@ -1,4 +1,5 @@
 #include "init_glfw_glad.h"
+#include "gl_ext.h"
 
 GLFWwindow* initializeOpenGL(const char* windowTitle, int width, int height) {
     if (!glfwInit()) {
@@ -23,6 +24,7 @@ GLFWwindow* initializeOpenGL(const char* windowTitle, int width, int height) {
         std::cerr << "Failed to initialize OpenGL context." << std::endl;
         return nullptr;
     }
+    LoadGLExtensions(glfwGetProcAddress);
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
@@ -0,0 +1,325 @@
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+JobSystem jobSystem;
+
+namespace {
+
+const size_t ARENA_BLOCK_SIZE = 1 << 20;
+
+// Index of the worker running on this thread, -1 outside the pool, and
+// how many jobs deep it is. A job that waits runs others inside its own.
+thread_local int currentWorker = -1;
+thread_local int jobDepth = 0;
+thread_local ScratchArena externalArena;
+
+int64_t nanosecondsNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+}
+
+ScratchArena::ScratchArena() : block(0), used(0) {}
+
+void* ScratchArena::allocateBytes(size_t bytes, size_t alignment) {
+    while (block < blocks.size()) {
+        uintptr_t base = reinterpret_cast<uintptr_t>(blocks[block].data.get());
+        size_t offset = ((base + used + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+        if (offset + bytes <= blocks[block].size) {
+            used = offset + bytes;
+            return blocks[block].data.get() + offset;
+        }
+        block++;
+        used = 0;
+    }
+
+    Block fresh;
+    fresh.size = std::max(ARENA_BLOCK_SIZE, bytes + alignment);
+    fresh.data.reset(new uint8_t[fresh.size]);
+    blocks.push_back(std::move(fresh));
+    block = blocks.size() - 1;
+    used = 0;
+    return allocateBytes(bytes, alignment);
+}
+
+void ScratchArena::rewind(const Marker& marker) {
+    block = marker.block;
+    used = marker.used;
+}
+
+TaskGraph::Task TaskGraph::add(std::function<void()> work, std::initializer_list<Task> after) {
+    Task task = tasks.size();
+    Node node;
+    node.work = std::move(work);
+    for (Task dependency : after) {
+        if (dependency < task) {
+            tasks[dependency].successors.push_back(task);
+            node.dependencies++;
+        }
+    }
+    tasks.push_back(std::move(node));
+    return task;
+}
+
+double JobStats::utilization() const {
+    if (busy.empty()) {
+        return 0.0;
+    }
+    double total = 0.0;
+    for (double fraction : busy) {
+        total += fraction;
+    }
+    return total / busy.size();
+}
+
+JobSystem::JobSystem() : queued(0), stopping(false), externalJobs(0), statsStart(nanosecondsNow()) {}
+
+JobSystem::~JobSystem() {
+    stop();
+}
+
+void JobSystem::start(int workerCount) {
+    if (!workers.empty()) {
+        return;
+    }
+
+    if (workerCount <= 0) {
+        int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    stopping = false;
+    for (int i = 0; i < workerCount; ++i) {
+        workers.emplace_back(new Worker());
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        workers[i]->thread = std::thread(&JobSystem::workerLoop, this, i);
+    }
+    statsStart = nanosecondsNow();
+
+    std::cout << "Job system: " << workerCount << " workers" << std::endl;
+}
+
+void JobSystem::stop() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+    workers.clear();
+    inbox.clear();
+    queued = 0;
+}
+
+void JobSystem::submit(Job job, JobCounter& counter) {
+    counter.pending.fetch_add(1, std::memory_order_relaxed);
+    if (workers.empty()) {
+        job();
+        counter.pending.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    int self = currentWorker;
+    if (self >= 0) {
+        std::lock_guard<std::mutex> lock(workers[self]->mutex);
+        workers[self]->jobs.push_back({std::move(job), &counter});
+    } else {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        inbox.push_back({std::move(job), &counter});
+    }
+
+    // Sleepers check queued under sleepMutex, so taking it here means the
+    // notify cannot slip in between their check and their wait
+    queued.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_one();
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    int self = currentWorker;
+    while (counter.pending.load(std::memory_order_acquire) > 0) {
+        if (runOne(self)) {
+            continue;
+        }
+
+        // Nothing to help with, the rest is running elsewhere. A worker
+        // spinning here is not busy, even though its outer job is.
+        int64_t start = nanosecondsNow();
+        std::this_thread::yield();
+        if (self >= 0) {
+            workers[self]->idleNanoseconds.fetch_add(nanosecondsNow() - start, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool JobSystem::runOne(int self) {
+    Entry entry;
+    bool found = false;
+    bool stolen = false;
+
+    // Own jobs newest first, they are the smallest and still in cache
+    if (self >= 0) {
+        Worker& worker = *workers[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            entry = std::move(worker.jobs.back());
+            worker.jobs.pop_back();
+            found = true;
+        }
+    }
+
+    if (!found) {
+        std::lock_guard<std::mutex> lock(inboxMutex);
+        if (!inbox.empty()) {
+            entry = std::move(inbox.front());
+            inbox.pop_front();
+            found = true;
+        }
+    }
+
+    // Steal the oldest job of someone else, starting after ourselves so
+    // thieves spread over the victims
+    int count = static_cast<int>(workers.size());
+    for (int i = 1; !found && i <= count; ++i) {
+        int victim = (std::max(self, 0) + i) % count;
+        if (victim == self) continue;
+        Worker& worker = *workers[victim];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.jobs.empty()) {
+            entry = std::move(worker.jobs.front());
+            worker.jobs.pop_front();
+            found = stolen = true;
+        }
+    }
+
+    if (!found) {
+        return false;
+    }
+    queued.fetch_sub(1);
+
+    if (self >= 0) {
+        // Jobs run while waiting are already inside the outer job's time
+        Worker& worker = *workers[self];
+        int64_t start = jobDepth == 0 ? nanosecondsNow() : 0;
+        jobDepth++;
+        entry.job();
+        jobDepth--;
+        if (jobDepth == 0) {
+            worker.busyNanoseconds.fetch_add(nanosecondsNow() - start, std::memory_order_relaxed);
+        }
+        worker.jobCount.fetch_add(1, std::memory_order_relaxed);
+        if (stolen) worker.stealCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        entry.job();
+        externalJobs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    entry.counter->pending.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+void JobSystem::workerLoop(int index) {
+    currentWorker = index;
+    while (!stopping) {
+        if (runOne(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+    }
+    currentWorker = -1;
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const RangeJob& fn) {
+    grain = std::max<size_t>(grain, 1);
+    if (workers.empty() || count <= grain) {
+        if (count > 0) fn(0, count);
+        return;
+    }
+
+    JobCounter counter;
+    splitRange(0, count, grain, fn, counter);
+    wait(counter);
+}
+
+void JobSystem::splitRange(size_t begin, size_t end, size_t grain, const RangeJob& fn, JobCounter& counter) {
+    // Hand out the upper half until one piece is left, so a thief takes the
+    // biggest remaining range and splits it further on its own deque
+    while (end - begin > grain) {
+        size_t middle = begin + (end - begin) / 2;
+        submit([this, middle, end, grain, &fn, &counter] { splitRange(middle, end, grain, fn, counter); }, counter);
+        end = middle;
+    }
+    fn(begin, end);
+}
+
+void JobSystem::run(TaskGraph& graph) {
+    size_t count = graph.tasks.size();
+    if (count == 0) {
+        return;
+    }
+
+    // Dependencies always point backwards, so insertion order is a valid order
+    if (workers.empty()) {
+        for (TaskGraph::Node& node : graph.tasks) {
+            node.work();
+        }
+        return;
+    }
+
+    graph.remaining.reset(new std::atomic<int>[count]);
+    for (size_t i = 0; i < count; ++i) {
+        graph.remaining[i] = graph.tasks[i].dependencies;
+    }
+
+    JobCounter counter;
+    for (size_t i = 0; i < count; ++i) {
+        if (graph.tasks[i].dependencies == 0) {
+            submit([this, &graph, i, &counter] { runTask(graph, i, counter); }, counter);
+        }
+    }
+    wait(counter);
+}
+
+void JobSystem::runTask(TaskGraph& graph, TaskGraph::Task task, JobCounter& counter) {
+    graph.tasks[task].work();
+    for (TaskGraph::Task next : graph.tasks[task].successors) {
+        if (graph.remaining[next].fetch_sub(1) == 1) {
+            submit([this, &graph, next, &counter] { runTask(graph, next, counter); }, counter);
+        }
+    }
+}
+
+int JobSystem::currentWorkerIndex() {
+    return currentWorker;
+}
+
+ScratchArena& JobSystem::arena() {
+    int self = currentWorker;
+    return self >= 0 ? workers[self]->arena : externalArena;
+}
+
+JobStats JobSystem::collectStats() {
+    int64_t now = nanosecondsNow();
+    JobStats stats;
+    stats.seconds = (now - statsStart) * 1e-9;
+    statsStart = now;
+
+    for (auto& worker : workers) {
+        int64_t busy = static_cast<int64_t>(worker->busyNanoseconds.exchange(0)) - static_cast<int64_t>(worker->idleNanoseconds.exchange(0));
+        stats.busy.push_back(stats.seconds > 0.0 ? std::max(0.0, std::min(busy * 1e-9 / stats.seconds, 1.0)) : 0.0);
+        stats.jobs += worker->jobCount.exchange(0);
+        stats.steals += worker->stealCount.exchange(0);
+    }
+    stats.jobs += externalJobs.exchange(0);
+    return stats;
+}
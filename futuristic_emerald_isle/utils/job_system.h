@@ -0,0 +1,184 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bump allocator for a job's temporaries. Blocks are kept between uses, so
+// once warmed up a job allocates nothing from the heap. Only for trivially
+// destructible types; nothing is destroyed on rewind.
+class ScratchArena {
+public:
+    struct Marker {
+        size_t block;
+        size_t used;
+    };
+
+    ScratchArena();
+
+    template <typename T>
+    T* allocate(size_t count) {
+        return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T)));
+    }
+    void* allocateBytes(size_t bytes, size_t alignment);
+
+    Marker mark() const { return {block, used}; }
+    void rewind(const Marker& marker);
+
+private:
+    struct Block {
+        std::unique_ptr<uint8_t[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;
+    size_t block;
+    size_t used;
+};
+
+// Counts the jobs of one batch still pending. Wait on it with JobSystem::wait().
+struct JobCounter {
+    std::atomic<int> pending{0};
+};
+
+// Independent tasks with dependencies between them. A task can only run
+// after tasks added before it, so a graph never has cycles. Run it with
+// JobSystem::run(); the graph can be run again afterwards.
+class TaskGraph {
+public:
+    typedef size_t Task;
+
+    Task add(std::function<void()> work, std::initializer_list<Task> after = {});
+    size_t size() const { return tasks.size(); }
+
+private:
+    friend class JobSystem;
+
+    struct Node {
+        std::function<void()> work;
+        std::vector<Task> successors;
+        int dependencies = 0;
+    };
+
+    std::vector<Node> tasks;
+    std::unique_ptr<std::atomic<int>[]> remaining;
+};
+
+// Worker activity since the previous JobSystem::collectStats()
+struct JobStats {
+    double seconds = 0.0;
+    std::vector<double> busy;       // Fraction of seconds each worker spent running jobs
+    uint64_t jobs = 0;
+    uint64_t steals = 0;
+
+    double utilization() const;
+};
+
+// Work-stealing thread pool shared by scene setup and the simulation. Every
+// worker has its own deque: it pushes and pops at the back, idle workers
+// steal from the front, which holds the biggest pieces of a split range.
+// Threads outside the pool queue into a shared inbox, and any thread that
+// waits runs queued jobs until its own are done, so nested parallel loops
+// and waiting callers never leave a core idle.
+//
+// Jobs should be short, a millisecond or so: a waiting thread may pick up
+// a job from an unrelated batch and returns only once that one finishes.
+class JobSystem {
+public:
+    typedef std::function<void()> Job;
+    typedef std::function<void(size_t begin, size_t end)> RangeJob;
+
+    JobSystem();
+    ~JobSystem();
+
+    // workerCount = 0 picks one less than the number of hardware threads.
+    // Without workers everything runs inline on the calling thread.
+    void start(int workerCount = 0);
+    void stop();
+
+    int getWorkerCount() const { return static_cast<int>(workers.size()); }
+    int getThreadCount() const { return getWorkerCount() + 1; }
+
+    // Index of the worker running the caller, -1 on threads outside the pool
+    static int currentWorkerIndex();
+
+    void submit(Job job, JobCounter& counter);
+    void wait(JobCounter& counter);
+
+    // Calls fn(begin, end) over [0, count) in pieces of at most grain and
+    // returns once all are done. Each index should write only its own outputs.
+    void parallelFor(size_t count, size_t grain, const RangeJob& fn);
+
+    // Runs every task of the graph and returns once all are done
+    void run(TaskGraph& graph);
+
+    // Scratch memory of the calling thread, worker or not. Take an
+    // ArenaScope around its use so it is handed back when the job ends.
+    ScratchArena& arena();
+
+    JobStats collectStats();
+
+private:
+    struct Entry {
+        Job job;
+        JobCounter* counter;
+    };
+
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<Entry> jobs;
+        ScratchArena arena;
+        std::atomic<uint64_t> busyNanoseconds{0};
+        std::atomic<uint64_t> idleNanoseconds{0};
+        std::atomic<uint64_t> jobCount{0};
+        std::atomic<uint64_t> stealCount{0};
+    };
+
+    void workerLoop(int index);
+    bool runOne(int self);
+    void splitRange(size_t begin, size_t end, size_t grain, const RangeJob& fn, JobCounter& counter);
+    void runTask(TaskGraph& graph, TaskGraph::Task task, JobCounter& counter);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::mutex inboxMutex;
+    std::deque<Entry> inbox;
+
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<int> queued;
+    std::atomic<bool> stopping;
+
+    std::atomic<uint64_t> externalJobs;
+    int64_t statsStart;
+};
+
+extern JobSystem jobSystem;
+
+// Rewinds the calling thread's arena to where it was on construction
+class ArenaScope {
+public:
+    ArenaScope() : arena(jobSystem.arena()), marker(arena.mark()) {}
+    ~ArenaScope() { arena.rewind(marker); }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    template <typename T>
+    T* allocate(size_t count) { return arena.allocate<T>(count); }
+
+private:
+    ScratchArena& arena;
+    ScratchArena::Marker marker;
+};
+
+#endif // JOB_SYSTEM_H
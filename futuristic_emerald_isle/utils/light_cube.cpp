@@ -92,6 +92,5 @@ struct LightCube {
         glDeleteBuffers(1, &indexBufferID);
         glDeleteBuffers(1, &colorBufferID);
         glDeleteVertexArrays(1, &vertexArrayID);
-        glDeleteProgram(programID);
     }
 };
@@ -2,10 +2,28 @@
 #include <tinygltf-2.9.3/stb_image.h>
 #include <glad/gl.h>
 #include <iostream>
+#include <vector>
+#include "block_compression.h"
+#include "cooked_texture_format.h"
+#include "gl_ext.h"
+#include "texture_cooker.h"
+#include "vfs.h"
 
 GLuint LoadTextureTileBox(const char *texture_file_path) {
+    VfsFile cooked;
+    if (vfs.open(CookedTexturePath(texture_file_path), cooked)) {
+        GLuint texture = LoadCookedTexture(cooked.data(), cooked.size());
+        if (texture != 0) {
+            return texture;
+        }
+    }
+
     int w, h, channels;
-    uint8_t* img = stbi_load(texture_file_path, &w, &h, &channels, 3);
+    uint8_t* img = nullptr;
+    VfsFile image;
+    if (vfs.open(texture_file_path, image)) {
+        img = stbi_load_from_memory(image.data(), static_cast<int>(image.size()), &w, &h, &channels, 3);
+    }
     GLuint texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
@@ -25,4 +43,103 @@ GLuint LoadTextureTileBox(const char *texture_file_path) {
     stbi_image_free(img);
 
     return texture;
-}
\ No newline at end of file
+}
+
+GLuint LoadCookedTexture(const uint8_t *data, size_t size, GLuint unpackBuffer) {
+    if (size < sizeof(CookedTextureHeader)) {
+        return 0;
+    }
+
+    const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(data);
+    if (header->magic != COOKED_TEXTURE_MAGIC || header->version != COOKED_TEXTURE_VERSION ||
+        header->levelCount == 0 || header->levelCount > COOKED_TEXTURE_MAX_LEVELS ||
+        sizeof(CookedTextureHeader) + header->levelCount * sizeof(CookedTextureLevel) > size) {
+        std::cerr << "Cooked texture has a stale or unknown format, re-run texture_cook" << std::endl;
+        return 0;
+    }
+
+    const CookedTextureLevel* levels = reinterpret_cast<const CookedTextureLevel*>(data + sizeof(CookedTextureHeader));
+    for (uint32_t i = 0; i < header->levelCount; ++i) {
+        if (levels[i].offset > size || levels[i].size > size - levels[i].offset) {
+            std::cerr << "Cooked texture is truncated" << std::endl;
+            return 0;
+        }
+    }
+
+    bool compressed = header->format != COOKED_TEXTURE_RGBA8;
+    bool withAlpha = header->format == COOKED_TEXTURE_BC3;
+    bool uploadCompressed = compressed && HasGLExtension("GL_EXT_texture_compression_s3tc");
+    GLenum compressedFormat = withAlpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+
+    // Blocks that have to be expanded on the CPU cannot come from the buffer
+    bool fromBuffer = unpackBuffer != 0 && (!compressed || uploadCompressed);
+    if (unpackBuffer != 0 && !fromBuffer) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+
+    std::vector<uint8_t> decoded;
+    uint32_t uploaded = 0;
+    for (uint32_t i = 0; i < header->levelCount; ++i, ++uploaded) {
+        const CookedTextureLevel& level = levels[i];
+        const uint8_t* pixels = data + level.offset;
+        const void* source = fromBuffer ? reinterpret_cast<const void*>(static_cast<uintptr_t>(level.offset)) : pixels;
+
+        if (uploadCompressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, compressedFormat, level.width, level.height, 0,
+                                   static_cast<GLsizei>(level.size), source);
+            continue;
+        }
+
+        if (compressed) {
+            // No S3TC on this driver, expand the blocks back to RGBA8
+            if (level.size < BlockCompressedSize(level.width, level.height, withAlpha)) break;
+            DecompressImage(pixels, level.width, level.height, withAlpha, decoded);
+            source = decoded.data();
+        } else if (level.size < static_cast<uint64_t>(level.width) * level.height * 4) {
+            break;
+        }
+
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, source);
+    }
+
+    if (uploaded == 0) {
+        glDeleteTextures(1, &texture);
+        return 0;
+    }
+
+    // Only sample the levels that actually made it to the GPU
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, uploaded - 1);
+
+    return texture;
+}
+
+bool ReadCookedTexture(const char *texture_file_path, std::vector<uint8_t>& out) {
+    if (vfs.read(CookedTexturePath(texture_file_path), out)) {
+        return true;
+    }
+
+    VfsFile image;
+    if (!vfs.open(texture_file_path, image)) {
+        return false;
+    }
+
+    int w, h, channels;
+    uint8_t* img = stbi_load_from_memory(image.data(), static_cast<int>(image.size()), &w, &h, &channels, 4);
+    if (!img) {
+        return false;
+    }
+
+    bool res = CookTexture(img, w, h, true, false, out);
+    stbi_image_free(img);
+    return res;
+}
@@ -2,8 +2,21 @@
 #define LOAD_TEXTURES_H
 
 #include <glad/gl.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <vector>
 
+// Loads the cooked .fetx sibling of texture_file_path when it exists,
+// otherwise decodes the image and builds mipmaps on the GPU.
 GLuint LoadTextureTileBox(const char *texture_file_path);
 
+// Uploads a .fetx container with all of its mip levels. Returns 0 on failure.
+// When unpackBuffer is given it must be bound to GL_PIXEL_UNPACK_BUFFER and
+// hold a copy of data, so the levels are sourced from it instead.
+GLuint LoadCookedTexture(const uint8_t *data, size_t size, GLuint unpackBuffer = 0);
+
+// CPU half of LoadTextureTileBox, safe to call off the GL thread. Reads the
+// .fetx sibling or decodes the image and builds an uncompressed mip chain.
+bool ReadCookedTexture(const char *texture_file_path, std::vector<uint8_t>& out);
+
 #endif //LOAD_TEXTURES_H
@@ -0,0 +1,453 @@
+#include "mesh_cooker.h"
+#include "cooked_mesh_format.h"
+#include "texture_cooker.h"
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+namespace {
+
+size_t alignUp(size_t value) {
+    return (value + COOKED_MESH_ALIGNMENT - 1) & ~static_cast<size_t>(COOKED_MESH_ALIGNMENT - 1);
+}
+
+template <typename T>
+uint64_t appendSection(std::vector<uint8_t>& out, const T* items, size_t count) {
+    out.resize(alignUp(out.size()), 0);
+    uint64_t offset = out.size();
+    if (count > 0) {
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(items);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+    return offset;
+}
+
+template <typename T>
+uint64_t appendSection(std::vector<uint8_t>& out, const std::vector<T>& items) {
+    return appendSection(out, items.data(), items.size());
+}
+
+int componentCount(int type) {
+    switch (type) {
+        case TINYGLTF_TYPE_SCALAR: return 1;
+        case TINYGLTF_TYPE_VEC2: return 2;
+        case TINYGLTF_TYPE_VEC3: return 3;
+        case TINYGLTF_TYPE_VEC4: return 4;
+        default: return 0;
+    }
+}
+
+float readComponent(const unsigned char* p, int componentType, bool normalized) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT: {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            return normalized ? p[0] / 255.0f : p[0];
+        case TINYGLTF_COMPONENT_TYPE_BYTE: {
+            float v = static_cast<int8_t>(p[0]);
+            return normalized ? glm::max(v / 127.0f, -1.0f) : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: {
+            uint16_t v;
+            memcpy(&v, p, sizeof(v));
+            return normalized ? v / 65535.0f : v;
+        }
+        case TINYGLTF_COMPONENT_TYPE_SHORT: {
+            int16_t v;
+            memcpy(&v, p, sizeof(v));
+            return normalized ? glm::max(v / 32767.0f, -1.0f) : v;
+        }
+        default:
+            return 0.0f;
+    }
+}
+
+size_t componentSize(int componentType) {
+    switch (componentType) {
+        case TINYGLTF_COMPONENT_TYPE_BYTE:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: return 1;
+        case TINYGLTF_COMPONENT_TYPE_SHORT:
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: return 2;
+        default: return 4;
+    }
+}
+
+// Reads an accessor into a tightly packed float array of `components` per element,
+// zero-filling any missing components.
+bool readAccessor(const tinygltf::Model& model, int accessorIdx, int components, std::vector<float>& out, std::string& err) {
+    const auto& accessor = model.accessors[accessorIdx];
+    out.assign(accessor.count * components, 0.0f);
+    if (accessor.bufferView < 0) {
+        return true;
+    }
+
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const auto& buffer = model.buffers[bufferView.buffer];
+    int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0) {
+        err = "Invalid accessor stride";
+        return false;
+    }
+
+    int sourceComponents = glm::min(componentCount(accessor.type), components);
+    size_t elementSize = componentSize(accessor.componentType);
+    const unsigned char* base = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+    if (bufferView.byteOffset + accessor.byteOffset + (accessor.count - 1) * stride + sourceComponents * elementSize > buffer.data.size()) {
+        err = "Accessor reads past the end of its buffer";
+        return false;
+    }
+
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* element = base + i * stride;
+        for (int c = 0; c < sourceComponents; ++c) {
+            out[i * components + c] = readComponent(element + c * elementSize, accessor.componentType, accessor.normalized);
+        }
+    }
+    return true;
+}
+
+bool readIndices(const tinygltf::Model& model, int accessorIdx, std::vector<uint32_t>& out, std::string& err) {
+    const auto& accessor = model.accessors[accessorIdx];
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const auto& buffer = model.buffers[bufferView.buffer];
+    int stride = accessor.ByteStride(bufferView);
+    if (stride <= 0) {
+        err = "Invalid index stride";
+        return false;
+    }
+
+    const unsigned char* base = buffer.data.data() + bufferView.byteOffset + accessor.byteOffset;
+    out.resize(accessor.count);
+    for (size_t i = 0; i < accessor.count; ++i) {
+        const unsigned char* p = base + i * stride;
+        switch (accessor.componentType) {
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE: out[i] = p[0]; break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT: { uint16_t v; memcpy(&v, p, 2); out[i] = v; break; }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT: { uint32_t v; memcpy(&v, p, 4); out[i] = v; break; }
+            default:
+                err = "Unsupported index component type";
+                return false;
+        }
+    }
+    return true;
+}
+
+glm::mat4 localMatrix(const tinygltf::Node& node) {
+    if (node.matrix.size() == 16) {
+        glm::mat4 m;
+        for (int c = 0; c < 4; ++c)
+            for (int r = 0; r < 4; ++r)
+                m[c][r] = static_cast<float>(node.matrix[c * 4 + r]);
+        return m;
+    }
+
+    glm::mat4 m(1.0f);
+    if (node.translation.size() == 3) {
+        m = glm::translate(m, glm::vec3(node.translation[0], node.translation[1], node.translation[2]));
+    }
+    if (node.rotation.size() == 4) {
+        glm::quat q(static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]),
+                    static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]));
+        m = m * glm::mat4_cast(q);
+    }
+    if (node.scale.size() == 3) {
+        m = glm::scale(m, glm::vec3(node.scale[0], node.scale[1], node.scale[2]));
+    }
+    return m;
+}
+
+void flattenNode(const tinygltf::Model& model, int nodeIdx, const glm::mat4& parentMatrix, std::vector<CookedNode>& nodes) {
+    glm::mat4 world = parentMatrix * localMatrix(model.nodes[nodeIdx]);
+    for (int c = 0; c < 4; ++c)
+        for (int r = 0; r < 4; ++r)
+            nodes[nodeIdx].worldMatrix[c * 4 + r] = world[c][r];
+
+    for (int child : model.nodes[nodeIdx].children) {
+        flattenNode(model, child, world, nodes);
+    }
+}
+
+void convertToRGBA8(const tinygltf::Image& image, std::vector<uint8_t>& pixels) {
+    size_t pixelCount = static_cast<size_t>(image.width) * image.height;
+    pixels.assign(pixelCount * 4, 255);
+    int components = image.component;
+    if (components < 1 || components > 4 || image.bits != 8 || image.image.size() < pixelCount * components) {
+        return;
+    }
+
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const unsigned char* src = &image.image[i * components];
+        uint8_t* dst = &pixels[i * 4];
+        if (components <= 2) {
+            dst[0] = dst[1] = dst[2] = src[0];
+            if (components == 2) dst[3] = src[1];
+        } else {
+            dst[0] = src[0];
+            dst[1] = src[1];
+            dst[2] = src[2];
+            if (components == 4) dst[3] = src[3];
+        }
+    }
+}
+
+}
+
+bool CookGLTFModel(const tinygltf::Model& model, std::vector<uint8_t>& out, std::string& err, bool compressTextures) {
+    std::vector<CookedVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<CookedPrimitive> primitives;
+    std::vector<CookedNode> nodes(model.nodes.size());
+    std::vector<CookedMaterial> materials;
+    std::vector<CookedTexture> textures;
+    std::vector<CookedAnimation> animations;
+    std::vector<CookedAnimationChannel> channels;
+    std::vector<float> keyframes;
+    std::vector<uint8_t> pixels;
+
+    // Node hierarchy, flattened into world matrices
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        nodes[i] = CookedNode();
+        nodes[i].mesh = model.nodes[i].mesh;
+        nodes[i].parent = -1;
+    }
+    for (size_t i = 0; i < model.nodes.size(); ++i) {
+        for (int child : model.nodes[i].children) {
+            nodes[child].parent = static_cast<int32_t>(i);
+        }
+    }
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (nodes[i].parent < 0) {
+            flattenNode(model, static_cast<int>(i), glm::mat4(1.0f), nodes);
+        }
+    }
+
+    // Geometry, emitted in the same node order the renderers always drew in.
+    // A mesh referenced by several nodes is stored once and drawn per node.
+    std::map<std::pair<int, int>, std::pair<uint32_t, uint32_t>> cookedPrimitives;
+    std::vector<float> positions, uvs, normals;
+    std::vector<uint32_t> primitiveIndices;
+
+    for (size_t nodeIdx = 0; nodeIdx < model.nodes.size(); ++nodeIdx) {
+        int meshIdx = model.nodes[nodeIdx].mesh;
+        if (meshIdx < 0) continue;
+
+        const auto& mesh = model.meshes[meshIdx];
+        for (size_t primIdx = 0; primIdx < mesh.primitives.size(); ++primIdx) {
+            const auto& primitive = mesh.primitives[primIdx];
+            auto key = std::make_pair(meshIdx, static_cast<int>(primIdx));
+
+            auto cached = cookedPrimitives.find(key);
+            if (cached == cookedPrimitives.end()) {
+                if (primitive.mode != TINYGLTF_MODE_TRIANGLES) continue;
+
+                auto position = primitive.attributes.find("POSITION");
+                if (position == primitive.attributes.end()) continue;
+
+                if (!readAccessor(model, position->second, 3, positions, err)) return false;
+                size_t vertexCount = positions.size() / 3;
+
+                auto uv = primitive.attributes.find("TEXCOORD_0");
+                uvs.assign(vertexCount * 2, 0.0f);
+                if (uv != primitive.attributes.end() && !readAccessor(model, uv->second, 2, uvs, err)) return false;
+
+                auto normal = primitive.attributes.find("NORMAL");
+                normals.assign(vertexCount * 3, 0.0f);
+                if (normal != primitive.attributes.end() && !readAccessor(model, normal->second, 3, normals, err)) return false;
+
+                if (primitive.indices >= 0) {
+                    if (!readIndices(model, primitive.indices, primitiveIndices, err)) return false;
+                } else {
+                    primitiveIndices.resize(vertexCount);
+                    for (size_t i = 0; i < vertexCount; ++i) primitiveIndices[i] = static_cast<uint32_t>(i);
+                }
+
+                uint32_t baseVertex = static_cast<uint32_t>(vertices.size());
+                for (size_t i = 0; i < vertexCount; ++i) {
+                    CookedVertex v;
+                    memcpy(v.position, &positions[i * 3], sizeof(v.position));
+                    memcpy(v.uv, &uvs[i * 2], sizeof(v.uv));
+                    memcpy(v.normal, &normals[i * 3], sizeof(v.normal));
+                    vertices.push_back(v);
+                }
+
+                uint32_t firstIndex = static_cast<uint32_t>(indices.size());
+                for (uint32_t index : primitiveIndices) {
+                    if (index >= vertexCount) {
+                        err = "Index out of range in mesh " + mesh.name;
+                        return false;
+                    }
+                    indices.push_back(baseVertex + index);
+                }
+
+                cached = cookedPrimitives.emplace(key, std::make_pair(firstIndex, static_cast<uint32_t>(primitiveIndices.size()))).first;
+            }
+
+            CookedPrimitive cookedPrimitive;
+            cookedPrimitive.firstIndex = cached->second.first;
+            cookedPrimitive.indexCount = cached->second.second;
+            cookedPrimitive.material = primitive.material;
+            cookedPrimitive.node = static_cast<int32_t>(nodeIdx);
+            primitives.push_back(cookedPrimitive);
+        }
+    }
+
+    // Materials
+    for (const auto& material : model.materials) {
+        CookedMaterial cookedMaterial = {};
+        const auto& factor = material.pbrMetallicRoughness.baseColorFactor;
+        for (int c = 0; c < 4; ++c) {
+            cookedMaterial.baseColorFactor[c] = c < static_cast<int>(factor.size()) ? static_cast<float>(factor[c]) : 1.0f;
+        }
+        cookedMaterial.baseColorTexture = material.pbrMetallicRoughness.baseColorTexture.index;
+        cookedMaterial.normalTexture = material.normalTexture.index;
+        materials.push_back(cookedMaterial);
+    }
+
+    // Textures, cooked into mip-mapped containers so the runtime never touches
+    // an image codec. Normal maps are filtered as data, everything else as sRGB.
+    std::vector<bool> isNormalMap(model.textures.size(), false);
+    for (const auto& material : model.materials) {
+        int normalTexture = material.normalTexture.index;
+        if (normalTexture >= 0 && normalTexture < static_cast<int>(isNormalMap.size())) {
+            isNormalMap[normalTexture] = true;
+        }
+    }
+
+    std::vector<std::vector<uint8_t>> textureData(model.textures.size());
+    for (size_t i = 0; i < model.textures.size(); ++i) {
+        CookedTexture cookedTexture = {};
+        int source = model.textures[i].source;
+        if (source >= 0 && model.images[source].width > 0) {
+            const auto& image = model.images[source];
+            convertToRGBA8(image, pixels);
+            cookedTexture.width = image.width;
+            cookedTexture.height = image.height;
+        } else {
+            pixels.assign(4, 255);
+            cookedTexture.width = 1;
+            cookedTexture.height = 1;
+        }
+
+        if (!CookTexture(pixels.data(), cookedTexture.width, cookedTexture.height, !isNormalMap[i], compressTextures, textureData[i])) {
+            err = "Failed to cook texture " + std::to_string(i);
+            return false;
+        }
+        cookedTexture.dataSize = textureData[i].size();
+        textures.push_back(cookedTexture);
+    }
+
+    // Animations, kept as raw keyframes per channel
+    std::vector<std::pair<size_t, size_t>> keyframeRanges;
+    for (const auto& animation : model.animations) {
+        CookedAnimation cookedAnimation = {};
+        cookedAnimation.firstChannel = static_cast<uint32_t>(channels.size());
+
+        if (!animation.samplers.empty()) {
+            const auto& input = model.accessors[animation.samplers[0].input];
+            if (!input.maxValues.empty()) {
+                cookedAnimation.duration = static_cast<float>(input.maxValues[0]);
+            }
+        }
+
+        for (const auto& channel : animation.channels) {
+            CookedAnimationChannel cookedChannel = {};
+            if (channel.target_path == "translation") {
+                cookedChannel.path = COOKED_PATH_TRANSLATION;
+                cookedChannel.components = 3;
+            } else if (channel.target_path == "rotation") {
+                cookedChannel.path = COOKED_PATH_ROTATION;
+                cookedChannel.components = 4;
+            } else if (channel.target_path == "scale") {
+                cookedChannel.path = COOKED_PATH_SCALE;
+                cookedChannel.components = 3;
+            } else {
+                continue;
+            }
+
+            const auto& sampler = animation.samplers[channel.sampler];
+            std::vector<float> times, values;
+            if (!readAccessor(model, sampler.input, 1, times, err)) return false;
+            if (!readAccessor(model, sampler.output, cookedChannel.components, values, err)) return false;
+            if (times.empty() || values.size() < times.size() * cookedChannel.components) {
+                err = "Malformed animation sampler";
+                return false;
+            }
+
+            cookedChannel.node = channel.target_node;
+            cookedChannel.keyCount = static_cast<uint32_t>(times.size());
+            keyframeRanges.emplace_back(keyframes.size(), keyframes.size() + times.size());
+            keyframes.insert(keyframes.end(), times.begin(), times.end());
+            keyframes.insert(keyframes.end(), values.begin(), values.begin() + times.size() * cookedChannel.components);
+            channels.push_back(cookedChannel);
+
+            if (cookedAnimation.duration <= 0.0f) {
+                cookedAnimation.duration = glm::max(cookedAnimation.duration, times.back());
+            }
+        }
+
+        cookedAnimation.channelCount = static_cast<uint32_t>(channels.size()) - cookedAnimation.firstChannel;
+        animations.push_back(cookedAnimation);
+    }
+
+    // Serialise
+    CookedMeshHeader header = {};
+    header.magic = COOKED_MESH_MAGIC;
+    header.version = COOKED_MESH_VERSION;
+    header.vertexCount = static_cast<uint32_t>(vertices.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+    header.primitiveCount = static_cast<uint32_t>(primitives.size());
+    header.nodeCount = static_cast<uint32_t>(nodes.size());
+    header.materialCount = static_cast<uint32_t>(materials.size());
+    header.textureCount = static_cast<uint32_t>(textures.size());
+    header.animationCount = static_cast<uint32_t>(animations.size());
+    header.channelCount = static_cast<uint32_t>(channels.size());
+
+    out.clear();
+    out.resize(sizeof(CookedMeshHeader), 0);
+    header.vertexOffset = appendSection(out, vertices);
+    header.indexOffset = appendSection(out, indices);
+    header.primitiveOffset = appendSection(out, primitives);
+    header.nodeOffset = appendSection(out, nodes);
+    header.materialOffset = appendSection(out, materials);
+
+    uint64_t keyframeOffset = appendSection(out, keyframes);
+    for (size_t i = 0; i < channels.size(); ++i) {
+        channels[i].timesOffset = keyframeOffset + keyframeRanges[i].first * sizeof(float);
+        channels[i].valuesOffset = keyframeOffset + keyframeRanges[i].second * sizeof(float);
+    }
+    header.animationOffset = appendSection(out, animations);
+    header.channelOffset = appendSection(out, channels);
+
+    for (size_t i = 0; i < textures.size(); ++i) {
+        textures[i].dataOffset = appendSection(out, textureData[i]);
+    }
+    header.textureOffset = appendSection(out, textures);
+
+    header.fileSize = out.size();
+    memcpy(out.data(), &header, sizeof(header));
+    return true;
+}
+
+bool WriteCookedFile(const std::string& path, const std::vector<uint8_t>& data) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    return file.good();
+}
+
+std::string CookedMeshPath(const std::string& gltfPath) {
+    size_t dot = gltfPath.find_last_of('.');
+    size_t slash = gltfPath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return gltfPath + COOKED_MESH_EXTENSION;
+    }
+    return gltfPath.substr(0, dot) + COOKED_MESH_EXTENSION;
+}
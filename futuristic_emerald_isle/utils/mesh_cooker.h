@@ -0,0 +1,20 @@
+#ifndef MESH_COOKER_H
+#define MESH_COOKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <tiny_gltf.h>
+
+// Flattens a parsed glTF model into the cooked mesh layout described in
+// cooked_mesh_format.h. Used offline by asset_cook, and at runtime as the
+// fallback when no cooked file sits next to the .gltf. Textures get a full
+// mip chain, block compressed when compressTextures is set.
+bool CookGLTFModel(const tinygltf::Model& model, std::vector<uint8_t>& out, std::string& err, bool compressTextures = true);
+
+bool WriteCookedFile(const std::string& path, const std::vector<uint8_t>& data);
+
+// "dir/scene.gltf" -> "dir/scene.feim"
+std::string CookedMeshPath(const std::string& gltfPath);
+
+#endif // MESH_COOKER_H
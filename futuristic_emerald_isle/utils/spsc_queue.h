@@ -0,0 +1,45 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free queue for exactly one producer thread and one consumer
+// thread. Capacity must be a power of two; push() fails when full and pop()
+// when empty, neither ever blocks.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+
+    bool push(const T& value) {
+        size_t back = tail.load(std::memory_order_relaxed);
+        if (back - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[back & (Capacity - 1)] = value;
+        tail.store(back + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) {
+        size_t front = head.load(std::memory_order_relaxed);
+        if (front == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = items[front & (Capacity - 1)];
+        head.store(front + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    T items[Capacity];
+
+    // On their own cache lines so the two threads do not share one
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,63 @@
+#include "startup_timeline.h"
+#include <algorithm>
+#include <iomanip>
+#include "job_system.h"
+
+namespace {
+
+const int BAR_WIDTH = 40;
+
+}
+
+StartupTimeline::StartupTimeline() : origin(std::chrono::steady_clock::now()) {}
+
+void StartupTimeline::measure(const std::string& name, const std::function<void()>& work) {
+    Span span;
+    span.name = name;
+    span.worker = JobSystem::currentWorkerIndex();
+    span.start = elapsed();
+    work();
+    span.end = elapsed();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    spans.push_back(span);
+}
+
+double StartupTimeline::elapsed() const {
+    return MillisecondsSince(origin);
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void StartupTimeline::report(std::ostream& out) const {
+    std::vector<Span> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        sorted = spans;
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const Span& a, const Span& b) { return a.start < b.start; });
+
+    double total = elapsed();
+    double serial = 0.0;
+    for (const Span& span : sorted) {
+        serial += span.end - span.start;
+    }
+
+    // One row per step with a bar placing it in the whole startup
+    out << "Startup timeline, " << std::fixed << std::setprecision(1) << total << " ms:" << std::endl;
+    for (const Span& span : sorted) {
+        int first = static_cast<int>(span.start / total * BAR_WIDTH);
+        int last = std::max(first + 1, static_cast<int>(span.end / total * BAR_WIDTH + 0.5));
+        std::string bar(BAR_WIDTH, ' ');
+        for (int i = first; i < std::min(last, BAR_WIDTH); ++i) {
+            bar[i] = '#';
+        }
+
+        std::string thread = span.worker >= 0 ? "worker " + std::to_string(span.worker) : "main";
+        out << "  " << std::setw(8) << span.start << std::setw(9) << span.end - span.start << " ms  " << std::left
+            << std::setw(10) << thread << std::right << "|" << bar << "| " << span.name << std::endl;
+    }
+    out << "  steps add up to " << serial << " ms" << std::endl;
+}
@@ -0,0 +1,39 @@
+#ifndef STARTUP_TIMELINE_H
+#define STARTUP_TIMELINE_H
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Wall-clock spans of named startup steps, recorded from any thread, and a
+// report of what ran when and where. Times are milliseconds since construction.
+class StartupTimeline {
+public:
+    StartupTimeline();
+
+    // Runs work and records its span under name
+    void measure(const std::string& name, const std::function<void()>& work);
+    double elapsed() const;
+
+    void report(std::ostream& out) const;
+
+private:
+    struct Span {
+        std::string name;
+        double start;
+        double end;
+        int worker;                 // -1 outside the job system
+    };
+
+    std::chrono::steady_clock::time_point origin;
+    mutable std::mutex mutex;
+    std::vector<Span> spans;
+};
+
+// Wall-clock milliseconds from start to now, for timing phases outside a timeline
+double MillisecondsSince(std::chrono::steady_clock::time_point start);
+
+#endif // STARTUP_TIMELINE_H
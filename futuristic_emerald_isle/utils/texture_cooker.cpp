@@ -0,0 +1,143 @@
+#include "texture_cooker.h"
+#include "block_compression.h"
+#include "cooked_texture_format.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+uint8_t toByte(float v) {
+    return static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, v * 255.0f + 0.5f)));
+}
+
+// Box filter to half size. Colour is averaged in linear light and weighted by
+// alpha, so cut-out foliage does not pick up dark fringes from transparent texels.
+void downsample(const std::vector<float>& src, int width, int height, std::vector<float>& dst, int& dstWidth, int& dstHeight) {
+    dstWidth = std::max(1, width / 2);
+    dstHeight = std::max(1, height / 2);
+    dst.assign(static_cast<size_t>(dstWidth) * dstHeight * 4, 0.0f);
+
+    for (int y = 0; y < dstHeight; ++y) {
+        for (int x = 0; x < dstWidth; ++x) {
+            float sum[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+            for (int dy = 0; dy < 2; ++dy) {
+                int sy = std::min(y * 2 + dy, height - 1);
+                for (int dx = 0; dx < 2; ++dx) {
+                    int sx = std::min(x * 2 + dx, width - 1);
+                    const float* p = &src[(static_cast<size_t>(sy) * width + sx) * 4];
+                    sum[0] += p[0] * p[3];
+                    sum[1] += p[1] * p[3];
+                    sum[2] += p[2] * p[3];
+                    sum[3] += p[3];
+                }
+            }
+
+            float* q = &dst[(static_cast<size_t>(y) * dstWidth + x) * 4];
+            float weight = sum[3] > 0.0f ? 1.0f / sum[3] : 0.0f;
+            q[0] = sum[0] * weight;
+            q[1] = sum[1] * weight;
+            q[2] = sum[2] * weight;
+            q[3] = sum[3] / 4.0f;
+        }
+    }
+}
+
+}
+
+bool CookTexture(const uint8_t* rgba, int width, int height, bool srgb, bool compress, std::vector<uint8_t>& out) {
+    if (!rgba || width <= 0 || height <= 0) {
+        return false;
+    }
+
+    bool hasAlpha = false;
+    size_t pixelCount = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < pixelCount && !hasAlpha; ++i) {
+        hasAlpha = rgba[i * 4 + 3] != 255;
+    }
+
+    float toLinear[256];
+    for (int i = 0; i < 256; ++i) {
+        toLinear[i] = srgb ? srgbToLinear(i / 255.0f) : i / 255.0f;
+    }
+
+    std::vector<float> level(pixelCount * 4);
+    for (size_t i = 0; i < pixelCount; ++i) {
+        level[i * 4 + 0] = toLinear[rgba[i * 4 + 0]];
+        level[i * 4 + 1] = toLinear[rgba[i * 4 + 1]];
+        level[i * 4 + 2] = toLinear[rgba[i * 4 + 2]];
+        level[i * 4 + 3] = rgba[i * 4 + 3] / 255.0f;
+    }
+
+    CookedTextureHeader header = {};
+    header.magic = COOKED_TEXTURE_MAGIC;
+    header.version = COOKED_TEXTURE_VERSION;
+    header.format = !compress ? COOKED_TEXTURE_RGBA8 : (hasAlpha ? COOKED_TEXTURE_BC3 : COOKED_TEXTURE_BC1);
+    header.flags = (srgb ? COOKED_TEXTURE_SRGB : 0u) | (hasAlpha ? COOKED_TEXTURE_HAS_ALPHA : 0u);
+    header.width = width;
+    header.height = height;
+
+    CookedTextureLevel levels[COOKED_TEXTURE_MAX_LEVELS] = {};
+    std::vector<uint8_t> payload;
+    std::vector<uint8_t> pixels, blocks;
+    std::vector<float> next;
+    int levelWidth = width, levelHeight = height;
+
+    while (header.levelCount < COOKED_TEXTURE_MAX_LEVELS) {
+        size_t levelPixels = static_cast<size_t>(levelWidth) * levelHeight;
+        pixels.resize(levelPixels * 4);
+        for (size_t i = 0; i < levelPixels; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                float c = level[i * 4 + k];
+                pixels[i * 4 + k] = toByte(srgb ? linearToSrgb(c) : c);
+            }
+            pixels[i * 4 + 3] = toByte(level[i * 4 + 3]);
+        }
+
+        const std::vector<uint8_t>* data = &pixels;
+        if (header.format != COOKED_TEXTURE_RGBA8) {
+            CompressImage(pixels.data(), levelWidth, levelHeight, hasAlpha, blocks);
+            data = &blocks;
+        }
+
+        CookedTextureLevel& entry = levels[header.levelCount++];
+        entry.offset = payload.size();
+        entry.size = data->size();
+        entry.width = levelWidth;
+        entry.height = levelHeight;
+        payload.insert(payload.end(), data->begin(), data->end());
+        payload.resize((payload.size() + 15) & ~static_cast<size_t>(15), 0);
+
+        if (levelWidth == 1 && levelHeight == 1) break;
+        downsample(level, levelWidth, levelHeight, next, levelWidth, levelHeight);
+        level.swap(next);
+    }
+
+    size_t dataStart = sizeof(CookedTextureHeader) + header.levelCount * sizeof(CookedTextureLevel);
+    for (uint32_t i = 0; i < header.levelCount; ++i) {
+        levels[i].offset += dataStart;
+    }
+
+    out.resize(dataStart);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + sizeof(header), levels, header.levelCount * sizeof(CookedTextureLevel));
+    out.insert(out.end(), payload.begin(), payload.end());
+    return true;
+}
+
+std::string CookedTexturePath(const std::string& imagePath) {
+    size_t dot = imagePath.find_last_of('.');
+    size_t slash = imagePath.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+        return imagePath + COOKED_TEXTURE_EXTENSION;
+    }
+    return imagePath.substr(0, dot) + COOKED_TEXTURE_EXTENSION;
+}
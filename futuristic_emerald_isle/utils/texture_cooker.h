@@ -0,0 +1,17 @@
+#ifndef TEXTURE_COOKER_H
+#define TEXTURE_COOKER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Builds a .fetx container (see cooked_texture_format.h) from RGBA8 pixels.
+// Colour textures are mip filtered in linear light; pass srgb = false for
+// data textures such as normal maps. With compress = true the chain is
+// stored as BC1, or BC3 when any pixel is not fully opaque.
+bool CookTexture(const uint8_t* rgba, int width, int height, bool srgb, bool compress, std::vector<uint8_t>& out);
+
+// "dir/facade0.jpg" -> "dir/facade0.fetx"
+std::string CookedTexturePath(const std::string& imagePath);
+
+#endif // TEXTURE_COOKER_H
@@ -0,0 +1,53 @@
+#include "update_scheduler.h"
+
+UpdateScheduler::UpdateScheduler() :
+    nearDistance(200.0f),
+    midDistance(600.0f),
+    midInterval(4),
+    maxUpdatesPerFrame(512),
+    frame(0),
+    frameDelta(0.0),
+    updatesThisFrame(0) {}
+
+void UpdateScheduler::resize(size_t count) {
+    size_t previous = pendingTime.size();
+    pendingTime.resize(count, 0.0);
+    lastUpdateFrame.resize(count);
+
+    // Spread the first mid-range updates over the interval
+    size_t interval = midInterval > 1 ? midInterval : 1;
+    for (size_t i = previous; i < count; ++i) {
+        lastUpdateFrame[i] = frame - static_cast<uint32_t>(i % interval);
+    }
+}
+
+void UpdateScheduler::beginFrame(double deltaTime) {
+    frame++;
+    frameDelta = deltaTime;
+    updatesThisFrame = 0;
+}
+
+UpdateScheduler::Tier UpdateScheduler::schedule(size_t index, float distance, double& updateTime) {
+    if (distance > midDistance) {
+        pendingTime[index] = 0.0;
+        lastUpdateFrame[index] = frame;
+        updateTime = frameDelta;
+        return TIER_FAR;
+    }
+
+    pendingTime[index] += frameDelta;
+
+    Tier tier = distance <= nearDistance ? TIER_NEAR : TIER_MID;
+    bool due = tier == TIER_NEAR ||
+               (frame - lastUpdateFrame[index] >= static_cast<uint32_t>(midInterval) && updatesThisFrame < maxUpdatesPerFrame);
+    if (!due) {
+        updateTime = 0.0;
+        return tier;
+    }
+
+    updateTime = pendingTime[index];
+    pendingTime[index] = 0.0;
+    lastUpdateFrame[index] = frame;
+    updatesThisFrame++;
+    return tier;
+}
@@ -0,0 +1,50 @@
+#ifndef UPDATE_SCHEDULER_H
+#define UPDATE_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Spends per-entity update work by distance to the camera. Near entities
+// get a full update every frame. Mid-range ones get one every midInterval
+// frames, staggered by index, with the skipped time handed over in one go.
+// Far ones only get the cheap part of their update. Mid-range updates stop
+// for the frame once maxUpdatesPerFrame full updates have run; they stay
+// due for the next one. A frame is whatever the owner calls beginFrame()
+// for, Traffic uses its fixed steps.
+class UpdateScheduler {
+public:
+    enum Tier {
+        TIER_NEAR,
+        TIER_MID,
+        TIER_FAR
+    };
+
+    UpdateScheduler();
+
+    void resize(size_t count);
+    void beginFrame(double deltaTime);
+
+    // Classifies the entity for this frame. Call it for every entity in the
+    // same order each frame, the budget goes to whoever asks first.
+    // updateTime is the time to simulate now: for TIER_FAR that is always
+    // this frame's delta for the cheap part, otherwise the accumulated time
+    // for a full update, or 0 when the entity is skipped this frame.
+    Tier schedule(size_t index, float distance, double& updateTime);
+
+    float nearDistance;
+    float midDistance;
+    int midInterval;
+    int maxUpdatesPerFrame;
+
+    int getUpdatesThisFrame() const { return updatesThisFrame; }
+
+private:
+    std::vector<double> pendingTime;
+    std::vector<uint32_t> lastUpdateFrame;
+    uint32_t frame;
+    double frameDelta;
+    int updatesThisFrame;
+};
+
+#endif // UPDATE_SCHEDULER_H
@@ -0,0 +1,149 @@
+#include "vfs.h"
+#include <iostream>
+#include <climits>
+#include <memory>
+#include <tinygltf-2.9.3/stb_image.h>
+#include "async_loader.h"
+#include "asset_pack_format.h"
+
+VirtualFileSystem vfs;
+
+VfsFile::VfsFile() : bytes(nullptr), length(0) {}
+
+bool VirtualFileSystem::mount(const std::string& packPath) {
+    std::unique_ptr<Pack> pack(new Pack());
+    if (!pack->file.open(packPath)) {
+        return false;
+    }
+
+    const uint8_t* data = pack->file.data();
+    size_t size = pack->file.size();
+    if (size < sizeof(AssetPackHeader)) {
+        std::cerr << "Asset pack is truncated: " << packPath << std::endl;
+        return false;
+    }
+
+    const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(data);
+    if (header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION || header->fileSize != size ||
+        header->tocOffset > size || header->entryCount > (size - header->tocOffset) / sizeof(AssetPackEntry) ||
+        header->namesOffset > size || header->namesSize > size - header->namesOffset) {
+        std::cerr << "Asset pack has a stale or unknown format, re-run asset_pack: " << packPath << std::endl;
+        return false;
+    }
+
+    const AssetPackEntry* entries = reinterpret_cast<const AssetPackEntry*>(data + header->tocOffset);
+    const char* names = reinterpret_cast<const char*>(data + header->namesOffset);
+    for (uint32_t i = 0; i < header->entryCount; ++i) {
+        const AssetPackEntry& entry = entries[i];
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header->namesSize ||
+            entry.offset > size || entry.size > size - entry.offset) {
+            std::cerr << "Asset pack entry " << i << " is out of range: " << packPath << std::endl;
+            return false;
+        }
+        pack->entries[std::string(names + entry.nameOffset, entry.nameLength)] = i;
+    }
+
+    std::cout << "Mounted " << packPath << " (" << header->entryCount << " entries)" << std::endl;
+    packs.push_back(std::move(pack));
+    return true;
+}
+
+void VirtualFileSystem::unmount() {
+    packs.clear();
+}
+
+bool VirtualFileSystem::find(const std::string& path, const Pack*& pack, uint32_t& entry) const {
+    if (packs.empty()) {
+        return false;
+    }
+
+    std::string name = AssetPackName(path);
+    for (auto it = packs.rbegin(); it != packs.rend(); ++it) {
+        auto found = (*it)->entries.find(name);
+        if (found != (*it)->entries.end()) {
+            pack = it->get();
+            entry = found->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VirtualFileSystem::exists(const std::string& path) const {
+    const Pack* pack;
+    uint32_t entry;
+    if (find(path, pack, entry)) {
+        return true;
+    }
+
+    MappedFile file;
+    return file.open(path);
+}
+
+bool VirtualFileSystem::open(const std::string& path, VfsFile& file) const {
+    const Pack* pack;
+    uint32_t index;
+    if (!find(path, pack, index)) {
+        // Loose file, for development without a pack
+        if (!file.mapping.open(path)) {
+            return false;
+        }
+        file.bytes = file.mapping.data();
+        file.length = file.mapping.size();
+        return true;
+    }
+
+    const uint8_t* data = pack->file.data();
+    const AssetPackHeader* header = reinterpret_cast<const AssetPackHeader*>(data);
+    const AssetPackEntry& entry = reinterpret_cast<const AssetPackEntry*>(data + header->tocOffset)[index];
+
+    if (!(entry.flags & ASSET_PACK_COMPRESSED)) {
+        file.bytes = data + entry.offset;
+        file.length = entry.size;
+        return true;
+    }
+
+    if (entry.size > INT_MAX || entry.rawSize > INT_MAX) {
+        return false;
+    }
+
+    file.buffer.resize(entry.rawSize);
+    int inflated = stbi_zlib_decode_buffer(reinterpret_cast<char*>(file.buffer.data()), static_cast<int>(entry.rawSize),
+                                           reinterpret_cast<const char*>(data + entry.offset), static_cast<int>(entry.size));
+    if (inflated != static_cast<int>(entry.rawSize)) {
+        std::cerr << "Failed to inflate " << path << std::endl;
+        file.buffer.clear();
+        return false;
+    }
+
+    file.bytes = file.buffer.data();
+    file.length = file.buffer.size();
+    return true;
+}
+
+bool VirtualFileSystem::read(const std::string& path, std::vector<uint8_t>& out) const {
+    VfsFile file;
+    if (!open(path, file)) {
+        return false;
+    }
+
+    if (!file.buffer.empty()) {
+        out.swap(file.buffer);
+    } else {
+        out.assign(file.data(), file.data() + file.size());
+    }
+    return true;
+}
+
+void VirtualFileSystem::readAsync(const std::string& path, AsyncLoader& loader, std::function<void(std::vector<uint8_t>& data)> done) const {
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    loader.submit(
+        [this, path, data] {
+            if (!read(path, *data)) {
+                data->clear();
+            }
+        },
+        [data, done] {
+            if (done) done(*data);
+        });
+}
@@ -0,0 +1,67 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "mapped_file.h"
+
+class AsyncLoader;
+
+// Contents of one file opened through the VFS. Stored pack entries point
+// straight into the pack mapping, compressed ones are inflated into a
+// private buffer and loose files keep their own mapping.
+class VfsFile {
+public:
+    VfsFile();
+
+    VfsFile(const VfsFile&) = delete;
+    VfsFile& operator=(const VfsFile&) = delete;
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    friend class VirtualFileSystem;
+
+    const uint8_t* bytes;
+    size_t length;
+    std::vector<uint8_t> buffer;
+    MappedFile mapping;
+};
+
+// Every asset load goes through here. Paths are the ones the loaders have
+// always used ("../futuristic_emerald_isle/assets/..."); they resolve
+// against the mounted packs first, newest mount wins, and fall back to the
+// loose file on disk so development works without repacking.
+class VirtualFileSystem {
+public:
+    bool mount(const std::string& packPath);
+    void unmount();
+
+    bool exists(const std::string& path) const;
+    bool open(const std::string& path, VfsFile& file) const;
+    bool read(const std::string& path, std::vector<uint8_t>& out) const;
+
+    // Reads on a loader worker and hands the bytes over on the GL thread.
+    // data is empty when the file could not be read.
+    void readAsync(const std::string& path, AsyncLoader& loader, std::function<void(std::vector<uint8_t>& data)> done) const;
+
+private:
+    struct Pack {
+        MappedFile file;
+        std::unordered_map<std::string, uint32_t> entries;
+    };
+
+    bool find(const std::string& path, const Pack*& pack, uint32_t& entry) const;
+
+    std::vector<std::unique_ptr<Pack>> packs;
+};
+
+extern VirtualFileSystem vfs;
+
+#endif // VFS_H